@@ -74,6 +74,13 @@ let package = Package(
         .headerSearchPath(".")
       ]
     ),
+    .testTarget(
+      name: "GoogleMapsUtilsBenchmarks",
+      dependencies: [
+        "GoogleMapsUtilsObjC",
+      ],
+      path: "Tests/GoogleMapsUtilsBenchmarks"
+    ),
     .testTarget(
       name: "GoogleMapsUtilsSwiftTests",
       dependencies: [
@@ -0,0 +1,65 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUClusterAlgorithm.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Wraps another clustering algorithm and remembers the clusters it returns at each integral zoom
+ * level, so that going back to a zoom level visited before does not cluster the items again.
+ * Adding, removing or clearing items forgets every remembered zoom level, since every item belongs
+ * to a cluster at every zoom level. Clusters at non-integral zoom levels are not remembered.
+ * When the wrapped algorithm clusters by bounds, the clusters of a zoom level are remembered along
+ * with their bounds and reused for any bounds within them, keeping those positioned within the
+ * requested bounds. Once the remembered zoom levels hold more than maxCachedClusterCount clusters,
+ * the least recently used ones are forgotten.
+ */
+@interface GMUCachingClusterAlgorithm : NSObject<GMUClusterAlgorithm>
+
+/**
+ * The default initializer is not available. Use initWithAlgorithm: instead.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns a new instance of the GMUCachingClusterAlgorithm class wrapping |algorithm|, which
+ * remembers up to 100000 clusters.
+ */
+- (instancetype)initWithAlgorithm:(id<GMUClusterAlgorithm>)algorithm;
+
+/**
+ * Returns a new instance of the GMUCachingClusterAlgorithm class wrapping |algorithm|, which
+ * remembers up to |maxCachedClusterCount| clusters across zoom levels. Clusters of a zoom level
+ * which alone exceed the bound are not remembered.
+ */
+- (instancetype)initWithAlgorithm:(id<GMUClusterAlgorithm>)algorithm
+            maxCachedClusterCount:(NSUInteger)maxCachedClusterCount NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Returns the wrapped algorithm. Items should only be changed through this object.
+ */
+@property(nonatomic, readonly) id<GMUClusterAlgorithm> algorithm;
+
+/**
+ * Returns the number of clusters currently remembered.
+ */
+@property(nonatomic, readonly) NSUInteger cachedClusterCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,287 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUCachingClusterAlgorithm.h"
+
+#import <GoogleMaps/GMSGeometryUtils.h>
+
+#import "GMUMapPointBounds.h"
+
+static const NSUInteger kGMUDefaultMaxCachedClusterCount = 100000;
+
+// Returns whether |outer| contains |inner|.
+static BOOL GMUBoundsContainBounds(GQTBounds outer, GQTBounds inner) {
+  return inner.minX >= outer.minX && inner.maxX <= outer.maxX && inner.minY >= outer.minY &&
+         inner.maxY <= outer.maxY;
+}
+
+static BOOL GMUBoundsEqualBounds(GQTBounds bounds1, GQTBounds bounds2) {
+  return bounds1.minX == bounds2.minX && bounds1.minY == bounds2.minY &&
+         bounds1.maxX == bounds2.maxX && bounds1.maxY == bounds2.maxY;
+}
+
+#pragma mark Utilities Classes
+
+// The clusters of one zoom level, covering either the whole world or |bounds|.
+@interface GMUCachedClusters : NSObject
+
+@property(nonatomic, readonly) NSArray<id<GMUCluster>> *clusters;
+@property(nonatomic, readonly) BOOL coversWorld;
+@property(nonatomic, readonly) GQTBounds bounds;
+
+- (instancetype)initWithClusters:(NSArray<id<GMUCluster>> *)clusters
+                     coversWorld:(BOOL)coversWorld
+                          bounds:(GQTBounds)bounds;
+
+@end
+
+@implementation GMUCachedClusters
+
+- (instancetype)initWithClusters:(NSArray<id<GMUCluster>> *)clusters
+                     coversWorld:(BOOL)coversWorld
+                          bounds:(GQTBounds)bounds {
+  if ((self = [super init])) {
+    _clusters = [clusters copy];
+    _coversWorld = coversWorld;
+    _bounds = bounds;
+  }
+  return self;
+}
+
+@end
+
+#pragma mark GMUCachingClusterAlgorithm
+
+@implementation GMUCachingClusterAlgorithm {
+  NSUInteger _maxCachedClusterCount;
+  NSMutableDictionary<NSNumber *, GMUCachedClusters *> *_cachedClustersByZoom;
+  // Cached zoom levels from least to most recently used.
+  NSMutableArray<NSNumber *> *_cachedZooms;
+}
+
+- (instancetype)initWithAlgorithm:(id<GMUClusterAlgorithm>)algorithm {
+  return [self initWithAlgorithm:algorithm maxCachedClusterCount:kGMUDefaultMaxCachedClusterCount];
+}
+
+- (instancetype)initWithAlgorithm:(id<GMUClusterAlgorithm>)algorithm
+            maxCachedClusterCount:(NSUInteger)maxCachedClusterCount {
+  if ((self = [super init])) {
+    _algorithm = algorithm;
+    _maxCachedClusterCount = maxCachedClusterCount;
+    _cachedClustersByZoom = [[NSMutableDictionary alloc] init];
+    _cachedZooms = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (void)addItems:(NSArray<id<GMUClusterItem>> *)items {
+  [_algorithm addItems:items];
+  [self removeAllCachedClusters];
+}
+
+/**
+ * Adds packed items to the wrapped algorithm, or items made of them if it does not take packed
+ * items.
+ */
+- (void)addItemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+                    identifiers:(const int64_t *)identifiers
+                          count:(NSUInteger)count {
+  if ([_algorithm respondsToSelector:@selector(addItemsWithCoordinates:identifiers:count:)]) {
+    [_algorithm addItemsWithCoordinates:coordinates identifiers:identifiers count:count];
+  } else {
+    [_algorithm addItems:[GMUPackedClusterItem itemsWithCoordinates:coordinates
+                                                        identifiers:identifiers
+                                                              count:count]];
+  }
+  [self removeAllCachedClusters];
+}
+
+/**
+ * Removes an item.
+ */
+- (void)removeItem:(id<GMUClusterItem>)item {
+  [_algorithm removeItem:item];
+  [self removeAllCachedClusters];
+}
+
+/**
+ * Clears all items.
+ */
+- (void)clearItems {
+  [_algorithm clearItems];
+  [self removeAllCachedClusters];
+}
+
+/**
+ * Returns the set of clusters of the added items.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom {
+  if (zoom != floorf(zoom)) return [_algorithm clustersAtZoom:zoom];
+
+  GMUCachedClusters *cachedClusters = [self cachedClustersAtZoom:zoom];
+  if (cachedClusters.coversWorld) return cachedClusters.clusters;
+
+  NSArray<id<GMUCluster>> *clusters = [_algorithm clustersAtZoom:zoom];
+  GQTBounds world = {-1, -1, 1, 1};
+  [self cacheClusters:[[GMUCachedClusters alloc] initWithClusters:clusters
+                                                      coversWorld:YES
+                                                           bounds:world]
+               atZoom:zoom];
+  return clusters;
+}
+
+/**
+ * Returns the clusters within |bounds| from the wrapped algorithm if it clusters by bounds, or all
+ * clusters otherwise.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom inBounds:(GQTBounds)bounds {
+  if (![_algorithm respondsToSelector:@selector(clustersAtZoom:inBounds:)]) {
+    return [self clustersAtZoom:zoom];
+  }
+  if (zoom != floorf(zoom)) return [_algorithm clustersAtZoom:zoom inBounds:bounds];
+
+  NSArray<id<GMUCluster>> *cachedClusters = [self cachedClustersAtZoom:zoom coveringBounds:bounds];
+  if (cachedClusters) return cachedClusters;
+
+  NSArray<id<GMUCluster>> *clusters = [_algorithm clustersAtZoom:zoom inBounds:bounds];
+  [self cacheClusters:[[GMUCachedClusters alloc] initWithClusters:clusters
+                                                      coversWorld:NO
+                                                           bounds:bounds]
+               atZoom:zoom];
+  return clusters;
+}
+
+/**
+ * Returns the clusters of clustersAtZoom:inBounds:, or nil if |token| is cancelled before the
+ * wrapped algorithm completes them. Nothing is cached for a cancelled call.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom
+                                   inBounds:(GQTBounds)bounds
+                          cancellationToken:(GMUClusterCancellationToken *)token {
+  SEL selector = @selector(clustersAtZoom:inBounds:cancellationToken:);
+  if (![_algorithm respondsToSelector:selector]) {
+    return [self clustersAtZoom:zoom inBounds:bounds];
+  }
+  if (zoom != floorf(zoom)) {
+    return [_algorithm clustersAtZoom:zoom inBounds:bounds cancellationToken:token];
+  }
+
+  NSArray<id<GMUCluster>> *cachedClusters = [self cachedClustersAtZoom:zoom coveringBounds:bounds];
+  if (cachedClusters) return cachedClusters;
+
+  NSArray<id<GMUCluster>> *clusters = [_algorithm clustersAtZoom:zoom
+                                                        inBounds:bounds
+                                               cancellationToken:token];
+  if (!clusters) return nil;
+  [self cacheClusters:[[GMUCachedClusters alloc] initWithClusters:clusters
+                                                      coversWorld:NO
+                                                           bounds:bounds]
+               atZoom:zoom];
+  return clusters;
+}
+
+/**
+ * Returns whether the wrapped algorithm returns exact clusters within bounds, which remain exact
+ * when filtered from the clusters of enclosing bounds.
+ */
+- (BOOL)clustersInBoundsAreExact {
+  if (![_algorithm respondsToSelector:@selector(clustersInBoundsAreExact)]) return NO;
+  return _algorithm.clustersInBoundsAreExact;
+}
+
+/**
+ * Returns the aggregates of the wrapped algorithm, or none if it does not compute aggregates.
+ */
+- (NSArray<GMUClusterAggregate *> *)aggregates {
+  if (![_algorithm respondsToSelector:@selector(aggregates)]) return @[];
+  return _algorithm.aggregates;
+}
+
+/**
+ * Sets the aggregates of the wrapped algorithm if it computes aggregates, and forgets the clusters
+ * cached without them.
+ */
+- (void)setAggregates:(NSArray<GMUClusterAggregate *> *)aggregates {
+  if (![_algorithm respondsToSelector:@selector(setAggregates:)]) return;
+  _algorithm.aggregates = aggregates;
+  [self removeAllCachedClusters];
+}
+
+#pragma mark Private
+
+// Returns the clusters cached at |zoom|, if any, and marks them as the most recently used.
+- (GMUCachedClusters *)cachedClustersAtZoom:(float)zoom {
+  NSNumber *key = @(zoom);
+  GMUCachedClusters *cachedClusters = _cachedClustersByZoom[key];
+  if (cachedClusters) {
+    [_cachedZooms removeObject:key];
+    [_cachedZooms addObject:key];
+  }
+  return cachedClusters;
+}
+
+// Returns the clusters cached at |zoom| whose position is within |bounds|, or nil unless the cached
+// clusters cover |bounds|. Clusters cached for exactly |bounds| are returned as they are.
+- (NSArray<id<GMUCluster>> *)cachedClustersAtZoom:(float)zoom coveringBounds:(GQTBounds)bounds {
+  GMUCachedClusters *cachedClusters = [self cachedClustersAtZoom:zoom];
+  if (!cachedClusters) return nil;
+  if (!cachedClusters.coversWorld) {
+    if (GMUBoundsEqualBounds(cachedClusters.bounds, bounds)) return cachedClusters.clusters;
+    if (!GMUBoundsContainBounds(cachedClusters.bounds, bounds)) return nil;
+  }
+  NSMutableArray<id<GMUCluster>> *clusters = [[NSMutableArray alloc] init];
+  for (id<GMUCluster> cluster in cachedClusters.clusters) {
+    if (GMUBoundsContainPoint(bounds, GMSProject(cluster.position))) {
+      [clusters addObject:cluster];
+    }
+  }
+  return clusters;
+}
+
+// Caches |cachedClusters| at |zoom| in place of any clusters cached there before, then forgets the
+// least recently used zoom levels until the cache is within bounds.
+- (void)cacheClusters:(GMUCachedClusters *)cachedClusters atZoom:(float)zoom {
+  NSNumber *key = @(zoom);
+  [self removeCachedClustersForKey:key];
+  if (cachedClusters.clusters.count > _maxCachedClusterCount) return;
+
+  _cachedClustersByZoom[key] = cachedClusters;
+  [_cachedZooms addObject:key];
+  _cachedClusterCount += cachedClusters.clusters.count;
+  while (_cachedClusterCount > _maxCachedClusterCount) {
+    [self removeCachedClustersForKey:_cachedZooms[0]];
+  }
+}
+
+- (void)removeCachedClustersForKey:(NSNumber *)key {
+  GMUCachedClusters *cachedClusters = _cachedClustersByZoom[key];
+  if (!cachedClusters) return;
+
+  _cachedClusterCount -= cachedClusters.clusters.count;
+  [_cachedClustersByZoom removeObjectForKey:key];
+  [_cachedZooms removeObject:key];
+}
+
+- (void)removeAllCachedClusters {
+  [_cachedClustersByZoom removeAllObjects];
+  [_cachedZooms removeAllObjects];
+  _cachedClusterCount = 0;
+}
+
+@end
@@ -40,6 +40,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, readonly) NSArray<id<GMUClusterItem>> *items;
 
+@optional
+
+/**
+ * Returns the clusterCategory shared by the items in the cluster, or nil for items without one.
+ */
+@property(nonatomic, readonly, copy, nullable) NSString *clusterCategory;
+
+/**
+ * Returns the values of the GMUClusterAggregates of the algorithm over the items in the cluster,
+ * keyed by aggregate name. They are computed while clustering, so reading them does not go through
+ * the items.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *aggregateValues;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,83 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUClusterItem.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The functions a GMUClusterAggregate computes over the values of the items of a cluster.
+ */
+typedef NS_ENUM(NSInteger, GMUClusterAggregateFunction) {
+  GMUClusterAggregateFunctionSum,
+  GMUClusterAggregateFunctionMin,
+  GMUClusterAggregateFunctionMax,
+  GMUClusterAggregateFunctionMean,
+};
+
+/**
+ * Returns the value of |item| for an aggregate, or NAN if it has none.
+ */
+typedef double (^GMUClusterAggregateValueBlock)(id<GMUClusterItem> item);
+
+/**
+ * Declares a value which clustering algorithms compute over the items of each cluster as they
+ * build it, such as the sum of a numeric attribute of the items. Clusters return it from
+ * aggregateValues under |name|, so it is read without going through their items. Items without a
+ * value are left out, and an aggregate over no values is missing from aggregateValues.
+ */
+@interface GMUClusterAggregate : NSObject
+
+/**
+ * The default initializer is not available. Use initWithName:function:keyPath: instead.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns an aggregate named |name| applying |function| to the NSNumber values at |keyPath| of the
+ * items. Items whose value is not an NSNumber have none.
+ */
+- (instancetype)initWithName:(NSString *)name
+                    function:(GMUClusterAggregateFunction)function
+                     keyPath:(NSString *)keyPath;
+
+/**
+ * Returns an aggregate named |name| applying |function| to the values |valueBlock| returns for the
+ * items. |valueBlock| may be called on any thread.
+ */
+- (instancetype)initWithName:(NSString *)name
+                    function:(GMUClusterAggregateFunction)function
+                  valueBlock:(GMUClusterAggregateValueBlock)valueBlock NS_DESIGNATED_INITIALIZER;
+
+/**
+ * The key of the aggregate in aggregateValues of clusters.
+ */
+@property(nonatomic, readonly, copy) NSString *name;
+
+/**
+ * The function applied to the values of the items.
+ */
+@property(nonatomic, readonly) GMUClusterAggregateFunction function;
+
+/**
+ * Returns the value of |item|, or NAN if it has none.
+ */
+- (double)valueOfItem:(id<GMUClusterItem>)item;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,55 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUClusterAggregate.h"
+
+#include <math.h>
+
+@implementation GMUClusterAggregate {
+  GMUClusterAggregateValueBlock _valueBlock;
+}
+
+- (instancetype)initWithName:(NSString *)name
+                    function:(GMUClusterAggregateFunction)function
+                     keyPath:(NSString *)keyPath {
+  NSString *path = [keyPath copy];
+  return [self initWithName:name
+                   function:function
+                 valueBlock:^double(id<GMUClusterItem> item) {
+                   id value = [(NSObject *)item valueForKeyPath:path];
+                   return [value isKindOfClass:[NSNumber class]] ? [value doubleValue] : NAN;
+                 }];
+}
+
+- (instancetype)initWithName:(NSString *)name
+                    function:(GMUClusterAggregateFunction)function
+                  valueBlock:(GMUClusterAggregateValueBlock)valueBlock {
+  if ((self = [super init])) {
+    _name = [name copy];
+    _function = function;
+    _valueBlock = [valueBlock copy];
+  }
+  return self;
+}
+
+- (double)valueOfItem:(id<GMUClusterItem>)item {
+  return _valueBlock(item);
+}
+
+@end
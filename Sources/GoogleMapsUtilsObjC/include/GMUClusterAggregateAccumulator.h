@@ -0,0 +1,60 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUClusterAggregate.h"
+#import "GMUClusterItem.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The running state of a GMUClusterAggregate over the values added so far, from which the value
+ * of every function follows.
+ */
+typedef struct {
+  double sum;
+  double min;
+  double max;
+  NSUInteger count;
+} GMUClusterAggregateAccumulator;
+
+/**
+ * Empties the |count| accumulators at |accumulators|.
+ */
+extern void GMUClearAccumulators(GMUClusterAggregateAccumulator *accumulators, NSUInteger count);
+
+/**
+ * Adds the value of |item| for each of |aggregates| to the accumulator with the same index.
+ */
+extern void GMUAccumulateItem(GMUClusterAggregateAccumulator *accumulators,
+                              NSArray<GMUClusterAggregate *> *aggregates,
+                              id<GMUClusterItem> item);
+
+/**
+ * Adds the |count| accumulators at |source| to those at |accumulators|.
+ */
+extern void GMUMergeAccumulators(GMUClusterAggregateAccumulator *accumulators,
+                                 const GMUClusterAggregateAccumulator *source, NSUInteger count);
+
+/**
+ * Returns the value of each of |aggregates| from the accumulator with the same index, keyed by
+ * name. Aggregates over no values are left out.
+ */
+extern NSDictionary<NSString *, NSNumber *> *GMUAggregateValues(
+    NSArray<GMUClusterAggregate *> *aggregates,
+    const GMUClusterAggregateAccumulator *accumulators);
+
+NS_ASSUME_NONNULL_END
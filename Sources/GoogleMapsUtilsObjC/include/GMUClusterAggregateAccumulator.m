@@ -0,0 +1,79 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUClusterAggregateAccumulator.h"
+
+#include <math.h>
+
+void GMUClearAccumulators(GMUClusterAggregateAccumulator *accumulators, NSUInteger count) {
+  for (NSUInteger i = 0; i < count; ++i) {
+    accumulators[i] = (GMUClusterAggregateAccumulator){0, INFINITY, -INFINITY, 0};
+  }
+}
+
+void GMUAccumulateItem(GMUClusterAggregateAccumulator *accumulators,
+                       NSArray<GMUClusterAggregate *> *aggregates, id<GMUClusterItem> item) {
+  NSUInteger index = 0;
+  for (GMUClusterAggregate *aggregate in aggregates) {
+    GMUClusterAggregateAccumulator *accumulator = &accumulators[index++];
+    double value = [aggregate valueOfItem:item];
+    if (isnan(value)) continue;
+    accumulator->sum += value;
+    accumulator->min = fmin(accumulator->min, value);
+    accumulator->max = fmax(accumulator->max, value);
+    ++accumulator->count;
+  }
+}
+
+void GMUMergeAccumulators(GMUClusterAggregateAccumulator *accumulators,
+                          const GMUClusterAggregateAccumulator *source, NSUInteger count) {
+  for (NSUInteger i = 0; i < count; ++i) {
+    accumulators[i].sum += source[i].sum;
+    accumulators[i].min = fmin(accumulators[i].min, source[i].min);
+    accumulators[i].max = fmax(accumulators[i].max, source[i].max);
+    accumulators[i].count += source[i].count;
+  }
+}
+
+NSDictionary<NSString *, NSNumber *> *GMUAggregateValues(
+    NSArray<GMUClusterAggregate *> *aggregates,
+    const GMUClusterAggregateAccumulator *accumulators) {
+  NSMutableDictionary<NSString *, NSNumber *> *values =
+      [[NSMutableDictionary alloc] initWithCapacity:aggregates.count];
+  NSUInteger index = 0;
+  for (GMUClusterAggregate *aggregate in aggregates) {
+    const GMUClusterAggregateAccumulator *accumulator = &accumulators[index++];
+    if (accumulator->count == 0) continue;
+    switch (aggregate.function) {
+      case GMUClusterAggregateFunctionSum:
+        values[aggregate.name] = @(accumulator->sum);
+        break;
+      case GMUClusterAggregateFunctionMin:
+        values[aggregate.name] = @(accumulator->min);
+        break;
+      case GMUClusterAggregateFunctionMax:
+        values[aggregate.name] = @(accumulator->max);
+        break;
+      case GMUClusterAggregateFunctionMean:
+        values[aggregate.name] = @(accumulator->sum / accumulator->count);
+        break;
+    }
+  }
+  return values;
+}
@@ -16,7 +16,12 @@
 #import <Foundation/Foundation.h>
 
 #import "GMUCluster.h"
+#import "GMUClusterAggregate.h"
+#import "GMUClusterCancellationToken.h"
+#import "GMUClusterDelta.h"
 #import "GMUClusterItem.h"
+#import "GMUPackedClusterItem.h"
+#import "GQTBounds.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -42,6 +47,66 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom;
 
+@optional
+
+/**
+ * Returns the clusters of the added items within |bounds|, clustering only the items in and around
+ * |bounds| where the algorithm allows it. |bounds| is in map points (see GMSProject) and may extend
+ * past the antimeridian at x = -1 or x = 1, in which case it continues on the other side.
+ * Clusters near the edges of |bounds| can differ from those returned by clustersAtZoom:, so callers
+ * should pad the area they show.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom inBounds:(GQTBounds)bounds;
+
+/**
+ * Returns the clusters of clustersAtZoom:inBounds:, or nil if |token| is cancelled before they
+ * are complete. GMUClusterManager calls this off the main thread in asynchronous mode, so that a
+ * clustering superseded by a newer one stops early.
+ */
+- (nullable NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom
+                                            inBounds:(GQTBounds)bounds
+                                   cancellationToken:(GMUClusterCancellationToken *)token;
+
+/**
+ * Whether clustersAtZoom:inBounds: returns exactly the clusters of clustersAtZoom: whose position
+ * is within the bounds, whatever the bounds. GMUClusterManager then streams the clusters around
+ * the viewport before those of the rest of the world are computed.
+ */
+@property(nonatomic, readonly) BOOL clustersInBoundsAreExact;
+
+/**
+ * Adds |count| items, each identified by an entry of |identifiers| and positioned at the entry with
+ * the same index in |coordinates|, without creating an object per item. The algorithm keeps them
+ * packed and returns GMUPackedClusterItem objects for them from the items of its clusters.
+ * removeItem: removes such an item given any GMUPackedClusterItem with its identifier.
+ */
+- (void)addItemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+                    identifiers:(const int64_t *)identifiers
+                          count:(NSUInteger)count;
+
+/**
+ * The aggregates computed over the items of every cluster while clustering, which clusters return
+ * from aggregateValues. Set them before clustering starts, as setting them while a clustering is
+ * running is not thread safe. Packed items have no values.
+ */
+@property(nonatomic, copy) NSArray<GMUClusterAggregate *> *aggregates;
+
+@end
+
+/**
+ * A clustering algorithm which keeps the clusters of one zoom level up to date as items are added
+ * and removed, touching only the clusters near the changed items, and reports what changed.
+ */
+@protocol GMUIncrementalClusterAlgorithm<GMUClusterAlgorithm>
+
+/**
+ * Returns how the clusters at |zoom| changed since the previous call. If the previous call was for
+ * another zoom level, or there was none, every cluster reported before is removed and every
+ * cluster at |zoom| is added. From then on, clustersAtZoom: at |zoom| returns the same cluster
+ * objects, and they are updated in place rather than recomputed.
+ */
+- (GMUClusterDelta *)clusterDeltaAtZoom:(float)zoom;
+
 @end
 
 NS_ASSUME_NONNULL_END
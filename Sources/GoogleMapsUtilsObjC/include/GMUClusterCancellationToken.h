@@ -0,0 +1,38 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Lets the code which started a clustering operation stop it while it runs on another thread.
+ * Algorithms check isCancelled as they go and give up as soon as it is set.
+ */
+@interface GMUClusterCancellationToken : NSObject
+
+/**
+ * Returns whether cancel has been called. Can be read from any thread.
+ */
+@property(atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ * Asks the operation holding this token to stop. Can be called from any thread.
+ */
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,46 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUClusterItem.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Numbers the clusterCategory values of cluster items, so that clustering algorithms store and
+ * compare categories as integers. Number 0 stands for items without a category, and categories
+ * keep their number for the lifetime of the table.
+ */
+@interface GMUClusterCategoryTable : NSObject
+
+/**
+ * Returns the number of the category of |item|, numbering the category first if it is new.
+ */
+- (uint32_t)numberForCategoryOfItem:(id<GMUClusterItem>)item;
+
+/**
+ * Returns the category numbered |number|, or nil for 0.
+ */
+- (nullable NSString *)categoryForNumber:(uint32_t)number;
+
+/**
+ * Returns the number of categories numbered so far, not counting items without a category.
+ */
+@property(nonatomic, readonly) NSUInteger count;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,57 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUClusterCategoryTable.h"
+
+@implementation GMUClusterCategoryTable {
+  NSMutableDictionary<NSString *, NSNumber *> *_numbersByCategory;
+  // Categories by number, starting at 1.
+  NSMutableArray<NSString *> *_categories;
+}
+
+- (instancetype)init {
+  if ((self = [super init])) {
+    _numbersByCategory = [[NSMutableDictionary alloc] init];
+    _categories = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (uint32_t)numberForCategoryOfItem:(id<GMUClusterItem>)item {
+  if (![item respondsToSelector:@selector(clusterCategory)]) return 0;
+  NSString *category = item.clusterCategory;
+  if (category == nil) return 0;
+  NSNumber *number = _numbersByCategory[category];
+  if (number == nil) {
+    [_categories addObject:[category copy]];
+    number = @((uint32_t)_categories.count);
+    _numbersByCategory[_categories.lastObject] = number;
+  }
+  return number.unsignedIntValue;
+}
+
+- (NSString *)categoryForNumber:(uint32_t)number {
+  return number == 0 ? nil : _categories[number - 1];
+}
+
+- (NSUInteger)count {
+  return _categories.count;
+}
+
+@end
@@ -0,0 +1,70 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUCluster.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Describes how the clusters of one zoom level changed since they were last reported, so that a
+ * renderer only has to update the markers of the clusters involved.
+ */
+@interface GMUClusterDelta : NSObject
+
+/**
+ * The default initializer is not available. Use
+ * initWithZoom:addedClusters:removedClusters:changedClusters: instead.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns a new instance of the GMUClusterDelta class for clusters at |zoom|.
+ */
+- (instancetype)initWithZoom:(float)zoom
+               addedClusters:(NSArray<id<GMUCluster>> *)addedClusters
+             removedClusters:(NSArray<id<GMUCluster>> *)removedClusters
+             changedClusters:(NSArray<id<GMUCluster>> *)changedClusters NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Returns the zoom level of the clusters.
+ */
+@property(nonatomic, readonly) float zoom;
+
+/**
+ * Returns the clusters which were not reported before.
+ */
+@property(nonatomic, readonly) NSArray<id<GMUCluster>> *addedClusters;
+
+/**
+ * Returns the previously reported clusters which no longer exist.
+ */
+@property(nonatomic, readonly) NSArray<id<GMUCluster>> *removedClusters;
+
+/**
+ * Returns the previously reported clusters whose items changed. These are the same objects as
+ * before, updated in place, and their position did not change.
+ */
+@property(nonatomic, readonly) NSArray<id<GMUCluster>> *changedClusters;
+
+/**
+ * Returns YES if no cluster was added, removed or changed.
+ */
+@property(nonatomic, readonly, getter=isEmpty) BOOL empty;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,41 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUClusterDelta.h"
+
+@implementation GMUClusterDelta
+
+- (instancetype)initWithZoom:(float)zoom
+               addedClusters:(NSArray<id<GMUCluster>> *)addedClusters
+             removedClusters:(NSArray<id<GMUCluster>> *)removedClusters
+             changedClusters:(NSArray<id<GMUCluster>> *)changedClusters {
+  if ((self = [super init])) {
+    _zoom = zoom;
+    _addedClusters = [addedClusters copy];
+    _removedClusters = [removedClusters copy];
+    _changedClusters = [changedClusters copy];
+  }
+  return self;
+}
+
+- (BOOL)isEmpty {
+  return _addedClusters.count == 0 && _removedClusters.count == 0 && _changedClusters.count == 0;
+}
+
+@end
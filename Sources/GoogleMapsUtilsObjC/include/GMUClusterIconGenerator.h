@@ -16,6 +16,8 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#import "GMUCluster.h"
+
 /**
  * Defines a contract for cluster icon generation.
  */
@@ -26,4 +28,12 @@
  */
 - (UIImage *)iconForSize:(NSUInteger)size;
 
+@optional
+
+/**
+ * Generates an icon for |cluster|, which GMUDefaultClusterRenderer prefers over iconForSize:. The
+ * icon can show the aggregateValues of the cluster without reading its items.
+ */
+- (UIImage *)iconForCluster:(id<GMUCluster>)cluster;
+
 @end
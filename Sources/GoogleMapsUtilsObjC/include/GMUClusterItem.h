@@ -30,4 +30,10 @@
 
 @property(nonatomic, copy, nullable) NSString* snippet;
 
+/**
+ * Returns the category of the item. Clustering algorithms only cluster items of the same category
+ * together. Items which do not implement it, or return nil, share a category of their own.
+ */
+@property(nonatomic, readonly, copy, nullable) NSString* clusterCategory;
+
 @end
@@ -72,6 +72,33 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, readonly) id<GMUClusterAlgorithm> algorithm;
 
+/**
+ * Whether the algorithm runs on a background queue rather than on the main thread (default is NO).
+ * Set it before adding items. In asynchronous mode:
+ * - Items added, removed or cleared through this object reach the algorithm on a serial background
+ *   queue, in order. The arrays passed to addItems: are copied first. The algorithm must not be
+ *   called directly.
+ * - cluster runs the algorithm on that queue and hands the clusters to the renderer on the main
+ *   thread. A newer call cancels the clustering in flight, which stops early if the algorithm
+ *   implements clustersAtZoom:inBounds:cancellationToken:. Clusters of a cancelled call are never
+ *   rendered.
+ * - Clusters are never rendered through renderClusterDelta: unless streaming is set.
+ */
+@property(nonatomic, getter=isAsynchronous) BOOL asynchronous;
+
+/**
+ * Whether clusters are handed to the renderer in chunks as soon as they are computed, nearest to
+ * the viewport first (default is NO). Only used in asynchronous mode. The clusters within the
+ * visible region are rendered first, replacing those rendered before. The clusters around it
+ * follow, then those of the rest of the world, added through renderClusterDelta: if the renderer
+ * implements it. Every item is part of a single rendered cluster.
+ * If the algorithm's clustersInBoundsAreExact is YES, each area is clustered in turn, so the
+ * visible clusters are rendered before the rest of the world is clustered. Otherwise the clusters
+ * of the whole world are computed once and split by area, so the first chunk is only ready once
+ * they all are.
+ */
+@property(nonatomic, getter=isStreaming) BOOL streaming;
+
 /**
  * GMUClusterManager |delegate|.
  * To set it use the setDelegate:mapDelegate: method.
@@ -116,6 +143,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)addItems:(NSArray<id<GMUClusterItem>> *)items;
 
+/**
+ * Adds |count| cluster items to the collection, each identified by an entry of |identifiers| and
+ * positioned at the entry with the same index in |coordinates|. Algorithms which implement
+ * addItemsWithCoordinates:identifiers:count: keep them packed, others get GMUPackedClusterItem
+ * objects. The buffers are copied in asynchronous mode.
+ */
+- (void)addItemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+                    identifiers:(const int64_t *)identifiers
+                          count:(NSUInteger)count;
+
 /**
  * Removes a cluster item from the collection.
  */
@@ -130,6 +167,12 @@ NS_ASSUME_NONNULL_BEGIN
  * Called to arrange items into groups.
  * - This method will be automatically invoked when the map's zoom level changes.
  * - Manually invoke this method when new items have been added to rearrange items.
+ * - If the algorithm conforms to GMUIncrementalClusterAlgorithm and the renderer implements
+ *   renderClusterDelta:, reclustering at the same zoom level only updates the clusters around
+ *   items added or removed since the previous call.
+ * - Otherwise, if the algorithm implements clustersAtZoom:inBounds:, only the clusters around the
+ *   visible region of the map are computed, and the camera moving out of that area triggers
+ *   another call.
  */
 - (void)cluster;
 
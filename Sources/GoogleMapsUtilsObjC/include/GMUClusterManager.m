@@ -16,6 +16,7 @@
 #import "GMUClusterManager+Testing.h"
 #import <GoogleMaps/GoogleMaps.h>
 #import "GMUClusterRenderer.h"
+#import "GMUMapPointBounds.h"
 #import "GMUSimpleClusterAlgorithm.h"
 #import "GMUVersion.h"
 
@@ -25,6 +26,40 @@ static NSString *const kGMUCameraKeyPath = @"camera";
 // to avoid continuous clustering when the camera is moving which can affect performance.
 static const double kGMUClusterWaitIntervalSeconds = 0.2;
 
+// Fraction of the width and height of the visible region added on every side of it when only the
+// clusters around the viewport are computed, so that the camera can pan a little without
+// reclustering.
+static const double kGMUClusterBoundsPadding = 0.5;
+
+// Number of areas clusters are streamed for: the visible region, the padded area around it and
+// the whole world.
+static const NSUInteger kGMUStreamingAreaCount = 3;
+
+// Margin in map points added around each area queried while streaming.
+static const double kGMUStreamingBoundsMargin = 1e-9;
+
+// Returns the index of the first of the streaming |areas| which contains |point|.
+static NSUInteger GMUStreamingAreaOfPoint(const GQTBounds *areas, GMSMapPoint point) {
+  for (NSUInteger area = 0; area + 1 < kGMUStreamingAreaCount; ++area) {
+    if (GMUBoundsContainPoint(areas[area], point)) return area;
+  }
+  return kGMUStreamingAreaCount - 1;
+}
+
+// Adds |count| packed items to |algorithm|, as GMUPackedClusterItem objects if it does not take
+// packed items.
+static void GMUAddPackedItems(id<GMUClusterAlgorithm> algorithm,
+                              const CLLocationCoordinate2D *coordinates,
+                              const int64_t *identifiers, NSUInteger count) {
+  if ([algorithm respondsToSelector:@selector(addItemsWithCoordinates:identifiers:count:)]) {
+    [algorithm addItemsWithCoordinates:coordinates identifiers:identifiers count:count];
+  } else {
+    [algorithm addItems:[GMUPackedClusterItem itemsWithCoordinates:coordinates
+                                                       identifiers:identifiers
+                                                             count:count]];
+  }
+}
+
 @implementation GMUClusterManager {
   // The map view that this object is associated with.
   GMSMapView *_mapView;
@@ -37,6 +72,24 @@ static const double kGMUClusterWaitIntervalSeconds = 0.2;
 
   // Renderer.
   id<GMUClusterRenderer> _renderer;
+
+  // Integral zoom level of the clusters last passed to the renderer, or NSNotFound.
+  NSUInteger _renderedZoom;
+
+  // Bounds in map points of the clusters last passed to the renderer, if they were limited to the
+  // area around the viewport.
+  GQTBounds _clusteredBounds;
+  BOOL _hasClusteredBounds;
+
+  // Serial queue the algorithm is called on in asynchronous mode.
+  dispatch_queue_t _algorithmQueue;
+
+  // Cancels the clustering in flight in asynchronous mode.
+  GMUClusterCancellationToken *_clusterCancellationToken;
+
+  // Clusters rendered so far by the streaming in flight, for renderers which do not implement
+  // renderClusterDelta:.
+  NSMutableArray<id<GMUCluster>> *_streamedClusters;
 }
 
 - (instancetype)initWithMap:(GMSMapView *)mapView
@@ -50,6 +103,9 @@ static const double kGMUClusterWaitIntervalSeconds = 0.2;
     _previousCamera = _mapView.camera;
     _algorithm = algorithm;
     _renderer = renderer;
+    _renderedZoom = NSNotFound;
+    _algorithmQueue =
+        dispatch_queue_create("com.google.maps.utils.cluster-manager", DISPATCH_QUEUE_SERIAL);
 
     [_mapView addObserver:self
                forKeyPath:kGMUCameraKeyPath
@@ -61,6 +117,7 @@ static const double kGMUClusterWaitIntervalSeconds = 0.2;
 }
 
 - (void)dealloc {
+  [_clusterCancellationToken cancel];
   [_mapView removeObserver:self forKeyPath:kGMUCameraKeyPath];
 }
 
@@ -77,26 +134,92 @@ static const double kGMUClusterWaitIntervalSeconds = 0.2;
 }
 
 - (void)addItem:(id<GMUClusterItem>)item {
-  [_algorithm addItems:[[NSMutableArray alloc] initWithObjects:item, nil]];
+  [self addItems:[[NSMutableArray alloc] initWithObjects:item, nil]];
 }
 
 - (void)addItems:(NSArray<id<GMUClusterItem>> *)items {
+  if (_asynchronous) {
+    id<GMUClusterAlgorithm> algorithm = _algorithm;
+    NSArray<id<GMUClusterItem>> *snapshot = [items copy];
+    dispatch_async(_algorithmQueue, ^{
+      [algorithm addItems:snapshot];
+    });
+    return;
+  }
   [_algorithm addItems:items];
 }
 
+- (void)addItemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+                    identifiers:(const int64_t *)identifiers
+                          count:(NSUInteger)count {
+  if (_asynchronous) {
+    id<GMUClusterAlgorithm> algorithm = _algorithm;
+    NSData *coordinateData = [NSData dataWithBytes:coordinates
+                                            length:count * sizeof(CLLocationCoordinate2D)];
+    NSData *identifierData = [NSData dataWithBytes:identifiers length:count * sizeof(int64_t)];
+    dispatch_async(_algorithmQueue, ^{
+      GMUAddPackedItems(algorithm, coordinateData.bytes, identifierData.bytes, count);
+    });
+    return;
+  }
+  GMUAddPackedItems(_algorithm, coordinates, identifiers, count);
+}
+
 - (void)removeItem:(id<GMUClusterItem>)item {
+  if (_asynchronous) {
+    id<GMUClusterAlgorithm> algorithm = _algorithm;
+    dispatch_async(_algorithmQueue, ^{
+      [algorithm removeItem:item];
+    });
+    return;
+  }
   [_algorithm removeItem:item];
 }
 
 - (void)clearItems {
-  [_algorithm clearItems];
+  if (_asynchronous) {
+    id<GMUClusterAlgorithm> algorithm = _algorithm;
+    dispatch_async(_algorithmQueue, ^{
+      [algorithm clearItems];
+    });
+  } else {
+    [_algorithm clearItems];
+  }
   [self requestCluster];
 }
 
 - (void)cluster {
+  if (_asynchronous) {
+    [self clusterAsynchronously];
+    return;
+  }
   NSUInteger integralZoom = (NSUInteger)floorf(_mapView.camera.zoom + 0.5f);
-  NSArray<id<GMUCluster>> *clusters = [_algorithm clustersAtZoom:integralZoom];
+  if ([self rendersClusterDeltas]) {
+    // Only the clusters around changed items are updated while the zoom level stays the same. On
+    // zoom changes all clusters are rendered again, which lets the renderer animate them.
+    id<GMUIncrementalClusterAlgorithm> algorithm = (id<GMUIncrementalClusterAlgorithm>)_algorithm;
+    GMUClusterDelta *delta = [algorithm clusterDeltaAtZoom:integralZoom];
+    if (integralZoom == _renderedZoom) {
+      if (!delta.isEmpty) {
+        [_renderer renderClusterDelta:delta];
+      }
+      _previousCamera = _mapView.camera;
+      return;
+    }
+  }
+  // Incremental algorithms keep the clusters of the whole world up to date, which the deltas above
+  // rely on. Other algorithms only cluster the area around the viewport when they can.
+  NSArray<id<GMUCluster>> *clusters;
+  _hasClusteredBounds = ![self rendersClusterDeltas] &&
+                        [_algorithm respondsToSelector:@selector(clustersAtZoom:inBounds:)];
+  if (_hasClusteredBounds) {
+    _clusteredBounds = [self visibleBoundsWithPadding:kGMUClusterBoundsPadding];
+    clusters = [_algorithm clustersAtZoom:integralZoom inBounds:_clusteredBounds];
+  } else {
+    clusters = [_algorithm clustersAtZoom:integralZoom];
+  }
   [_renderer renderClusters:clusters];
+  _renderedZoom = integralZoom;
   _previousCamera = _mapView.camera;
 }
 
@@ -261,10 +384,211 @@ static const double kGMUClusterWaitIntervalSeconds = 0.2;
   if (previousIntegralZoom != currentIntegralZoom) {
     [self requestCluster];
   } else {
+    if (_hasClusteredBounds && ![self clusteredBoundsContainVisibleRegion]) {
+      [self requestCluster];
+    }
     [_renderer update];
   }
 }
 
+// Returns the corners of the visible region in map points, unwrapped so that the region does not
+// jump across the antimeridian.
+- (void)getVisibleCorners:(GMSMapPoint[4])corners {
+  GMSVisibleRegion region = _mapView.projection.visibleRegion;
+  CLLocationCoordinate2D coordinates[4] = {region.nearLeft, region.nearRight, region.farLeft,
+                                           region.farRight};
+  for (int i = 0; i < 4; ++i) {
+    corners[i] = GMSProject(coordinates[i]);
+    if (i == 0) continue;
+    if (corners[i].x - corners[0].x > kGMUMapPointWidth / 2) {
+      corners[i].x -= kGMUMapPointWidth;
+    } else if (corners[0].x - corners[i].x > kGMUMapPointWidth / 2) {
+      corners[i].x += kGMUMapPointWidth;
+    }
+  }
+}
+
+// Returns the bounds of the visible region in map points, with |padding| times its width and height
+// added on every side.
+- (GQTBounds)visibleBoundsWithPadding:(double)padding {
+  GMSMapPoint corners[4];
+  [self getVisibleCorners:corners];
+  GQTBounds bounds = {corners[0].x, corners[0].y, corners[0].x, corners[0].y};
+  for (int i = 1; i < 4; ++i) {
+    bounds.minX = MIN(bounds.minX, corners[i].x);
+    bounds.minY = MIN(bounds.minY, corners[i].y);
+    bounds.maxX = MAX(bounds.maxX, corners[i].x);
+    bounds.maxY = MAX(bounds.maxY, corners[i].y);
+  }
+  double paddingX = (bounds.maxX - bounds.minX) * padding;
+  double paddingY = (bounds.maxY - bounds.minY) * padding;
+  bounds.minX -= paddingX;
+  bounds.maxX += paddingX;
+  bounds.minY = MAX(bounds.minY - paddingY, -1);
+  bounds.maxY = MIN(bounds.maxY + paddingY, 1);
+  if (bounds.maxX - bounds.minX >= kGMUMapPointWidth) {
+    bounds.minX = -1;
+    bounds.maxX = 1;
+  }
+  return bounds;
+}
+
+- (BOOL)clusteredBoundsContainVisibleRegion {
+  GMSMapPoint corners[4];
+  [self getVisibleCorners:corners];
+  for (int i = 0; i < 4; ++i) {
+    if (!GMUBoundsContainPoint(_clusteredBounds, corners[i])) return NO;
+  }
+  return YES;
+}
+
+- (BOOL)rendersClusterDeltas {
+  return !_asynchronous &&
+         [_algorithm conformsToProtocol:@protocol(GMUIncrementalClusterAlgorithm)] &&
+         [_renderer respondsToSelector:@selector(renderClusterDelta:)];
+}
+
+// Runs the algorithm on _algorithmQueue, after the item changes already queued, then renders the
+// clusters on the main thread unless a newer call cancelled them in the meantime.
+- (void)clusterAsynchronously {
+  NSUInteger integralZoom = (NSUInteger)floorf(_mapView.camera.zoom + 0.5f);
+  id<GMUClusterAlgorithm> algorithm = _algorithm;
+  if (_streaming) {
+    [self streamClusters];
+    return;
+  }
+  BOOL clustersInBounds = [algorithm respondsToSelector:@selector(clustersAtZoom:inBounds:)];
+  BOOL cancellable =
+      [algorithm respondsToSelector:@selector(clustersAtZoom:inBounds:cancellationToken:)];
+  GQTBounds bounds = {-1, -1, 1, 1};
+  if (clustersInBounds) {
+    bounds = [self visibleBoundsWithPadding:kGMUClusterBoundsPadding];
+  }
+  // The area being clustered counts as clustered already, so that the camera moving within it
+  // does not request the same clustering again.
+  _hasClusteredBounds = clustersInBounds;
+  _clusteredBounds = bounds;
+  _previousCamera = _mapView.camera;
+
+  [_clusterCancellationToken cancel];
+  GMUClusterCancellationToken *token = [[GMUClusterCancellationToken alloc] init];
+  _clusterCancellationToken = token;
+  __weak GMUClusterManager *weakSelf = self;
+  dispatch_async(_algorithmQueue, ^{
+    if (token.isCancelled) return;
+
+    NSArray<id<GMUCluster>> *clusters;
+    if (cancellable) {
+      clusters = [algorithm clustersAtZoom:integralZoom inBounds:bounds cancellationToken:token];
+    } else if (clustersInBounds) {
+      clusters = [algorithm clustersAtZoom:integralZoom inBounds:bounds];
+    } else {
+      clusters = [algorithm clustersAtZoom:integralZoom];
+    }
+    if (clusters == nil || token.isCancelled) return;
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      GMUClusterManager *strongSelf = weakSelf;
+      if (strongSelf == nil || token.isCancelled) {
+        return;
+      }
+      [strongSelf->_renderer renderClusters:clusters];
+      strongSelf->_renderedZoom = integralZoom;
+    });
+  });
+}
+
+// Streams the clusters within the visible region, those in the padded area around it and then the
+// rest, each chunk rendered on the main thread as soon as it is ready unless a newer call cancelled
+// it in the meantime. Algorithms with exact clusters within bounds are queried for each area in
+// turn, so that the visible clusters are rendered before the rest of the world is clustered.
+// Otherwise the clusters of the whole world are computed once and split by area, as clusters of
+// separate areas could share items. Either way, every item is rendered in exactly one cluster.
+- (void)streamClusters {
+  NSUInteger integralZoom = (NSUInteger)floorf(_mapView.camera.zoom + 0.5f);
+  id<GMUClusterAlgorithm> algorithm = _algorithm;
+  BOOL cancellable =
+      [algorithm respondsToSelector:@selector(clustersAtZoom:inBounds:cancellationToken:)];
+  BOOL progressive = [algorithm respondsToSelector:@selector(clustersAtZoom:inBounds:)] &&
+                     [algorithm respondsToSelector:@selector(clustersInBoundsAreExact)] &&
+                     algorithm.clustersInBoundsAreExact;
+  GQTBounds visibleBounds = [self visibleBoundsWithPadding:0];
+  GQTBounds paddedBounds = [self visibleBoundsWithPadding:kGMUClusterBoundsPadding];
+  // The whole world ends up clustered, so moving the camera does not require clustering again.
+  _hasClusteredBounds = NO;
+  _previousCamera = _mapView.camera;
+
+  [_clusterCancellationToken cancel];
+  GMUClusterCancellationToken *token = [[GMUClusterCancellationToken alloc] init];
+  _clusterCancellationToken = token;
+  __weak GMUClusterManager *weakSelf = self;
+  dispatch_async(_algorithmQueue, ^{
+    GQTBounds areas[] = {visibleBounds, paddedBounds, {-1, -1, 1, 1}};
+    NSArray<id<GMUCluster>> *clusters;
+    for (NSUInteger area = 0; area < kGMUStreamingAreaCount; ++area) {
+      if (token.isCancelled) return;
+
+      if (progressive || area == 0) {
+        // Areas are widened a little so that no cluster is missed because its position does not
+        // project back exactly onto the point it was searched at.
+        GQTBounds bounds = progressive ? areas[area] : areas[kGMUStreamingAreaCount - 1];
+        bounds.minX -= kGMUStreamingBoundsMargin;
+        bounds.minY -= kGMUStreamingBoundsMargin;
+        bounds.maxX += kGMUStreamingBoundsMargin;
+        bounds.maxY += kGMUStreamingBoundsMargin;
+        if (cancellable) {
+          clusters = [algorithm clustersAtZoom:integralZoom
+                                      inBounds:bounds
+                             cancellationToken:token];
+        } else if (progressive) {
+          clusters = [algorithm clustersAtZoom:integralZoom inBounds:bounds];
+        } else {
+          clusters = [algorithm clustersAtZoom:integralZoom];
+        }
+      }
+      if (clusters == nil || token.isCancelled) return;
+
+      // Clusters of an area which are in a previous one were delivered with that area.
+      NSMutableArray<id<GMUCluster>> *chunk = [[NSMutableArray alloc] init];
+      for (id<GMUCluster> cluster in clusters) {
+        if (GMUStreamingAreaOfPoint(areas, GMSProject(cluster.position)) == area) {
+          [chunk addObject:cluster];
+        }
+      }
+      BOOL isFirstChunk = area == 0;
+      if (chunk.count == 0 && !isFirstChunk) continue;
+
+      dispatch_async(dispatch_get_main_queue(), ^{
+        GMUClusterManager *strongSelf = weakSelf;
+        if (strongSelf == nil || token.isCancelled) {
+          return;
+        }
+        [strongSelf renderStreamedClusters:chunk zoom:integralZoom isFirstChunk:isFirstChunk];
+      });
+    }
+  });
+}
+
+// Renders a chunk of the clusters at |zoom| being streamed. The first chunk replaces the clusters
+// rendered before, and later chunks are added to it.
+- (void)renderStreamedClusters:(NSArray<id<GMUCluster>> *)clusters
+                          zoom:(NSUInteger)zoom
+                  isFirstChunk:(BOOL)isFirstChunk {
+  if (isFirstChunk) {
+    [_renderer renderClusters:clusters];
+    _renderedZoom = zoom;
+    _streamedClusters = [clusters mutableCopy];
+  } else if ([_renderer respondsToSelector:@selector(renderClusterDelta:)]) {
+    [_renderer renderClusterDelta:[[GMUClusterDelta alloc] initWithZoom:zoom
+                                                          addedClusters:clusters
+                                                        removedClusters:@[]
+                                                        changedClusters:@[]]];
+  } else {
+    [_streamedClusters addObjectsFromArray:clusters];
+    [_renderer renderClusters:[_streamedClusters copy]];
+  }
+}
+
 - (void)requestCluster {
   __weak GMUClusterManager *weakSelf = self;
   ++_clusterRequestCount;
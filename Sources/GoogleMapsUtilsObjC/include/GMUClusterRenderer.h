@@ -16,6 +16,7 @@
 #import <Foundation/Foundation.h>
 
 #import "GMUCluster.h"
+#import "GMUClusterDelta.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -31,6 +32,12 @@ NS_ASSUME_NONNULL_BEGIN
 // For example new clusters may become visible and need to be shown on map.
 - (void)update;
 
+@optional
+
+// Renders the changes to the clusters last rendered, at the same zoom level, by updating only the
+// markers of the clusters in |delta|.
+- (void)renderClusterDelta:(GMUClusterDelta *)delta;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -52,6 +52,9 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
   // Tracks cluster items that have been rendered to the map.
   NSMutableSet *_renderedClusterItems;
 
+  // Markers added for each rendered cluster, so that a cluster's markers can be removed alone.
+  NSMapTable<id<GMUCluster>, NSMutableArray<GMSMarker *> *> *_markersByCluster;
+
   // Stores previous zoom level to determine zooming direction (in/out).
   float _previousZoom;
 
@@ -70,6 +73,7 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
     _clusterIconGenerator = iconGenerator;
     _renderedClusters = [[NSMutableSet alloc] init];
     _renderedClusterItems = [[NSMutableSet alloc] init];
+    _markersByCluster = [NSMapTable strongToStrongObjectsMapTable];
     _animatesClusters = YES;
     _minimumClusterSize = kGMUMinClusterSize;
     _maximumClusterZoom = kGMUMaxClusterZoom;
@@ -93,6 +97,7 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
 - (void)renderClusters:(NSArray<id<GMUCluster>> *)clusters {
   [_renderedClusters removeAllObjects];
   [_renderedClusterItems removeAllObjects];
+  [_markersByCluster removeAllObjects];
 
   if (_animatesClusters) {
     [self renderAnimatedClusters:clusters];
@@ -181,6 +186,50 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
                  });
 }
 
+// Removes the markers of removed and changed clusters, then renders changed and added clusters
+// without animation.
+- (void)renderClusterDelta:(GMUClusterDelta *)delta {
+  NSMutableArray<id<GMUCluster>> *staleClusters = [delta.removedClusters mutableCopy];
+  [staleClusters addObjectsFromArray:delta.changedClusters];
+  NSMutableSet<GMSMarker *> *staleMarkers = [[NSMutableSet alloc] init];
+  for (id<GMUCluster> cluster in staleClusters) {
+    NSArray<GMSMarker *> *markers = [_markersByCluster objectForKey:cluster];
+    if (markers == nil) continue;
+
+    for (GMSMarker *marker in markers) {
+      if (![marker.userData conformsToProtocol:@protocol(GMUCluster)]) {
+        [_renderedClusterItems removeObject:marker.userData];
+      }
+    }
+    [self clearMarkers:markers];
+    [staleMarkers addObjectsFromArray:markers];
+    [_markersByCluster removeObjectForKey:cluster];
+    [_renderedClusters removeObject:cluster];
+  }
+  if (staleMarkers.count > 0) {
+    NSIndexSet *staleIndexes = [_mutableMarkers
+        indexesOfObjectsPassingTest:^BOOL(GMSMarker *marker, NSUInteger index, BOOL *stop) {
+          return [staleMarkers containsObject:marker];
+        }];
+    [_mutableMarkers removeObjectsAtIndexes:staleIndexes];
+  }
+
+  NSArray<id<GMUCluster>> *clusters = _clusters ?: @[];
+  if (delta.removedClusters.count > 0) {
+    NSSet<id<GMUCluster>> *removedClusters = [NSSet setWithArray:delta.removedClusters];
+    NSIndexSet *remainingIndexes = [clusters
+        indexesOfObjectsPassingTest:^BOOL(id<GMUCluster> cluster, NSUInteger index, BOOL *stop) {
+          return ![removedClusters containsObject:cluster];
+        }];
+    clusters = [clusters objectsAtIndexes:remainingIndexes];
+  }
+  _clusters = [clusters arrayByAddingObjectsFromArray:delta.addedClusters];
+
+  NSArray<id<GMUCluster>> *updatedClusters =
+      [delta.changedClusters arrayByAddingObjectsFromArray:delta.addedClusters];
+  [self addOrUpdateClusters:updatedClusters animated:NO];
+}
+
 // Called when camera is changed to reevaluate if new clusters need to be displayed because
 // they become visible.
 - (void)update {
@@ -264,6 +313,7 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
 }
 
 - (void)renderCluster:(id<GMUCluster>)cluster animated:(BOOL)animated {
+  NSMutableArray<GMSMarker *> *clusterMarkers = [[NSMutableArray alloc] init];
   float zoom = _mapView.camera.zoom;
   if ([self shouldRenderAsCluster:cluster atZoom:zoom]) {
     CLLocationCoordinate2D fromPosition = kCLLocationCoordinate2DInvalid;
@@ -274,13 +324,16 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
       fromPosition = fromCluster.position;
     }
 
-    UIImage *icon = [_clusterIconGenerator iconForSize:cluster.count];
+    UIImage *icon = [_clusterIconGenerator respondsToSelector:@selector(iconForCluster:)]
+                        ? [_clusterIconGenerator iconForCluster:cluster]
+                        : [_clusterIconGenerator iconForSize:cluster.count];
     GMSMarker *marker = [self markerWithPosition:cluster.position
                                             from:fromPosition
                                         userData:cluster
                                      clusterIcon:icon
                                         animated:animated];
     [_mutableMarkers addObject:marker];
+    [clusterMarkers addObject:marker];
   } else {
     for (id<GMUClusterItem> item in cluster.items) {
       GMSMarker *marker;
@@ -309,10 +362,12 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
         }
       }
       [_mutableMarkers addObject:marker];
+      [clusterMarkers addObject:marker];
       [_renderedClusterItems addObject:item];
     }
   }
   [_renderedClusters addObject:cluster];
+  [_markersByCluster setObject:clusterMarkers forKey:cluster];
 }
 
 - (GMSMarker *)markerForObject:(id)object {
@@ -396,6 +451,7 @@ static const double kGMUAnimationDuration = 0.5;  // seconds.
   [_mutableMarkers removeAllObjects];
   [_renderedClusters removeAllObjects];
   [_renderedClusterItems removeAllObjects];
+  [_markersByCluster removeAllObjects];
   [_itemToNewClusterMap removeAllObjects];
   [_itemToOldClusterMap removeAllObjects];
   _clusters = nil;
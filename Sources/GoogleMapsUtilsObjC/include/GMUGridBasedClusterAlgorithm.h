@@ -19,8 +19,15 @@
 
 /**
  * A simple algorithm which devides the map into a grid where a cell has fixed dimension in
- * screen space.
+ * screen space. Items are projected once when added, and clusters come in the order of their
+ * first items.
  */
 @interface GMUGridBasedClusterAlgorithm : NSObject<GMUClusterAlgorithm>
 
+/**
+ * Initializes this GMUGridBasedClusterAlgorithm with gridCellSizePoints for the width and height
+ * of a grid cell on screen (default is 100).
+ */
+- (instancetype)initWithGridCellSizePoints:(NSUInteger)gridCellSizePoints;
+
 @end
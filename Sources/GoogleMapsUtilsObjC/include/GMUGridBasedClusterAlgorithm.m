@@ -22,27 +22,114 @@
 #import <GoogleMaps/GMSGeometryUtils.h>
 
 #import "GMUStaticCluster.h"
+#import "GMUClusterCategoryTable.h"
 #import "GMUClusterItem.h"
+#import "GMUMapPointBounds.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 // Grid cell dimension in pixels to keep clusters about 100 pixels apart on screen.
 static const NSUInteger kGMUGridCellSizePoints = 100;
 
+// Number of items binned between checks for cancellation.
+static const NSUInteger kGMUCancellationCheckInterval = 4096;
+
+// An open addressing hash map from non-zero cell keys and category numbers to the indices of their
+// clusters.
+typedef struct {
+  uint64_t *keys;
+  uint32_t *categories;
+  uint32_t *clusterIndices;
+  size_t mask;
+} GMUCellMap;
+
+static BOOL GMUCellMapInit(GMUCellMap *map, size_t count) {
+  size_t capacity = 16;
+  while (capacity < count * 2) capacity *= 2;
+  map->keys = calloc(capacity, sizeof(uint64_t));
+  map->categories = malloc(capacity * sizeof(uint32_t));
+  map->clusterIndices = malloc(capacity * sizeof(uint32_t));
+  map->mask = capacity - 1;
+  return map->keys && map->categories && map->clusterIndices;
+}
+
+static void GMUCellMapFree(GMUCellMap *map) {
+  free(map->keys);
+  free(map->categories);
+  free(map->clusterIndices);
+}
+
+// Returns the slot of |key| and |category|, which is either the slot holding them or the empty slot
+// they go in.
+static inline size_t GMUCellMapSlot(const GMUCellMap *map, uint64_t key, uint32_t category) {
+  uint64_t hash = (key + category * 0xD6E8FEB86659FD93ull) * 0x9E3779B97F4A7C15ull;
+  size_t slot = (size_t)(hash >> 32) & map->mask;
+  while (map->keys[slot] != 0 && (map->keys[slot] != key || map->categories[slot] != category)) {
+    slot = (slot + 1) & map->mask;
+  }
+  return slot;
+}
+
 @implementation GMUGridBasedClusterAlgorithm {
   NSMutableArray<id<GMUClusterItem>> *_items;
+  // Projections and category numbers of _items, in the same order.
+  GMSMapPoint *_points;
+  uint32_t *_categories;
+  NSUInteger _pointsCapacity;
+  GMUClusterCategoryTable *_categoryTable;
+  NSUInteger _gridCellSizePoints;
 }
 
+@synthesize aggregates = _aggregates;
+
 - (instancetype)init {
+  return [self initWithGridCellSizePoints:kGMUGridCellSizePoints];
+}
+
+- (instancetype)initWithGridCellSizePoints:(NSUInteger)gridCellSizePoints {
   if ((self = [super init])) {
     _items = [[NSMutableArray alloc] init];
+    _categoryTable = [[GMUClusterCategoryTable alloc] init];
+    _aggregates = @[];
+    _gridCellSizePoints = gridCellSizePoints > 0 ? gridCellSizePoints : kGMUGridCellSizePoints;
   }
   return self;
 }
 
+- (void)dealloc {
+  free(_points);
+  free(_categories);
+}
+
 - (void)addItems:(NSArray<id<GMUClusterItem>> *)items {
+  NSUInteger count = _items.count + items.count;
+  if (count > _pointsCapacity) {
+    NSUInteger capacity = MAX(count, _pointsCapacity * 2);
+    GMSMapPoint *points = realloc(_points, capacity * sizeof(GMSMapPoint));
+    if (!points) return;
+    _points = points;
+    uint32_t *categories = realloc(_categories, capacity * sizeof(uint32_t));
+    if (!categories) return;
+    _categories = categories;
+    _pointsCapacity = capacity;
+  }
+  NSUInteger index = _items.count;
+  for (id<GMUClusterItem> item in items) {
+    _points[index] = GMSProject(item.position);
+    _categories[index++] = [_categoryTable numberForCategoryOfItem:item];
+  }
   [_items addObjectsFromArray:items];
 }
 
 - (void)removeItem:(id<GMUClusterItem>)item {
+  NSUInteger count = 0;
+  for (NSUInteger i = 0; i < _items.count; ++i) {
+    if ([_items[i] isEqual:item]) continue;
+    _points[count] = _points[i];
+    _categories[count++] = _categories[i];
+  }
   [_items removeObject:item];
 }
 
@@ -51,29 +138,63 @@ static const NSUInteger kGMUGridCellSizePoints = 100;
 }
 
 - (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom {
-  NSMutableDictionary<NSNumber *, id<GMUCluster>> *clusters = [[NSMutableDictionary alloc] init];
+  GQTBounds world = {-1, -1, 1, 1};
+  return [self clustersAtZoom:zoom inBounds:world];
+}
+
+/**
+ * Returns the clusters of the items within |bounds|, in the order of their first items. Cells are
+ * independent of each other, so every cell which only holds items within |bounds| gets the same
+ * clusters as from clustersAtZoom:. A cell holds a cluster for each category of its items, all
+ * placed at the center of the cell.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom inBounds:(GQTBounds)bounds {
+  return [self clustersAtZoom:zoom inBounds:bounds cancellationToken:nil];
+}
+
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom
+                                   inBounds:(GQTBounds)bounds
+                          cancellationToken:(GMUClusterCancellationToken *)token {
+  NSMutableArray<GMUStaticCluster *> *clusters = [[NSMutableArray alloc] init];
+  GMUCellMap cells;
+  if (!GMUCellMapInit(&cells, _items.count)) {
+    GMUCellMapFree(&cells);
+    return clusters;
+  }
 
   // Divide the whole map into a numCells x numCells grid and assign items to them.
-  long numCells = (long)ceil(256 * pow(2, zoom) / kGMUGridCellSizePoints);
-  for (id<GMUClusterItem> item in _items) {
-    GMSMapPoint point = GMSProject(item.position);
+  long numCells = (long)ceil(256 * pow(2, zoom) / _gridCellSizePoints);
+  NSUInteger count = _items.count;
+  for (NSUInteger i = 0; i < count; ++i) {
+    if (i % kGMUCancellationCheckInterval == 0 && token.isCancelled) {
+      GMUCellMapFree(&cells);
+      return nil;
+    }
+    GMSMapPoint point = _points[i];
+    if (!GMUBoundsContainPoint(bounds, point)) continue;
     long col = (long)(numCells * (1.0 + point.x) / 2);  // point.x is in [-1, 1] range
     long row = (long)(numCells * (1.0 + point.y) / 2);  // point.y is in [-1, 1] range
-    long index = numCells * row + col;
-    NSNumber *cellKey = [NSNumber numberWithLong:index];
-    GMUStaticCluster *cluster = clusters[cellKey];
-    if (cluster == nil) {
+    // Points at x or y = 1 fall in an extra column or row, so keys leave room for it.
+    uint64_t key = (uint64_t)row * (uint64_t)(numCells + 1) + (uint64_t)col + 1;
+    uint32_t category = _categories[i];
+    size_t slot = GMUCellMapSlot(&cells, key, category);
+    if (cells.keys[slot] == 0) {
       // Normalize cluster's centroid to center of the cell.
       GMSMapPoint point2 = {(double)(col + 0.5) * 2.0 / numCells - 1,
                             (double)(row + 0.5) * 2.0 / numCells - 1};
       CLLocationCoordinate2D position = GMSUnproject(point2);
-      cluster = [[GMUStaticCluster alloc] initWithPosition:position];
-      clusters[cellKey] = cluster;
+      cells.keys[slot] = key;
+      cells.categories[slot] = category;
+      cells.clusterIndices[slot] = (uint32_t)clusters.count;
+      [clusters addObject:[[GMUStaticCluster alloc]
+                             initWithPosition:position
+                              clusterCategory:[_categoryTable categoryForNumber:category]
+                                   aggregates:_aggregates]];
     }
-    [cluster addItem:item];
+    [clusters[cells.clusterIndices[slot]] addItem:_items[i]];
   }
-  return [clusters allValues];
+  GMUCellMapFree(&cells);
+  return clusters;
 }
 
 @end
-
@@ -20,4 +20,6 @@
 
 - (UIImage *)tileForX:(NSUInteger)x y:(NSUInteger)y zoom:(NSUInteger)zoom;
 
+- (NSNumber *)maxValueForZoom:(NSUInteger)zoom;
+
 @end
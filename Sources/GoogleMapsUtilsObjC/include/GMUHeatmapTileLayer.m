@@ -25,9 +25,90 @@
 
 static const int kGMUTileSize = 512;
 static const int kGMUMaxZoom = 22;
+static const GQTBounds kGMUWorldBounds = {-1, -1, 1, 1};
 
 static void FreeDataProviderData(void *info, const void *data, size_t size) { free((void *)data); }
 
+// Quads deeper than this are smaller than any bucket of the zoom levels of the layer.
+static const NSUInteger kGMUMaxBucketDepth = 48;
+
+// Returns the index of the bucket of |bucketSize| holding |coordinate| along its axis.
+static inline int GMUBucketIndex(double coordinate, double bucketSize) {
+  return (int)((coordinate + 1) / bucketSize);
+}
+
+// An open addressing hash map from buckets to the total intensity of their points.
+typedef struct {
+  uint64_t *keys;
+  double *weights;
+  size_t count;
+  size_t mask;
+} GMUBucketMap;
+
+// Marks an empty slot. Bucket indices are never negative, so no bucket has this key.
+static const uint64_t kGMUEmptyBucketKey = UINT64_MAX;
+
+static void GMUBucketMapAllocate(GMUBucketMap *map, size_t capacity) {
+  map->keys = malloc(capacity * sizeof(uint64_t));
+  map->weights = malloc(capacity * sizeof(double));
+  if (map->keys == NULL || map->weights == NULL) {
+    abort();
+  }
+  for (size_t i = 0; i < capacity; ++i) {
+    map->keys[i] = kGMUEmptyBucketKey;
+  }
+  map->count = 0;
+  map->mask = capacity - 1;
+}
+
+static void GMUBucketMapInit(GMUBucketMap *map) { GMUBucketMapAllocate(map, 1024); }
+
+static void GMUBucketMapFree(GMUBucketMap *map) {
+  free(map->keys);
+  free(map->weights);
+}
+
+// Returns the slot holding |key|, or the empty slot it goes in.
+static size_t GMUBucketMapSlot(const GMUBucketMap *map, uint64_t key) {
+  size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & map->mask;
+  while (map->keys[slot] != kGMUEmptyBucketKey && map->keys[slot] != key) {
+    slot = (slot + 1) & map->mask;
+  }
+  return slot;
+}
+
+static void GMUBucketMapAdd(GMUBucketMap *map, int x, int y, double weight) {
+  if (2 * (map->count + 1) > map->mask + 1) {
+    GMUBucketMap grown;
+    GMUBucketMapAllocate(&grown, 2 * (map->mask + 1));
+    for (size_t i = 0; i <= map->mask; ++i) {
+      if (map->keys[i] == kGMUEmptyBucketKey) continue;
+      size_t slot = GMUBucketMapSlot(&grown, map->keys[i]);
+      grown.keys[slot] = map->keys[i];
+      grown.weights[slot] = map->weights[i];
+    }
+    grown.count = map->count;
+    GMUBucketMapFree(map);
+    *map = grown;
+  }
+  uint64_t key = ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+  size_t slot = GMUBucketMapSlot(map, key);
+  if (map->keys[slot] == kGMUEmptyBucketKey) {
+    map->keys[slot] = key;
+    map->weights[slot] = 0;
+    ++map->count;
+  }
+  map->weights[slot] += weight;
+}
+
+static double GMUBucketMapMaxWeight(const GMUBucketMap *map) {
+  double max = 0;
+  for (size_t i = 0; i <= map->mask; ++i) {
+    if (map->keys[i] != kGMUEmptyBucketKey && map->weights[i] > max) max = map->weights[i];
+  }
+  return max;
+}
+
 // Holder for data which must be consistent when accessed from tile creation threads.
 @interface GMUHeatmapTileCreationData : NSObject {
  @public
@@ -48,6 +129,10 @@ static void FreeDataProviderData(void *info, const void *data, size_t size) { fr
 @implementation GMUHeatmapTileLayer {
   BOOL _dirty;
   GMUHeatmapTileCreationData *_data;
+  // Index of |_weightedData|, nil until the next call to prepare after the data changes. Tile
+  // creation threads only ever see immutable copies of it.
+  GQTPointQuadTree *_quadTree;
+  GQTBounds _bounds;
 }
 
 - (instancetype)init {
@@ -94,6 +179,7 @@ static void FreeDataProviderData(void *info, const void *data, size_t size) { fr
 
 - (void)setWeightedData:(NSArray<GMUWeightedLatLng *> *)weightedData {
   _weightedData = [weightedData copy];
+  _quadTree = nil;
   _dirty = YES;
 }
 
@@ -138,24 +224,40 @@ static void FreeDataProviderData(void *info, const void *data, size_t size) { fr
   // TODO: apply magical factor squared to the final result rather than changing the bucket size?
   double magicalFactor = 0.5;
   double bucketSize = _radius / 128.0 / pow(2, zoom) * magicalFactor;
-  NSMutableDictionary<NSNumber *, NSMutableDictionary<NSNumber *, NSNumber *> *> *lookupX =
-      [NSMutableDictionary dictionary];
-  float max = 0;
-  for (GMUWeightedLatLng *dataPoint in _weightedData) {
-    GQTPoint point = [dataPoint point];
-    NSNumber *xBucket = @((int)((point.x + 1) / bucketSize));
-    NSNumber *yBucket = @((int)((point.y + 1) / bucketSize));
-    NSMutableDictionary<NSNumber *, NSNumber *> *lookupY = lookupX[xBucket];
-    if (!lookupY) {
-      lookupY = [NSMutableDictionary dictionary];
-      lookupX[xBucket] = lookupY;
-    }
-    NSNumber *value = lookupY[yBucket];
-    float newValue = [value floatValue] + dataPoint.intensity;
-    if (newValue > max) max = newValue;
-    lookupY[yBucket] = @(newValue);
+  // Buckets are read from the aggregates of the quads of the world sized tree at the first depth
+  // whose quads are no larger than a bucket. A quad whose points all fall in one bucket adds its
+  // weight at once, and only the points of quads crossing a bucket edge are bucketed one by one.
+  // The bounds of the points of a quad contain no point of another quad, since points on a quad
+  // edge belong to one side only.
+  NSUInteger depth = 0;
+  while (depth < kGMUMaxBucketDepth && 2.0 / pow(2, depth) > bucketSize) {
+    ++depth;
   }
-  return @(max);
+  GMUBucketMap buckets;
+  GMUBucketMapInit(&buckets);
+  GMUBucketMap *bucketsPointer = &buckets;
+  GQTPointQuadTree *quadTree = _quadTree;
+  [quadTree enumerateAggregatesInBounds:kGMUWorldBounds
+                                  depth:depth
+                             usingBlock:^(GQTAggregate aggregate, BOOL *stop) {
+    GQTBounds bounds = aggregate.bounds;
+    int minXBucket = GMUBucketIndex(bounds.minX, bucketSize);
+    int minYBucket = GMUBucketIndex(bounds.minY, bucketSize);
+    if (minXBucket == GMUBucketIndex(bounds.maxX, bucketSize) &&
+        minYBucket == GMUBucketIndex(bounds.maxY, bucketSize)) {
+      GMUBucketMapAdd(bucketsPointer, minXBucket, minYBucket, aggregate.weight);
+      return;
+    }
+    [quadTree enumerateItemsInBounds:bounds
+                          usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                       BOOL *stopItems) {
+      GMUBucketMapAdd(bucketsPointer, GMUBucketIndex(point.x, bucketSize),
+                      GMUBucketIndex(point.y, bucketSize), ((GMUWeightedLatLng *)item).intensity);
+    }];
+  }];
+  double max = GMUBucketMapMaxWeight(&buckets);
+  GMUBucketMapFree(&buckets);
+  return @((float)max);
 }
 
 - (NSArray<NSNumber *> *)calculateIntensities {
@@ -188,12 +290,16 @@ static void FreeDataProviderData(void *info, const void *data, size_t size) { fr
 }
 
 - (void)prepare {
-  GMUHeatmapTileCreationData *data = [[GMUHeatmapTileCreationData alloc] init];
-  data->_bounds = [self calculateBounds];
-  data->_quadTree = [[GQTPointQuadTree alloc] initWithBounds:data->_bounds];
-  for (GMUWeightedLatLng *dataPoint in _weightedData) {
-    [data->_quadTree add:dataPoint];
+  if (!_quadTree) {
+    _bounds = [self calculateBounds];
+    _quadTree = [[GQTPointQuadTree alloc] initWithBounds:kGMUWorldBounds keepsAggregates:YES];
+    [_quadTree addItems:_weightedData];
   }
+  GMUHeatmapTileCreationData *data = [[GMUHeatmapTileCreationData alloc] init];
+  data->_bounds = _bounds;
+  // Changing only the radius, gradient or zoom intensities reuses the index. The copy is a
+  // snapshot sharing the data of |_quadTree|, which tile threads can search without locking.
+  data->_quadTree = [_quadTree copy];
   data->_colorMap = [_gradient generateColorMap];
   data->_maxIntensities = [self calculateIntensities];
   data->_kernel = [self generateKernel];
@@ -220,64 +326,33 @@ static void FreeDataProviderData(void *info, const void *data, size_t size) { fr
   double maxY = 1 - y * tileWidth + padding;
   double minY = 1 - (y + 1) * tileWidth - padding;
 
-  double wrappedPointsOffset = 0;
-  NSArray<GMUWeightedLatLng *> *wrappedPoints;
-  if (minX < -1) {
-    GQTBounds wrappedBounds;
-    wrappedBounds.minX = minX + 2;
-    wrappedBounds.maxX = 1.0;
-    wrappedBounds.minY = minY;
-    wrappedBounds.maxY = maxY;
-    wrappedPoints = [data->_quadTree searchWithBounds:wrappedBounds];
-    wrappedPointsOffset = -2;
-  } else if (maxX > 1) {
-    GQTBounds wrappedBounds;
-    wrappedBounds.minX = -1.0;
-    wrappedBounds.maxX = maxX - 2.0;
-    wrappedBounds.minY = minY;
-    wrappedBounds.maxY = maxY;
-    wrappedPoints = [data->_quadTree searchWithBounds:wrappedBounds];
-    wrappedPointsOffset = 2;
-  }
-  GQTBounds bounds;
-  bounds.minX = minX;
-  bounds.maxX = maxX;
-  bounds.minY = minY;
-  bounds.maxY = maxY;
-  NSArray<GMUWeightedLatLng *> *points = [data->_quadTree searchWithBounds:bounds];
+  // Tiles next to the antimeridian are padded with points from the other side of the world.
+  GQTBounds bounds = {minX, minY, maxX, maxY};
   // If there is no data at all return empty tile.
-  if (points.count + wrappedPoints.count == 0) {
+  if ([data->_quadTree countInWrappedBounds:bounds] == 0) {
     return kGMSTileLayerNoTile;
   }
 
   // Quantize points.
   int paddedTileSize = kGMUTileSize + 2 * (int)data->_radius;
   float *intensity = calloc(paddedTileSize * paddedTileSize, sizeof(float));
-  for (GMUWeightedLatLng *item in points) {
-    GQTPoint p = [item point];
-    int x = (int)((p.x - minX) / bucketWidth);
-    // Flip y axis as world space goes south to north, but tile content goes north to south.
-    int y = (int)((maxY - p.y) / bucketWidth);
-    // If the point is just on the edge of the query area, the bucketing could put it outside
-    // bounds.
-    if (x >= paddedTileSize) x = paddedTileSize - 1;
-    if (y >= paddedTileSize) y = paddedTileSize - 1;
-    intensity[y * paddedTileSize + x] += item.intensity;
-  }
-  for (GMUWeightedLatLng *item in wrappedPoints) {
-    GQTPoint p = [item point];
-    int x = (int)((p.x + wrappedPointsOffset - minX) / bucketWidth);
-    // Flip y axis as world space goes south to north, but tile content goes north to south.
-    int y = (int)((maxY - p.y) / bucketWidth);
-    // If the point is just on the edge of the query area, the bucketing could put it outside
-    // bounds.
-    if (x >= paddedTileSize) x = paddedTileSize - 1;
-    if (y >= paddedTileSize) y = paddedTileSize - 1;
-    // For wrapped points, additional shifting risks bucketing slipping just outside due to
-    // numerical instability.
-    if (x < 0) x = 0;
-    intensity[y * paddedTileSize + x] += item.intensity;
-  }
+  [data->_quadTree
+      enumerateItemsInWrappedBounds:bounds
+                         usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint p, double offsetX,
+                                      BOOL *stop) {
+                           int x = (int)((p.x - minX) / bucketWidth);
+                           // Flip y axis as world space goes south to north, but tile content
+                           // goes north to south.
+                           int y = (int)((maxY - p.y) / bucketWidth);
+                           // If the point is just on the edge of the query area, the bucketing
+                           // could put it outside bounds. For wrapped points, the shifting also
+                           // risks bucketing slipping just outside due to numerical instability.
+                           if (x >= paddedTileSize) x = paddedTileSize - 1;
+                           if (y >= paddedTileSize) y = paddedTileSize - 1;
+                           if (x < 0) x = 0;
+                           intensity[y * paddedTileSize + x] +=
+                               ((GMUWeightedLatLng *)item).intensity;
+                         }];
 
   // Convolve data.
   int lowerLimit = (int)data->_radius;
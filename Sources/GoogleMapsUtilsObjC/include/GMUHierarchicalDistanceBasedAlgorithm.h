@@ -0,0 +1,57 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUClusterAlgorithm.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A distance based clustering algorithm which computes the clusters of every zoom level once, so
+ * that clustersAtZoom: only has to read them back. Resulting clusters are hierarchical: every
+ * cluster is made of whole clusters of the next zoom level.
+ * High level algorithm, run by the first clustersAtZoom: call after items are added or removed:
+ * 1. Start at maxZoom + 1 with every item in a cluster of its own.
+ * 2. For each zoom level from maxZoom down to 0, iterate over the clusters of the level above.
+ * 3. Merge each cluster which is not part of a new cluster yet with all other such clusters
+ *    within clusterDistancePoints of it, including across the antimeridian.
+ * 4. Place the new cluster at the centroid of its items.
+ * 5. Index the clusters of the level so that the next level can find neighbouring clusters.
+ * Building takes O(n log n) time per zoom level. clustersAtZoom: then takes time proportional to
+ * the number of clusters it returns, and the items of a cluster are only gathered when read.
+ * clustersAtZoom:inBounds: finds the clusters within the bounds through the index of step 5.
+ * Items added through addItemsWithCoordinates:identifiers:count: are kept as a coordinate and an
+ * identifier, and objects are only created for them when the items of a cluster are read.
+ */
+@interface GMUHierarchicalDistanceBasedAlgorithm : NSObject<GMUClusterAlgorithm>
+
+/**
+ * Initializes this GMUHierarchicalDistanceBasedAlgorithm with clusterDistancePoints for the
+ * distance it uses to cluster items (default is 100).
+ */
+- (instancetype)initWithClusterDistancePoints:(NSUInteger)clusterDistancePoints;
+
+/**
+ * Initializes this GMUHierarchicalDistanceBasedAlgorithm with clusterDistancePoints for the
+ * distance it uses to cluster items (default is 100), and the highest zoom level at which items
+ * are clustered (default is 20). Above |maxZoom| every item is a cluster of its own.
+ */
+- (instancetype)initWithClusterDistancePoints:(NSUInteger)clusterDistancePoints
+                                      maxZoom:(NSUInteger)maxZoom;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,914 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUHierarchicalDistanceBasedAlgorithm.h"
+
+#import <GoogleMaps/GMSGeometryUtils.h>
+
+#import "GMUClusterAggregateAccumulator.h"
+#import "GMUClusterCategoryTable.h"
+#import "GMUClusterItem.h"
+#import "GMUMapPointBounds.h"
+#import "GMUPackedClusterItem.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const NSUInteger kGMUDefaultClusterDistancePoints = 100;
+static const NSUInteger kGMUDefaultMaxZoom = 20;
+// Map points stop halving well before this zoom level.
+static const NSUInteger kGMUMaxMaxZoom = 40;
+
+// Ranges of a level index holding at most this many nodes are searched linearly.
+static const ptrdiff_t kGMULevelIndexLeafSize = 64;
+
+// Marks the absence of a node.
+#define kGMUNullNode UINT32_MAX
+
+#pragma mark Hierarchy
+
+// A growable list of node indices.
+typedef struct {
+  uint32_t *nodes;
+  size_t count;
+  size_t capacity;
+} GMUNodeList;
+
+// The clusters of one zoom level, as the indices of their nodes. The indices are arranged as a
+// static k-d tree: the middle entry of every range longer than kGMULevelIndexLeafSize splits the
+// rest of the range by x at even depths and by y at odd depths.
+typedef struct {
+  uint32_t *nodes;
+  size_t count;
+} GMUClusterLevel;
+
+// The clusters of every zoom level. Node i < itemCount is the cluster made of item i alone. Later
+// nodes are clusters made of the nodes linked from firstChildren through nextSiblings.
+typedef struct {
+  uint32_t itemCount;
+  uint32_t nodeCount;
+  // Position of each node in map points, which is the centroid of its items for clusters.
+  double *xs;
+  double *ys;
+  // Number of items below each node.
+  uint32_t *counts;
+  // Category number of each node, or NULL if all items are of the same category.
+  uint32_t *categories;
+  uint32_t *firstChildren;
+  uint32_t *nextSiblings;
+  // Item indices in depth-first order of the hierarchy, so that the items below every node are
+  // contiguous. itemStarts holds the position of the first item of each node.
+  uint32_t *orderedItems;
+  uint32_t *itemStarts;
+  // levels[z] holds the clusters at zoom z, for z up to maxZoom + 1 where every item is a cluster
+  // of its own. A level in which nothing was merged shares the nodes of the level above.
+  GMUClusterLevel *levels;
+  uint32_t maxZoom;
+} GMUClusterHierarchy;
+
+static void *GMUReallocArray(void *array, size_t count, size_t size) {
+  void *result = realloc(array, count * size);
+  if (result == NULL && count > 0) {
+    abort();
+  }
+  return result;
+}
+
+static void GMUAppendNode(GMUNodeList *list, uint32_t node) {
+  if (list->count == list->capacity) {
+    list->capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+    list->nodes = GMUReallocArray(list->nodes, list->capacity, sizeof(uint32_t));
+  }
+  list->nodes[list->count++] = node;
+}
+
+// Returns |x| - |originX|, going across the antimeridian when that is shorter.
+static inline double GMUWrappedDeltaX(double x, double originX) {
+  double delta = x - originX;
+  if (delta > kGMUMapPointWidth / 2) return delta - kGMUMapPointWidth;
+  if (delta < -kGMUMapPointWidth / 2) return delta + kGMUMapPointWidth;
+  return delta;
+}
+
+static inline void GMUSwapNodes(uint32_t *nodes, ptrdiff_t i, ptrdiff_t j) {
+  uint32_t node = nodes[i];
+  nodes[i] = nodes[j];
+  nodes[j] = node;
+}
+
+// Rearranges nodes[left...right] so that nodes[k] has the k-th smallest of |coordinates|, with
+// no larger coordinate before it and no smaller one after it. This is Floyd and Rivest's
+// selection algorithm, which recurses on a sample to pick a pivot close to the k-th element.
+static void GMUSelectNode(uint32_t *nodes, const double *coordinates, ptrdiff_t k, ptrdiff_t left,
+                          ptrdiff_t right) {
+  while (right > left) {
+    if (right - left > 600) {
+      double n = right - left + 1;
+      double m = k - left + 1;
+      double z = log(n);
+      double s = 0.5 * exp(2 * z / 3);
+      double sd = 0.5 * sqrt(z * s * (n - s) / n) * (m - n / 2 < 0 ? -1 : 1);
+      ptrdiff_t sampleLeft = MAX(left, (ptrdiff_t)floor(k - m * s / n + sd));
+      ptrdiff_t sampleRight = MIN(right, (ptrdiff_t)floor(k + (n - m) * s / n + sd));
+      GMUSelectNode(nodes, coordinates, k, sampleLeft, sampleRight);
+    }
+    double pivot = coordinates[nodes[k]];
+    ptrdiff_t i = left;
+    ptrdiff_t j = right;
+    GMUSwapNodes(nodes, left, k);
+    if (coordinates[nodes[right]] > pivot) GMUSwapNodes(nodes, left, right);
+    while (i < j) {
+      GMUSwapNodes(nodes, i, j);
+      ++i;
+      --j;
+      while (coordinates[nodes[i]] < pivot) ++i;
+      while (coordinates[nodes[j]] > pivot) --j;
+    }
+    if (coordinates[nodes[left]] == pivot) {
+      GMUSwapNodes(nodes, left, j);
+    } else {
+      ++j;
+      GMUSwapNodes(nodes, j, right);
+    }
+    if (j <= k) left = j + 1;
+    if (k <= j) right = j - 1;
+  }
+}
+
+// Arranges nodes[left...right] as a k-d tree, split by y if |byY| is set and by x otherwise.
+static void GMUSortLevel(const GMUClusterHierarchy *hierarchy, uint32_t *nodes, ptrdiff_t left,
+                         ptrdiff_t right, bool byY) {
+  if (right - left <= kGMULevelIndexLeafSize) return;
+  ptrdiff_t middle = left + (right - left) / 2;
+  GMUSelectNode(nodes, byY ? hierarchy->ys : hierarchy->xs, middle, left, right);
+  GMUSortLevel(hierarchy, nodes, left, middle - 1, !byY);
+  GMUSortLevel(hierarchy, nodes, middle + 1, right, !byY);
+}
+
+// Appends the nodes of |level| within the inclusive bounds to |results|.
+static void GMUSearchLevel(const GMUClusterHierarchy *hierarchy, const GMUClusterLevel *level,
+                           double minX, double minY, double maxX, double maxY,
+                           GMUNodeList *results) {
+  if (level->count == 0) return;
+  // Ranges left to search. Every step pops one range and pushes at most two, one level deeper, so
+  // the stack never holds more ranges than twice the depth of the tree.
+  struct {
+    ptrdiff_t left;
+    ptrdiff_t right;
+    bool byY;
+  } stack[128];
+  size_t depth = 0;
+  stack[depth].left = 0;
+  stack[depth].right = (ptrdiff_t)level->count - 1;
+  stack[depth++].byY = false;
+  while (depth > 0) {
+    --depth;
+    ptrdiff_t left = stack[depth].left;
+    ptrdiff_t right = stack[depth].right;
+    bool byY = stack[depth].byY;
+    if (right - left <= kGMULevelIndexLeafSize) {
+      for (ptrdiff_t i = left; i <= right; ++i) {
+        uint32_t node = level->nodes[i];
+        double x = hierarchy->xs[node];
+        double y = hierarchy->ys[node];
+        if (x >= minX && x <= maxX && y >= minY && y <= maxY) {
+          GMUAppendNode(results, node);
+        }
+      }
+      continue;
+    }
+    ptrdiff_t middle = left + (right - left) / 2;
+    uint32_t node = level->nodes[middle];
+    double x = hierarchy->xs[node];
+    double y = hierarchy->ys[node];
+    if (x >= minX && x <= maxX && y >= minY && y <= maxY) {
+      GMUAppendNode(results, node);
+    }
+    if (byY ? minY <= y : minX <= x) {
+      stack[depth].left = left;
+      stack[depth].right = middle - 1;
+      stack[depth++].byY = !byY;
+    }
+    if (byY ? maxY >= y : maxX >= x) {
+      stack[depth].left = middle + 1;
+      stack[depth].right = right;
+      stack[depth++].byY = !byY;
+    }
+  }
+}
+
+// Appends the nodes of |level| within the inclusive bounds to |results|. The bounds may extend
+// past the antimeridian, in which case they continue on the other side.
+static void GMUSearchLevelWrapped(const GMUClusterHierarchy *hierarchy,
+                                  const GMUClusterLevel *level, double minX, double minY,
+                                  double maxX, double maxY, GMUNodeList *results) {
+  if (maxX - minX >= kGMUMapPointWidth) {
+    GMUSearchLevel(hierarchy, level, -1, minY, 1, maxY, results);
+    return;
+  }
+  // The windows do not overlap since the bounds are narrower than the world.
+  GMUSearchLevel(hierarchy, level, minX, minY, maxX, maxY, results);
+  if (minX < -1) {
+    GMUSearchLevel(hierarchy, level, minX + kGMUMapPointWidth, minY, 1, maxY, results);
+  }
+  if (maxX > 1) {
+    GMUSearchLevel(hierarchy, level, -1, minY, maxX - kGMUMapPointWidth, maxY, results);
+  }
+}
+
+// Appends the nodes of |level| which are no further than |radius| from (x, y) along either axis,
+// including those across the antimeridian, to |results|.
+static void GMUSearchLevelAround(const GMUClusterHierarchy *hierarchy,
+                                 const GMUClusterLevel *level, double x, double y, double radius,
+                                 GMUNodeList *results) {
+  GMUSearchLevelWrapped(hierarchy, level, x - radius, y - radius, x + radius, y + radius,
+                        results);
+}
+
+// Computes the clusters of level |zoom| from those of the level above. Returns whether any
+// clusters were merged.
+static bool GMUBuildLevel(GMUClusterHierarchy *hierarchy, uint32_t zoom, double radius,
+                          uint32_t *marks, GMUNodeList *neighbours) {
+  const GMUClusterLevel *above = &hierarchy->levels[zoom + 1];
+  GMUClusterLevel *level = &hierarchy->levels[zoom];
+  level->nodes = GMUReallocArray(NULL, above->count, sizeof(uint32_t));
+  level->count = 0;
+  uint32_t *categories = hierarchy->categories;
+  // Nodes which are already part of a cluster of this level are marked with zoom + 1.
+  uint32_t mark = zoom + 1;
+  bool merged = false;
+  for (size_t i = 0; i < above->count; ++i) {
+    uint32_t node = above->nodes[i];
+    if (marks[node] == mark) continue;
+    marks[node] = mark;
+
+    neighbours->count = 0;
+    GMUSearchLevelAround(hierarchy, above, hierarchy->xs[node], hierarchy->ys[node], radius,
+                         neighbours);
+    uint32_t cluster = kGMUNullNode;
+    double x = hierarchy->xs[node];
+    double y = hierarchy->ys[node];
+    double weightedDeltaX = 0;
+    double weightedY = hierarchy->counts[node] * y;
+    for (size_t j = 0; j < neighbours->count; ++j) {
+      uint32_t neighbour = neighbours->nodes[j];
+      if (marks[neighbour] == mark) continue;
+      if (categories && categories[neighbour] != categories[node]) continue;
+      marks[neighbour] = mark;
+      if (cluster == kGMUNullNode) {
+        cluster = hierarchy->nodeCount++;
+        hierarchy->counts[cluster] = hierarchy->counts[node];
+        if (categories) {
+          categories[cluster] = categories[node];
+        }
+        hierarchy->firstChildren[cluster] = node;
+        hierarchy->nextSiblings[node] = kGMUNullNode;
+      }
+      uint32_t count = hierarchy->counts[neighbour];
+      hierarchy->counts[cluster] += count;
+      hierarchy->nextSiblings[neighbour] = hierarchy->firstChildren[cluster];
+      hierarchy->firstChildren[cluster] = neighbour;
+      weightedDeltaX += count * GMUWrappedDeltaX(hierarchy->xs[neighbour], x);
+      weightedY += count * hierarchy->ys[neighbour];
+    }
+    if (cluster == kGMUNullNode) {
+      level->nodes[level->count++] = node;
+      continue;
+    }
+    double clusterX = x + weightedDeltaX / hierarchy->counts[cluster];
+    if (clusterX > 1) {
+      clusterX -= kGMUMapPointWidth;
+    } else if (clusterX < -1) {
+      clusterX += kGMUMapPointWidth;
+    }
+    hierarchy->xs[cluster] = clusterX;
+    hierarchy->ys[cluster] = weightedY / hierarchy->counts[cluster];
+    level->nodes[level->count++] = cluster;
+    merged = true;
+  }
+  if (!merged) {
+    free(level->nodes);
+    *level = *above;
+    return false;
+  }
+  level->nodes = GMUReallocArray(level->nodes, level->count, sizeof(uint32_t));
+  GMUSortLevel(hierarchy, level->nodes, 0, (ptrdiff_t)level->count - 1, false);
+  return true;
+}
+
+// Lays out the items of the hierarchy in depth-first order.
+static void GMUOrderItems(GMUClusterHierarchy *hierarchy) {
+  uint32_t *stack = GMUReallocArray(NULL, hierarchy->nodeCount, sizeof(uint32_t));
+  uint32_t position = 0;
+  const GMUClusterLevel *roots = &hierarchy->levels[0];
+  for (size_t i = 0; i < roots->count; ++i) {
+    size_t depth = 0;
+    stack[depth++] = roots->nodes[i];
+    while (depth > 0) {
+      uint32_t node = stack[--depth];
+      hierarchy->itemStarts[node] = position;
+      if (node < hierarchy->itemCount) {
+        hierarchy->orderedItems[position++] = node;
+        continue;
+      }
+      for (uint32_t child = hierarchy->firstChildren[node]; child != kGMUNullNode;
+           child = hierarchy->nextSiblings[child]) {
+        stack[depth++] = child;
+      }
+    }
+  }
+  free(stack);
+}
+
+static void GMUClusterHierarchyFree(GMUClusterHierarchy *hierarchy) {
+  if (hierarchy == NULL) return;
+  for (uint32_t zoom = 0; zoom <= hierarchy->maxZoom + 1; ++zoom) {
+    // Shared levels are freed with the highest level using their nodes.
+    if (zoom == hierarchy->maxZoom + 1 ||
+        hierarchy->levels[zoom].nodes != hierarchy->levels[zoom + 1].nodes) {
+      free(hierarchy->levels[zoom].nodes);
+    }
+  }
+  free(hierarchy->levels);
+  free(hierarchy->xs);
+  free(hierarchy->ys);
+  free(hierarchy->counts);
+  free(hierarchy->categories);
+  free(hierarchy->firstChildren);
+  free(hierarchy->nextSiblings);
+  free(hierarchy->orderedItems);
+  free(hierarchy->itemStarts);
+  free(hierarchy);
+}
+
+// Returns whether the work it is passed to should stop, given the context passed along with it.
+typedef bool (*GMUShouldStopFunction)(void *context);
+
+// Builds the hierarchy of |itemCount| items at |points|, merging clusters no further than
+// |clusterDistance| map points apart at zoom 0, and half as far at every following zoom level.
+// Unless |categories| is NULL, only clusters of the same category number are merged.
+// Unless |shouldStop| is NULL, it is called with |context| before each level is built, and the
+// build is abandoned and NULL returned as soon as it returns true.
+static GMUClusterHierarchy *GMUClusterHierarchyCreate(const GMSMapPoint *points,
+                                                      const uint32_t *categories,
+                                                      uint32_t itemCount, double clusterDistance,
+                                                      uint32_t maxZoom,
+                                                      GMUShouldStopFunction shouldStop,
+                                                      void *context) {
+  GMUClusterHierarchy *hierarchy = calloc(1, sizeof(GMUClusterHierarchy));
+  if (hierarchy == NULL) {
+    abort();
+  }
+  // Every merge adds one node and removes at least two from the level, so there are fewer than
+  // twice as many nodes as items.
+  size_t capacity = 2 * (size_t)itemCount;
+  hierarchy->itemCount = itemCount;
+  hierarchy->nodeCount = itemCount;
+  hierarchy->maxZoom = maxZoom;
+  hierarchy->xs = GMUReallocArray(NULL, capacity, sizeof(double));
+  hierarchy->ys = GMUReallocArray(NULL, capacity, sizeof(double));
+  hierarchy->counts = GMUReallocArray(NULL, capacity, sizeof(uint32_t));
+  if (categories) {
+    hierarchy->categories = GMUReallocArray(NULL, capacity, sizeof(uint32_t));
+    memcpy(hierarchy->categories, categories, itemCount * sizeof(uint32_t));
+  }
+  hierarchy->firstChildren = GMUReallocArray(NULL, capacity, sizeof(uint32_t));
+  hierarchy->nextSiblings = GMUReallocArray(NULL, capacity, sizeof(uint32_t));
+  hierarchy->orderedItems = GMUReallocArray(NULL, itemCount, sizeof(uint32_t));
+  hierarchy->itemStarts = GMUReallocArray(NULL, capacity, sizeof(uint32_t));
+  hierarchy->levels = calloc(maxZoom + 2, sizeof(GMUClusterLevel));
+  if (hierarchy->levels == NULL) {
+    abort();
+  }
+
+  GMUClusterLevel *top = &hierarchy->levels[maxZoom + 1];
+  top->nodes = GMUReallocArray(NULL, itemCount, sizeof(uint32_t));
+  top->count = itemCount;
+  for (uint32_t i = 0; i < itemCount; ++i) {
+    hierarchy->xs[i] = points[i].x;
+    hierarchy->ys[i] = points[i].y;
+    hierarchy->counts[i] = 1;
+    hierarchy->firstChildren[i] = kGMUNullNode;
+    top->nodes[i] = i;
+  }
+  GMUSortLevel(hierarchy, top->nodes, 0, (ptrdiff_t)itemCount - 1, false);
+
+  uint32_t *marks = calloc(capacity > 0 ? capacity : 1, sizeof(uint32_t));
+  if (marks == NULL) {
+    abort();
+  }
+  GMUNodeList neighbours = {NULL, 0, 0};
+  for (uint32_t zoom = maxZoom + 1; zoom-- > 0;) {
+    if (shouldStop != NULL && shouldStop(context)) {
+      free(neighbours.nodes);
+      free(marks);
+      GMUClusterHierarchyFree(hierarchy);
+      return NULL;
+    }
+    GMUBuildLevel(hierarchy, zoom, clusterDistance / pow(2.0, zoom), marks, &neighbours);
+  }
+  free(neighbours.nodes);
+  free(marks);
+  GMUOrderItems(hierarchy);
+  return hierarchy;
+}
+
+// A GMUShouldStopFunction stopping once the GMUClusterCancellationToken passed as |context| is
+// cancelled.
+static bool GMUTokenIsCancelled(void *context) {
+  return ((__bridge GMUClusterCancellationToken *)context).isCancelled;
+}
+
+#pragma mark Clusters
+
+// The items of a hierarchy in hierarchy order. Packed items are only turned into objects when
+// read. It is never mutated, so clusters can keep it after the items of the algorithm change.
+@interface GMUOrderedItems : NSObject
+
+// Takes ownership of |coordinates| and |identifiers|, which are NULL if no item is packed.
+// |objectItems| holds NSNull in place of packed items, and is nil if every item is packed.
+- (instancetype)initWithCoordinates:(CLLocationCoordinate2D *)coordinates
+                        identifiers:(int64_t *)identifiers
+                        objectItems:(NSArray *)objectItems;
+
+- (NSArray<id<GMUClusterItem>> *)itemsInRange:(NSRange)range;
+
+@end
+
+@implementation GMUOrderedItems {
+  CLLocationCoordinate2D *_coordinates;
+  int64_t *_identifiers;
+  NSArray *_objectItems;
+}
+
+- (instancetype)initWithCoordinates:(CLLocationCoordinate2D *)coordinates
+                        identifiers:(int64_t *)identifiers
+                        objectItems:(NSArray *)objectItems {
+  if ((self = [super init])) {
+    _coordinates = coordinates;
+    _identifiers = identifiers;
+    _objectItems = objectItems;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  free(_coordinates);
+  free(_identifiers);
+}
+
+- (NSArray<id<GMUClusterItem>> *)itemsInRange:(NSRange)range {
+  if (_coordinates == NULL) return [_objectItems subarrayWithRange:range];
+  NSMutableArray<id<GMUClusterItem>> *items =
+      [[NSMutableArray alloc] initWithCapacity:range.length];
+  NSNull *null = [NSNull null];
+  for (NSUInteger i = range.location; i < NSMaxRange(range); ++i) {
+    id objectItem = _objectItems ? _objectItems[i] : null;
+    if (objectItem != null) {
+      [items addObject:objectItem];
+    } else {
+      [items addObject:[[GMUPackedClusterItem alloc] initWithIdentifier:_identifiers[i]
+                                                               position:_coordinates[i]]];
+    }
+  }
+  return items;
+}
+
+@end
+
+// The accumulators of the aggregates of every node of a hierarchy. It is never mutated, so clusters
+// can keep it after the items of the algorithm change.
+@interface GMUNodeAggregates : NSObject
+
+// Takes ownership of |accumulators|, which holds one accumulator per aggregate for every node.
+- (instancetype)initWithAggregates:(NSArray<GMUClusterAggregate *> *)aggregates
+                      accumulators:(GMUClusterAggregateAccumulator *)accumulators;
+
+- (NSDictionary<NSString *, NSNumber *> *)valuesOfNode:(uint32_t)node;
+
+@end
+
+@implementation GMUNodeAggregates {
+  NSArray<GMUClusterAggregate *> *_aggregates;
+  GMUClusterAggregateAccumulator *_accumulators;
+}
+
+- (instancetype)initWithAggregates:(NSArray<GMUClusterAggregate *> *)aggregates
+                      accumulators:(GMUClusterAggregateAccumulator *)accumulators {
+  if ((self = [super init])) {
+    _aggregates = aggregates;
+    _accumulators = accumulators;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  free(_accumulators);
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)valuesOfNode:(uint32_t)node {
+  return GMUAggregateValues(_aggregates, _accumulators + (size_t)node * _aggregates.count);
+}
+
+@end
+
+// A cluster of the hierarchy. Its items are a range of the items in hierarchy order, which is only
+// copied when the items are read. Its aggregate values are those of its node.
+@interface GMUHierarchicalCluster : NSObject<GMUCluster>
+
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position
+                 clusterCategory:(NSString *)clusterCategory
+                    orderedItems:(GMUOrderedItems *)orderedItems
+                           range:(NSRange)range
+                  nodeAggregates:(GMUNodeAggregates *)nodeAggregates
+                            node:(uint32_t)node;
+
+@property(nonatomic, readonly, copy) NSString *clusterCategory;
+
+@end
+
+@implementation GMUHierarchicalCluster {
+  GMUOrderedItems *_orderedItems;
+  NSRange _range;
+  GMUNodeAggregates *_nodeAggregates;
+  uint32_t _node;
+}
+
+@synthesize position = _position;
+
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position
+                 clusterCategory:(NSString *)clusterCategory
+                    orderedItems:(GMUOrderedItems *)orderedItems
+                           range:(NSRange)range
+                  nodeAggregates:(GMUNodeAggregates *)nodeAggregates
+                            node:(uint32_t)node {
+  if ((self = [super init])) {
+    _position = position;
+    _clusterCategory = [clusterCategory copy];
+    _orderedItems = orderedItems;
+    _range = range;
+    _nodeAggregates = nodeAggregates;
+    _node = node;
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _range.length;
+}
+
+- (NSArray<id<GMUClusterItem>> *)items {
+  return [_orderedItems itemsInRange:_range];
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)aggregateValues {
+  return _nodeAggregates ? [_nodeAggregates valuesOfNode:_node] : @{};
+}
+
+@end
+
+#pragma mark GMUHierarchicalDistanceBasedAlgorithm
+
+@implementation GMUHierarchicalDistanceBasedAlgorithm {
+  // Positions of the items in the order they were added, identifiers of the packed items and
+  // category numbers of all items.
+  CLLocationCoordinate2D *_coordinates;
+  int64_t *_identifiers;
+  uint32_t *_categories;
+  NSUInteger _itemCount;
+  NSUInteger _itemCapacity;
+  NSUInteger _packedItemCount;
+  // The items added as objects, with NSNull in place of packed items. nil while no item was added
+  // as an object.
+  NSMutableArray *_objectItems;
+  GMUClusterCategoryTable *_categoryTable;
+  NSUInteger _clusterDistancePoints;
+  NSUInteger _maxZoom;
+  // The hierarchy of the items, NULL until the next clustersAtZoom: call after the items changed.
+  GMUClusterHierarchy *_hierarchy;
+  // The items in hierarchy order, which clusters keep a reference to.
+  GMUOrderedItems *_orderedItems;
+  // The aggregates of the nodes of the hierarchy, or nil without aggregates.
+  GMUNodeAggregates *_nodeAggregates;
+}
+
+@synthesize aggregates = _aggregates;
+
+- (instancetype)init {
+  return [self initWithClusterDistancePoints:kGMUDefaultClusterDistancePoints];
+}
+
+- (instancetype)initWithClusterDistancePoints:(NSUInteger)clusterDistancePoints {
+  return [self initWithClusterDistancePoints:clusterDistancePoints maxZoom:kGMUDefaultMaxZoom];
+}
+
+- (instancetype)initWithClusterDistancePoints:(NSUInteger)clusterDistancePoints
+                                      maxZoom:(NSUInteger)maxZoom {
+  if ((self = [super init])) {
+    _categoryTable = [[GMUClusterCategoryTable alloc] init];
+    _aggregates = @[];
+    _clusterDistancePoints = clusterDistancePoints;
+    _maxZoom = MIN(maxZoom, kGMUMaxMaxZoom);
+  }
+  return self;
+}
+
+- (void)dealloc {
+  GMUClusterHierarchyFree(_hierarchy);
+  free(_coordinates);
+  free(_identifiers);
+  free(_categories);
+}
+
+- (void)addItems:(NSArray<id<GMUClusterItem>> *)items {
+  if (items.count == 0) return;
+  [self reserveItemCapacity:_itemCount + items.count];
+  if (_objectItems == nil) {
+    _objectItems = [[NSMutableArray alloc] initWithCapacity:_itemCount + items.count];
+    for (NSUInteger i = 0; i < _itemCount; ++i) {
+      [_objectItems addObject:[NSNull null]];
+    }
+  }
+  for (id<GMUClusterItem> item in items) {
+    _coordinates[_itemCount] = item.position;
+    _identifiers[_itemCount] = 0;
+    _categories[_itemCount] = [_categoryTable numberForCategoryOfItem:item];
+    ++_itemCount;
+  }
+  [_objectItems addObjectsFromArray:items];
+  [self invalidateHierarchy];
+}
+
+/**
+ * Adds |count| packed items, which have no category. They take 28 bytes each, and objects are only
+ * created for them when the items of a cluster are read.
+ */
+- (void)addItemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+                    identifiers:(const int64_t *)identifiers
+                          count:(NSUInteger)count {
+  if (count == 0) return;
+  [self reserveItemCapacity:_itemCount + count];
+  memcpy(_coordinates + _itemCount, coordinates, count * sizeof(CLLocationCoordinate2D));
+  memcpy(_identifiers + _itemCount, identifiers, count * sizeof(int64_t));
+  memset(_categories + _itemCount, 0, count * sizeof(uint32_t));
+  if (_objectItems != nil) {
+    for (NSUInteger i = 0; i < count; ++i) {
+      [_objectItems addObject:[NSNull null]];
+    }
+  }
+  _itemCount += count;
+  _packedItemCount += count;
+  [self invalidateHierarchy];
+}
+
+/**
+ * Removes the most recently added item equal to |item|. A GMUPackedClusterItem also removes the
+ * packed item with its identifier.
+ */
+- (void)removeItem:(id<GMUClusterItem>)item {
+  NSUInteger index = [self indexOfLastItemEqualToItem:item];
+  if (index == NSNotFound) return;
+  if (_objectItems == nil || _objectItems[index] == [NSNull null]) {
+    --_packedItemCount;
+  }
+  NSUInteger tailCount = _itemCount - index - 1;
+  memmove(_coordinates + index, _coordinates + index + 1,
+          tailCount * sizeof(CLLocationCoordinate2D));
+  memmove(_identifiers + index, _identifiers + index + 1, tailCount * sizeof(int64_t));
+  memmove(_categories + index, _categories + index + 1, tailCount * sizeof(uint32_t));
+  [_objectItems removeObjectAtIndex:index];
+  --_itemCount;
+  [self invalidateHierarchy];
+}
+
+/**
+ * Clears all items.
+ */
+- (void)clearItems {
+  _itemCount = 0;
+  _packedItemCount = 0;
+  _objectItems = nil;
+  [self invalidateHierarchy];
+}
+
+/**
+ * Returns the clusters of the level below |zoom|, building the hierarchy first if items were added
+ * or removed since the last call.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom {
+  if (_itemCount == 0) return @[];
+  if (_hierarchy == NULL) {
+    [self buildHierarchyWithCancellationToken:nil];
+  }
+  const GMUClusterLevel *level = &_hierarchy->levels[[self levelForZoom:zoom]];
+  NSMutableArray<id<GMUCluster>> *clusters = [[NSMutableArray alloc] initWithCapacity:level->count];
+  for (size_t i = 0; i < level->count; ++i) {
+    [clusters addObject:[self clusterForNode:level->nodes[i]]];
+  }
+  return clusters;
+}
+
+/**
+ * Returns the clusters of the level below |zoom| whose position is within |bounds|, found through
+ * the index of the level. These are exactly the clusters clustersAtZoom: returns within |bounds|.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom inBounds:(GQTBounds)bounds {
+  return [self clustersAtZoom:zoom inBounds:bounds cancellationToken:nil];
+}
+
+/**
+ * Returns the clusters of clustersAtZoom:inBounds:, or nil if |token| is cancelled while the
+ * hierarchy is built. The build is checked for cancellation between zoom levels.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom
+                                   inBounds:(GQTBounds)bounds
+                          cancellationToken:(GMUClusterCancellationToken *)token {
+  if (_itemCount == 0) return @[];
+  if (_hierarchy == NULL && ![self buildHierarchyWithCancellationToken:token]) {
+    return nil;
+  }
+  const GMUClusterLevel *level = &_hierarchy->levels[[self levelForZoom:zoom]];
+  GMUNodeList nodes = {0};
+  GMUSearchLevelWrapped(_hierarchy, level, bounds.minX, bounds.minY, bounds.maxX, bounds.maxY,
+                        &nodes);
+  NSMutableArray<id<GMUCluster>> *clusters = [[NSMutableArray alloc] initWithCapacity:nodes.count];
+  for (size_t i = 0; i < nodes.count; ++i) {
+    [clusters addObject:[self clusterForNode:nodes.nodes[i]]];
+  }
+  free(nodes.nodes);
+  return clusters;
+}
+
+/**
+ * Returns YES, as clustersAtZoom:inBounds: reads the clusters of the whole hierarchy.
+ */
+- (BOOL)clustersInBoundsAreExact {
+  return YES;
+}
+
+/**
+ * Sets the aggregates of the clusters, which are computed for every cluster of the hierarchy when
+ * it is built.
+ */
+- (void)setAggregates:(NSArray<GMUClusterAggregate *> *)aggregates {
+  _aggregates = [aggregates copy];
+  [self invalidateHierarchy];
+}
+
+#pragma mark Private
+
+- (void)invalidateHierarchy {
+  GMUClusterHierarchyFree(_hierarchy);
+  _hierarchy = NULL;
+  _orderedItems = nil;
+  _nodeAggregates = nil;
+}
+
+// Grows the item arrays to hold at least |count| items.
+- (void)reserveItemCapacity:(NSUInteger)count {
+  if (count <= _itemCapacity) return;
+  _itemCapacity = MAX(count, 2 * _itemCapacity);
+  _coordinates = GMUReallocArray(_coordinates, _itemCapacity, sizeof(CLLocationCoordinate2D));
+  _identifiers = GMUReallocArray(_identifiers, _itemCapacity, sizeof(int64_t));
+  _categories = GMUReallocArray(_categories, _itemCapacity, sizeof(uint32_t));
+}
+
+// Returns the index of the most recently added item equal to |item|, or NSNotFound.
+- (NSUInteger)indexOfLastItemEqualToItem:(id<GMUClusterItem>)item {
+  BOOL isPackedItem = [(NSObject *)item isKindOfClass:[GMUPackedClusterItem class]];
+  int64_t identifier = isPackedItem ? ((GMUPackedClusterItem *)item).identifier : 0;
+  NSNull *null = [NSNull null];
+  for (NSUInteger i = _itemCount; i-- > 0;) {
+    id objectItem = _objectItems ? _objectItems[i] : null;
+    if (objectItem != null) {
+      if ([objectItem isEqual:item]) return i;
+    } else if (isPackedItem && _identifiers[i] == identifier) {
+      return i;
+    }
+  }
+  return NSNotFound;
+}
+
+// Builds the hierarchy of the items. Returns NO, leaving _hierarchy NULL, if |token| is cancelled
+// first.
+- (BOOL)buildHierarchyWithCancellationToken:(GMUClusterCancellationToken *)token {
+  NSAssert(_itemCount < UINT32_MAX / 2, @"Too many items to cluster");
+  uint32_t itemCount = (uint32_t)_itemCount;
+  GMSMapPoint *points = GMUReallocArray(NULL, itemCount, sizeof(GMSMapPoint));
+  for (uint32_t i = 0; i < itemCount; ++i) {
+    points[i] = GMSProject(_coordinates[i]);
+  }
+  // Items are clustered with those within clusterDistancePoints screen points, and the world is
+  // 256 points wide at zoom 0.
+  double clusterDistance = _clusterDistancePoints * kGMUMapPointWidth / 256;
+  // Categories are only compared once items have some.
+  const uint32_t *categories = _categoryTable.count > 0 ? _categories : NULL;
+  _hierarchy = GMUClusterHierarchyCreate(points, categories, itemCount, clusterDistance,
+                                         (uint32_t)_maxZoom, token ? GMUTokenIsCancelled : NULL,
+                                         (__bridge void *)token);
+  free(points);
+  if (_hierarchy == NULL) return NO;
+
+  // Only the kinds of items there are get ordered: coordinates and identifiers for packed items,
+  // objects for the others.
+  const uint32_t *order = _hierarchy->orderedItems;
+  CLLocationCoordinate2D *orderedCoordinates = NULL;
+  int64_t *orderedIdentifiers = NULL;
+  if (_packedItemCount > 0) {
+    orderedCoordinates = GMUReallocArray(NULL, itemCount, sizeof(CLLocationCoordinate2D));
+    orderedIdentifiers = GMUReallocArray(NULL, itemCount, sizeof(int64_t));
+    for (uint32_t i = 0; i < itemCount; ++i) {
+      orderedCoordinates[i] = _coordinates[order[i]];
+      orderedIdentifiers[i] = _identifiers[order[i]];
+    }
+  }
+  NSMutableArray *orderedObjectItems = nil;
+  if (_objectItems != nil) {
+    orderedObjectItems = [[NSMutableArray alloc] initWithCapacity:itemCount];
+    for (uint32_t i = 0; i < itemCount; ++i) {
+      [orderedObjectItems addObject:_objectItems[order[i]]];
+    }
+  }
+  _orderedItems = [[GMUOrderedItems alloc] initWithCoordinates:orderedCoordinates
+                                                   identifiers:orderedIdentifiers
+                                                   objectItems:orderedObjectItems];
+  if (_aggregates.count > 0) {
+    [self accumulateAggregates];
+  }
+  return YES;
+}
+
+// Accumulates the aggregates of every node of the hierarchy, reading each item once. Clusters are
+// created after their children, so every node is accumulated from those before it.
+- (void)accumulateAggregates {
+  NSUInteger aggregateCount = _aggregates.count;
+  GMUClusterAggregateAccumulator *accumulators = GMUReallocArray(
+      NULL, (size_t)_hierarchy->nodeCount * aggregateCount, sizeof(GMUClusterAggregateAccumulator));
+  GMUClearAccumulators(accumulators, (size_t)_hierarchy->nodeCount * aggregateCount);
+  // Packed items have no values, so only the items added as objects are read.
+  NSNull *null = [NSNull null];
+  NSUInteger index = 0;
+  for (id objectItem in _objectItems) {
+    if (objectItem != null) {
+      GMUAccumulateItem(accumulators + index * aggregateCount, _aggregates, objectItem);
+    }
+    ++index;
+  }
+  for (uint32_t node = _hierarchy->itemCount; node < _hierarchy->nodeCount; ++node) {
+    GMUClusterAggregateAccumulator *nodeAccumulators = accumulators + (size_t)node * aggregateCount;
+    for (uint32_t child = _hierarchy->firstChildren[node]; child != kGMUNullNode;
+         child = _hierarchy->nextSiblings[child]) {
+      GMUMergeAccumulators(nodeAccumulators, accumulators + (size_t)child * aggregateCount,
+                           aggregateCount);
+    }
+  }
+  _nodeAggregates = [[GMUNodeAggregates alloc] initWithAggregates:_aggregates
+                                                     accumulators:accumulators];
+}
+
+- (NSUInteger)levelForZoom:(float)zoom {
+  double level = floor(zoom);
+  if (!(level > 0)) return 0;
+  return level > _maxZoom ? _maxZoom + 1 : (NSUInteger)level;
+}
+
+- (id<GMUCluster>)clusterForNode:(uint32_t)node {
+  NSRange range = NSMakeRange(_hierarchy->itemStarts[node], _hierarchy->counts[node]);
+  CLLocationCoordinate2D position;
+  if (node < _hierarchy->itemCount) {
+    position = _coordinates[node];
+  } else {
+    position = GMSUnproject((GMSMapPoint){_hierarchy->xs[node], _hierarchy->ys[node]});
+  }
+  NSString *category = nil;
+  if (_hierarchy->categories) {
+    category = [_categoryTable categoryForNumber:_hierarchy->categories[node]];
+  }
+  return [[GMUHierarchicalCluster alloc] initWithPosition:position
+                                          clusterCategory:category
+                                             orderedItems:_orderedItems
+                                                    range:range
+                                           nodeAggregates:_nodeAggregates
+                                                     node:node];
+}
+
+@end
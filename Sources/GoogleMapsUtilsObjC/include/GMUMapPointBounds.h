@@ -0,0 +1,32 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <GoogleMaps/GMSGeometryUtils.h>
+
+#import "GQTBounds.h"
+
+/* Map point helpers shared by the clustering classes. For internal use only. */
+
+static const double kGMUMapPointWidth = 2.0;  // MapPoint is in a [-1,1]x[-1,1] space.
+
+// Returns whether |point|, or its copy one world width to the left or right, is within |bounds|.
+static inline BOOL GMUBoundsContainPoint(GQTBounds bounds, GMSMapPoint point) {
+  if (point.y < bounds.minY || point.y > bounds.maxY) return NO;
+  for (int copy = -1; copy <= 1; ++copy) {
+    double x = point.x + copy * kGMUMapPointWidth;
+    if (x >= bounds.minX && x <= bounds.maxX) return YES;
+  }
+  return NO;
+}
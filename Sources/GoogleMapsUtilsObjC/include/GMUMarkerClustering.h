@@ -13,13 +13,19 @@
  * limitations under the License.
  */
 
+#import "GMUCachingClusterAlgorithm.h"
 #import "GMUCluster.h"
+#import "GMUClusterAggregate.h"
+#import "GMUClusterCancellationToken.h"
+#import "GMUClusterDelta.h"
 #import "GMUClusterItem.h"
 #import "GMUClusterManager.h"
 #import "GMUDefaultClusterIconGenerator.h"
 #import "GMUDefaultClusterRenderer.h"
 #import "GMUGridBasedClusterAlgorithm.h"
+#import "GMUHierarchicalDistanceBasedAlgorithm.h"
 #import "GMUNonHierarchicalDistanceBasedAlgorithm.h"
+#import "GMUPackedClusterItem.h"
 #import "GMUStaticCluster.h"
 
 #import "GQTPointQuadTree.h"
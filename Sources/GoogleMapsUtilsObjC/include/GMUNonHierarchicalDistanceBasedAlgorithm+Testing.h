@@ -0,0 +1,34 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "GMUNonHierarchicalDistanceBasedAlgorithm.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Extensions for testing purposes only. */
+@interface GMUNonHierarchicalDistanceBasedAlgorithm (Testing)
+
+/**
+ * Returns the clusters of clustersAtZoom:inBounds:cancellationToken: computed on all cores, or nil
+ * if memory runs out or |token| is cancelled first.
+ */
+- (nullable NSArray<id<GMUCluster>> *)parallelClustersAtZoom:(float)zoom
+                                                    inBounds:(GQTBounds)bounds
+                                           cancellationToken:
+                                               (nullable GMUClusterCancellationToken *)token;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -27,8 +27,21 @@
  * 4. Move any items out of an existing cluster if they are closer to another cluster.
  * 5. Remove those items from the list of candidate clusters.
  * Clusters have the center of the first element (not the centroid of the items within it).
+ * Once clusterDeltaAtZoom: has been called, the clusters of that zoom level are patched as items
+ * are added and removed, at a cost proportional to the number of items near the changed ones:
+ * - An added item joins the closest cluster within reach, or starts a cluster of its own.
+ * - A removed item leaves its cluster. If it was the first element of the cluster, the other
+ *   items are clustered again in the order they were added, as if they had just been added.
+ * Added items are clustered exactly as a full recomputation would. After removals, the clusters
+ * can differ from a full recomputation, which may pick other items as first elements. Either way
+ * the clusters are returned in the order their first elements were added.
+ * With parallel set, clustersAtZoom: and clustersAtZoom:inBounds: spread the work over all cores:
+ * the items within reach of an earlier first element are found in parallel, a block of items at a
+ * time in the order they were added, then the remaining items of the block are settled in order,
+ * and finally every item looks for its closest first element in parallel. The clusters are those
+ * of the sequential algorithm. Cancellation is checked between blocks.
  */
-@interface GMUNonHierarchicalDistanceBasedAlgorithm : NSObject<GMUClusterAlgorithm>
+@interface GMUNonHierarchicalDistanceBasedAlgorithm : NSObject<GMUIncrementalClusterAlgorithm>
 
 /**
  * Initializes this GMUNonHierarchicalDistanceBasedAlgorithm with clusterDistancePoints for
@@ -36,4 +49,12 @@
  */
 - (instancetype)initWithClusterDistancePoints:(NSUInteger)clusterDistancePoints;
 
+/**
+ * Whether clustersAtZoom: and clustersAtZoom:inBounds: run on all cores (default is NO), except at
+ * the zoom level whose clusters clusterDeltaAtZoom: maintains. The clusters, their order and their
+ * positions are those of the sequential algorithm; only the order of the items within a cluster
+ * can differ. Items which are equal to each other are clustered as distinct items in this mode.
+ */
+@property(nonatomic, getter=isParallel) BOOL parallel;
+
 @end
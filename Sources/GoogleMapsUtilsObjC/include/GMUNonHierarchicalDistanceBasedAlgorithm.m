@@ -21,20 +21,335 @@
 
 #import <GoogleMaps/GMSGeometryUtils.h>
 
-#import "GMUStaticCluster.h"
+#import "GMUStaticCluster+Private.h"
+#import "GMUClusterCategoryTable.h"
 #import "GMUClusterItem.h"
-#import "GMUWrappingDictionaryKey.h"
+#import "GMUMapPointBounds.h"
 #import "GQTPointQuadTree.h"
 
+#include <dispatch/dispatch.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
 static const NSUInteger kGMUDefaultClusterDistancePoints = 100;
-static const double kGMUMapPointWidth = 2.0;  // MapPoint is in a [-1,1]x[-1,1] space.
+// Items handed to a core at a time by the parallel clustering.
+static const size_t kGMUParallelBlockSize = 4096;
+// Items whose first elements are settled together by the parallel clustering, in the order the
+// items were added.
+static const size_t kGMUParallelChunkSize = 16 * kGMUParallelBlockSize;
+// Caps the number of columns of a seed grid so that cell keys fit in 64 bits.
+static const uint64_t kGMUSeedGridMaxColumns = (uint64_t)1 << 30;
+
+// Marks the absence of a first element.
+#define kGMUNoSeed UINT32_MAX
+
+#pragma mark Parallel clustering
+
+// The first elements of the clusters found so far, binned into square cells at least one cluster
+// radius wide so that the first elements within reach of a point are in the 3x3 cells around it.
+// Cells live in an open addressing hash table keyed by row * columns + column + 1, each holding
+// the head of a list of first elements linked through nextSeeds.
+typedef struct {
+  uint64_t *keys;
+  uint32_t *heads;
+  size_t mask;
+  uint32_t *nextSeeds;
+  uint64_t columns;
+  double cellWidth;
+} GMUSeedGrid;
+
+static bool GMUSeedGridInit(GMUSeedGrid *grid, uint32_t count, double radius) {
+  size_t capacity = 16;
+  while (capacity < (size_t)count * 2) capacity *= 2;
+  // Cells are kept a little wider than the radius so that rounding never puts a point within
+  // reach two cells away.
+  double columns = floor(kGMUMapPointWidth / (radius * 1.001));
+  grid->columns = columns < 1 ? 1 : (uint64_t)fmin(columns, (double)kGMUSeedGridMaxColumns);
+  grid->cellWidth = kGMUMapPointWidth / grid->columns;
+  grid->mask = capacity - 1;
+  grid->keys = calloc(capacity, sizeof(uint64_t));
+  grid->heads = malloc(capacity * sizeof(uint32_t));
+  grid->nextSeeds = malloc(((size_t)count + 1) * sizeof(uint32_t));
+  return grid->keys && grid->heads && grid->nextSeeds;
+}
+
+static void GMUSeedGridFree(GMUSeedGrid *grid) {
+  free(grid->keys);
+  free(grid->heads);
+  free(grid->nextSeeds);
+}
+
+static inline uint64_t GMUSeedGridCoordinate(const GMUSeedGrid *grid, double value) {
+  double cell = floor((value + 1) / grid->cellWidth);
+  if (!(cell > 0)) return 0;
+  return cell < grid->columns ? (uint64_t)cell : grid->columns - 1;
+}
+
+// Returns the slot of the cell with |key| in the hash table, or of the empty slot it would take.
+static inline size_t GMUSeedGridSlot(const GMUSeedGrid *grid, uint64_t key) {
+  size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & grid->mask;
+  while (grid->keys[slot] != 0 && grid->keys[slot] != key) {
+    slot = (slot + 1) & grid->mask;
+  }
+  return slot;
+}
+
+// Returns the category of item |index|, or 0 if |categories| is NULL.
+static inline uint32_t GMUCategoryAt(const uint32_t *categories, size_t index) {
+  return categories != NULL ? categories[index] : 0;
+}
+
+static void GMUSeedGridAdd(GMUSeedGrid *grid, const GMSMapPoint *points, uint32_t seed) {
+  uint64_t key = GMUSeedGridCoordinate(grid, points[seed].y) * grid->columns +
+                 GMUSeedGridCoordinate(grid, points[seed].x) + 1;
+  size_t slot = GMUSeedGridSlot(grid, key);
+  if (grid->keys[slot] == 0) {
+    grid->keys[slot] = key;
+    grid->nextSeeds[seed] = kGMUNoSeed;
+  } else {
+    grid->nextSeeds[seed] = grid->heads[slot];
+  }
+  grid->heads[slot] = seed;
+}
+
+// Returns the first element in |grid| closest to |point| among those whose square of half width
+// |radius| contains it, including across the antimeridian, and the most recently added one on
+// ties. Unless |categories| is NULL, only first elements of |category| are considered. Returns
+// kGMUNoSeed if there is none. The containment and distance tests match those of the quad tree
+// search done by the sequential clustering.
+static uint32_t GMUSeedGridClosestSeed(const GMUSeedGrid *grid, const GMSMapPoint *points,
+                                       const uint32_t *categories, GMSMapPoint point,
+                                       uint32_t category, double radius) {
+  static const double offsets[] = {-kGMUMapPointWidth, 0, kGMUMapPointWidth};
+  uint32_t closestSeed = kGMUNoSeed;
+  double closestDistanceSquared = 0;
+  uint64_t column = GMUSeedGridCoordinate(grid, point.x);
+  uint64_t row = GMUSeedGridCoordinate(grid, point.y);
+  uint64_t firstRow = row > 0 ? row - 1 : 0;
+  uint64_t lastRow = row + 1 < grid->columns ? row + 1 : grid->columns - 1;
+  // Columns wrap around the antimeridian, and are only visited once on grids of under 3 columns.
+  uint64_t columnCount = grid->columns < 3 ? grid->columns : 3;
+  uint64_t firstColumn = grid->columns < 3 ? 0 : (column + grid->columns - 1) % grid->columns;
+  for (uint64_t cellRow = firstRow; cellRow <= lastRow; ++cellRow) {
+    for (uint64_t i = 0; i < columnCount; ++i) {
+      uint64_t key = cellRow * grid->columns + (firstColumn + i) % grid->columns + 1;
+      size_t slot = GMUSeedGridSlot(grid, key);
+      if (grid->keys[slot] == 0) continue;
+      for (uint32_t seed = grid->heads[slot]; seed != kGMUNoSeed; seed = grid->nextSeeds[seed]) {
+        if (categories != NULL && categories[seed] != category) continue;
+        GMSMapPoint seedPoint = points[seed];
+        if (point.y < seedPoint.y - radius || point.y > seedPoint.y + radius) continue;
+        for (size_t j = 0; j < sizeof(offsets) / sizeof(offsets[0]); ++j) {
+          if (point.x < seedPoint.x - radius - offsets[j] ||
+              point.x > seedPoint.x + radius - offsets[j]) {
+            continue;
+          }
+          double deltaX = seedPoint.x - (point.x + offsets[j]);
+          double deltaY = seedPoint.y - point.y;
+          double distanceSquared = deltaX * deltaX + deltaY * deltaY;
+          if (closestSeed == kGMUNoSeed || distanceSquared < closestDistanceSquared ||
+              (distanceSquared == closestDistanceSquared && seed > closestSeed)) {
+            closestSeed = seed;
+            closestDistanceSquared = distanceSquared;
+          }
+        }
+      }
+    }
+  }
+  return closestSeed;
+}
+
+// Shared by the blocks of work of one parallel pass.
+typedef struct {
+  const GMUSeedGrid *grid;
+  const GMSMapPoint *points;
+  const uint32_t *categories;
+  const bool *candidates;
+  double radius;
+  size_t start;
+  size_t end;
+  uint32_t *owners;
+} GMUParallelPass;
+
+// Marks the items of a block which are within reach of a first element of the grid, all of which
+// come before them, as owned by it. Items which are not candidates are left in no cluster.
+static void GMUFindCoveredItems(void *context, size_t block) {
+  const GMUParallelPass *pass = context;
+  size_t first = pass->start + block * kGMUParallelBlockSize;
+  size_t last = MIN(pass->end, first + kGMUParallelBlockSize);
+  for (size_t i = first; i < last; ++i) {
+    if (pass->candidates != NULL && !pass->candidates[i]) {
+      pass->owners[i] = kGMUNoSeed;
+      continue;
+    }
+    pass->owners[i] = GMUSeedGridClosestSeed(pass->grid, pass->points, pass->categories,
+                                             pass->points[i], GMUCategoryAt(pass->categories, i),
+                                             pass->radius);
+  }
+}
+
+// Assigns the items of a block which are not first elements to the closest first element, if any
+// is within reach.
+static void GMUAssignItems(void *context, size_t block) {
+  const GMUParallelPass *pass = context;
+  size_t first = pass->start + block * kGMUParallelBlockSize;
+  size_t last = MIN(pass->end, first + kGMUParallelBlockSize);
+  for (size_t i = first; i < last; ++i) {
+    if (pass->owners[i] == i) continue;
+    pass->owners[i] = GMUSeedGridClosestSeed(pass->grid, pass->points, pass->categories,
+                                             pass->points[i], GMUCategoryAt(pass->categories, i),
+                                             pass->radius);
+  }
+}
+
+// Clusters |count| points the way the sequential algorithm does, with points in the order given as
+// candidates for first elements, and sets owners[i] to the index of the first element of the
+// cluster of point i, or to kGMUNoSeed if it is in none. Unless |candidates| is NULL, only the
+// points it flags are candidates, and the others only join the clusters which reach them. Unless
+// |categories| is NULL, points are only clustered with points of the same category. The first
+// elements are the candidates not within reach of an earlier first element, which is settled chunk
+// by chunk: the items of a chunk within reach of a first element of the previous chunks are found
+// in parallel, then the rest are settled in order. Every item then finds the closest first element
+// in parallel. Returns false if memory runs out, or if |token| is cancelled between chunks.
+static bool GMUClusterPointsInParallel(const GMSMapPoint *points, const uint32_t *categories,
+                                       const bool *candidates, uint32_t count, double radius,
+                                       GMUClusterCancellationToken *token, uint32_t *owners) {
+  GMUSeedGrid grid;
+  if (!GMUSeedGridInit(&grid, count, radius)) {
+    GMUSeedGridFree(&grid);
+    return false;
+  }
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  GMUParallelPass pass = {&grid, points, categories, candidates, radius, 0, 0, owners};
+  for (size_t start = 0; start < count; start += kGMUParallelChunkSize) {
+    if (token.isCancelled) {
+      GMUSeedGridFree(&grid);
+      return false;
+    }
+    pass.start = start;
+    pass.end = MIN((size_t)count, start + kGMUParallelChunkSize);
+    size_t blockCount = (pass.end - start + kGMUParallelBlockSize - 1) / kGMUParallelBlockSize;
+    dispatch_apply_f(blockCount, queue, &pass, GMUFindCoveredItems);
+    for (size_t i = start; i < pass.end; ++i) {
+      if (owners[i] != kGMUNoSeed) continue;
+      if (candidates != NULL && !candidates[i]) continue;
+      // Only a first element of this chunk can reach the item at this point.
+      if (GMUSeedGridClosestSeed(&grid, points, categories, points[i],
+                                 GMUCategoryAt(categories, i), radius) != kGMUNoSeed) {
+        continue;
+      }
+      owners[i] = (uint32_t)i;
+      GMUSeedGridAdd(&grid, points, (uint32_t)i);
+    }
+  }
+  if (token.isCancelled) {
+    GMUSeedGridFree(&grid);
+    return false;
+  }
+  pass.start = 0;
+  pass.end = count;
+  size_t blockCount = (count + kGMUParallelBlockSize - 1) / kGMUParallelBlockSize;
+  dispatch_apply_f(blockCount, queue, &pass, GMUAssignItems);
+  GMUSeedGridFree(&grid);
+  return true;
+}
+
+#pragma mark Sequential clustering
+
+// An item which has joined a cluster, and when it did.
+typedef struct {
+  uint64_t joinTime;
+  uint32_t index;
+} GMUJoinedItem;
+
+// The state of the sequential clustering, indexed by the positions of the quad items in the list
+// of items in the order they were added. Item i is in the cluster of the first element owners[i],
+// at the squared distance distancesSquared[i], or in none if owners[i] is kGMUNoSeed. Each time
+// an item joins a cluster the join is appended to joins, and it is the last join of the item if
+// joinTimes still holds its time.
+typedef struct {
+  uint32_t *owners;
+  double *distancesSquared;
+  uint64_t *joinTimes;
+  size_t capacity;
+  uint64_t joinCount;
+  GMUJoinedItem *joins;
+  size_t joinsCount;
+  size_t joinsCapacity;
+} GMUClusteringState;
+
+// Makes room in |state| for |count| items, and puts those from |first| on in no cluster.
+static void GMUClusteringStateReset(GMUClusteringState *state, size_t first, size_t count) {
+  if (count > state->capacity) {
+    size_t capacity = MAX(count, state->capacity * 2);
+    state->owners = realloc(state->owners, capacity * sizeof(uint32_t));
+    state->distancesSquared = realloc(state->distancesSquared, capacity * sizeof(double));
+    state->joinTimes = realloc(state->joinTimes, capacity * sizeof(uint64_t));
+    state->capacity = capacity;
+  }
+  for (size_t i = first; i < count; ++i) {
+    state->owners[i] = kGMUNoSeed;
+  }
+}
+
+static void GMUClusteringStateFree(GMUClusteringState *state) {
+  free(state->owners);
+  free(state->distancesSquared);
+  free(state->joinTimes);
+  free(state->joins);
+  *state = (GMUClusteringState){0};
+}
+
+// Puts item |index| in the cluster of the first element |owner|.
+static void GMUClusteringStateJoin(GMUClusteringState *state, uint32_t index, uint32_t owner,
+                                   double distanceSquared) {
+  if (state->joinsCount == state->joinsCapacity) {
+    state->joinsCapacity = MAX(state->joinsCapacity * 2, 64);
+    state->joins = realloc(state->joins, state->joinsCapacity * sizeof(GMUJoinedItem));
+  }
+  state->owners[index] = owner;
+  state->distancesSquared[index] = distanceSquared;
+  state->joinTimes[index] = state->joinCount;
+  state->joins[state->joinsCount++] = (GMUJoinedItem){state->joinCount++, index};
+}
+
+// Returns whether |join| is the last time its item joined a cluster.
+static inline bool GMUClusteringStateIsCurrentJoin(const GMUClusteringState *state,
+                                                   GMUJoinedItem join) {
+  return state->joinTimes[join.index] == join.joinTime;
+}
 
 #pragma mark Utilities Classes
 
-@interface GMUClusterItemQuadItem : NSObject<GQTPointQuadTreeItem>
+@interface GMUClusterItemQuadItem : NSObject<GQTPointQuadTreeItem> {
+ @public
+  // Backs index, and is read directly by the searches around points so that they make no message
+  // sends.
+  NSUInteger _index;
+}
 
 @property(nonatomic, readonly) id<GMUClusterItem> clusterItem;
 
+// Handle of this item in the quad tree.
+@property(nonatomic) GQTPointQuadTreeHandle handle;
+
+// Position of this item in the list of items in the order they were added, which is also its
+// position in the flat arrays of the algorithm, such as its categories.
+@property(nonatomic) NSUInteger index;
+
+// Another quad item wrapping an item equal to clusterItem, when equal items have been added.
+@property(nonatomic) GMUClusterItemQuadItem *nextEqualItem;
+
+// The first element of the incrementally maintained cluster this item belongs to, which is the
+// item itself for a first element.
+@property(nonatomic, weak) GMUClusterItemQuadItem *seed;
+
+// The incrementally maintained cluster of a first element, and the quad items in it.
+@property(nonatomic) GMUStaticCluster *cluster;
+@property(nonatomic) NSMutableArray<GMUClusterItemQuadItem *> *members;
+
 - (instancetype)initWithClusterItem:(id<GMUClusterItem>)clusterItem;
 
 @end
@@ -75,33 +390,158 @@ static const double kGMUMapPointWidth = 2.0;  // MapPoint is in a [-1,1]x[-1,1]
 
 @end
 
+#pragma mark Searches around points
+
+static inline double GMUDistanceSquared(GMSMapPoint pointA, GMSMapPoint pointB) {
+  double deltaX = pointA.x - pointB.x;
+  double deltaY = pointA.y - pointB.y;
+  return deltaX * deltaX + deltaY * deltaY;
+}
+
+// Returns the index of |item|, a GMUClusterItemQuadItem handed out by a quad tree search.
+static inline uint32_t GMUIndexOfQuadItem(const void *item) {
+  __unsafe_unretained GMUClusterItemQuadItem *quadItem = (__bridge GMUClusterItemQuadItem *)item;
+  return (uint32_t)quadItem->_index;
+}
+
+// The search around a new first element, which takes the items of its category that are in no
+// cluster or no closer to their own.
+typedef struct {
+  GMUClusteringState *state;
+  const uint32_t *categories;
+  GMSMapPoint point;
+  uint32_t category;
+  uint32_t seedIndex;
+} GMUSeedSearch;
+
+static bool GMUJoinItemToSeed(void *context, const void *item, GQTPoint point, double offsetX) {
+  GMUSeedSearch *search = context;
+  uint32_t index = GMUIndexOfQuadItem(item);
+  if (search->categories[index] != search->category) return true;
+  GMUClusteringState *state = search->state;
+  double distanceSquared = GMUDistanceSquared(search->point, (GMSMapPoint){point.x, point.y});
+  if (state->owners[index] != kGMUNoSeed && state->distancesSquared[index] < distanceSquared) {
+    // Already belongs to a closer cluster.
+    return true;
+  }
+  GMUClusteringStateJoin(state, index, search->seedIndex, distanceSquared);
+  return true;
+}
+
+// The search for the closest first element of a category around a point, the most recently
+// created one on ties.
+typedef struct {
+  const GMUClusteringState *state;
+  const uint32_t *categories;
+  GMSMapPoint point;
+  uint32_t category;
+  uint32_t closestSeed;
+  double closestDistanceSquared;
+} GMUClosestSeedSearch;
+
+static bool GMUFindClosestSeed(void *context, const void *item, GQTPoint point, double offsetX) {
+  GMUClosestSeedSearch *search = context;
+  uint32_t index = GMUIndexOfQuadItem(item);
+  if (search->state->owners[index] != index || search->categories[index] != search->category) {
+    return true;
+  }
+  double distanceSquared = GMUDistanceSquared(search->point, (GMSMapPoint){point.x, point.y});
+  if (search->closestSeed == kGMUNoSeed || distanceSquared < search->closestDistanceSquared ||
+      (distanceSquared == search->closestDistanceSquared && index > search->closestSeed)) {
+    search->closestSeed = index;
+    search->closestDistanceSquared = distanceSquared;
+  }
+  return true;
+}
+
 #pragma mark GMUNonHierarchicalDistanceBasedAlgorithm
 
 @implementation GMUNonHierarchicalDistanceBasedAlgorithm {
-  NSMutableArray<id<GMUClusterItem>> *_items;
+  // Quad items in the order they were added. Removed items leave an NSNull behind until more than
+  // half of the array is NSNull, at which point it is compacted.
+  NSMutableArray *_quadItems;
+  NSUInteger _removedCount;
+  // The most recently added quad item of each item, so that an item is removed without a search.
+  // Items are compared with -hash and -isEqual: and are not copied, so lookups allocate nothing.
+  NSMapTable<id<GMUClusterItem>, GMUClusterItemQuadItem *> *_quadItemsByItem;
   GQTPointQuadTree *_quadTree;
+  GMUClusterCategoryTable *_categoryTable;
+  // The number of the category of each item of _quadItems in _categoryTable.
+  uint32_t *_categories;
+  NSUInteger _categoriesCapacity;
   NSUInteger _clusterDistancePoints;
+  // The indexes in _quadItems of the first elements of the clusters at _incrementalZoom, patched
+  // by every change to the items once clusterDeltaAtZoom: has been called, or nil before that.
+  // The clusters are those of the first elements.
+  NSMutableIndexSet *_incrementalSeedIndexes;
+  float _incrementalZoom;
+  // The clustering state the incremental clusters reflect, once the joins it holds are applied.
+  GMUClusteringState _incrementalState;
+  // Changes to the incremental clusters which have not been returned by clusterDeltaAtZoom: yet.
+  NSMutableSet<GMUStaticCluster *> *_addedClusters;
+  NSMutableSet<GMUStaticCluster *> *_removedClusters;
+  NSMutableSet<GMUStaticCluster *> *_changedClusters;
 }
 
+@synthesize aggregates = _aggregates;
+
 - (instancetype)init {
   return [self initWithClusterDistancePoints:kGMUDefaultClusterDistancePoints];
 }
 
 - (instancetype)initWithClusterDistancePoints:(NSUInteger)clusterDistancePoints {
     if ((self = [super init])) {
-      _items = [[NSMutableArray alloc] init];
+      _quadItems = [[NSMutableArray alloc] init];
+      _quadItemsByItem = [NSMapTable strongToStrongObjectsMapTable];
       GQTBounds bounds = {-1, -1, 1, 1};
       _quadTree = [[GQTPointQuadTree alloc] initWithBounds:bounds];
+      _categoryTable = [[GMUClusterCategoryTable alloc] init];
+      _aggregates = @[];
       _clusterDistancePoints = clusterDistancePoints;
+      _addedClusters = [[NSMutableSet alloc] init];
+      _removedClusters = [[NSMutableSet alloc] init];
+      _changedClusters = [[NSMutableSet alloc] init];
     }
     return self;
 }
 
+- (void)dealloc {
+  GMUClusteringStateFree(&_incrementalState);
+  free(_categories);
+}
+
 - (void)addItems:(NSArray<id<GMUClusterItem>> *)items {
-  [_items addObjectsFromArray:items];
+  NSMutableArray<GMUClusterItemQuadItem *> *quadItems =
+      [[NSMutableArray alloc] initWithCapacity:items.count];
   for (id<GMUClusterItem> item in items) {
-    GMUClusterItemQuadItem *quadItem = [[GMUClusterItemQuadItem alloc] initWithClusterItem:item];
-    [_quadTree add:quadItem];
+    [quadItems addObject:[[GMUClusterItemQuadItem alloc] initWithClusterItem:item]];
+  }
+  GQTPointQuadTreeHandle *handles = malloc(quadItems.count * sizeof(GQTPointQuadTreeHandle));
+  [_quadTree addItems:quadItems handles:handles];
+  NSUInteger firstIndex = _quadItems.count;
+  if (_categoriesCapacity < firstIndex + quadItems.count) {
+    _categoriesCapacity = MAX(_categoriesCapacity * 2, firstIndex + quadItems.count);
+    _categories = realloc(_categories, _categoriesCapacity * sizeof(uint32_t));
+  }
+  NSUInteger index = 0;
+  for (GMUClusterItemQuadItem *quadItem in quadItems) {
+    GQTPointQuadTreeHandle handle = handles[index++];
+    if (handle == kGQTPointQuadTreeInvalidHandle) continue;
+
+    quadItem.handle = handle;
+    quadItem.index = _quadItems.count;
+    _categories[quadItem.index] = [_categoryTable numberForCategoryOfItem:quadItem.clusterItem];
+    [_quadItems addObject:quadItem];
+    id<GMUClusterItem> item = quadItem.clusterItem;
+    quadItem.nextEqualItem = [_quadItemsByItem objectForKey:item];
+    [_quadItemsByItem setObject:quadItem forKey:item];
+  }
+  free(handles);
+
+  if (_incrementalSeedIndexes) {
+    GMUClusteringStateReset(&_incrementalState, firstIndex, _quadItems.count);
+    NSRange addedRange = NSMakeRange(firstIndex, _quadItems.count - firstIndex);
+    [self clusterQuadItems:[_quadItems subarrayWithRange:addedRange]];
   }
 }
 
@@ -109,19 +549,38 @@ static const double kGMUMapPointWidth = 2.0;  // MapPoint is in a [-1,1]x[-1,1]
  * Removes an item.
  */
 - (void)removeItem:(id<GMUClusterItem>)item {
-  [_items removeObject:item];
+  GMUClusterItemQuadItem *quadItem = [_quadItemsByItem objectForKey:item];
+  if (!quadItem) return;
 
-  GMUClusterItemQuadItem *quadItem = [[GMUClusterItemQuadItem alloc] initWithClusterItem:item];
-  // This should remove the corresponding quad item since GMUClusterItemQuadItem forwards its hash
-  // and isEqual to the underlying item.
-  [_quadTree remove:quadItem];
+  if (quadItem.nextEqualItem) {
+    [_quadItemsByItem setObject:quadItem.nextEqualItem forKey:item];
+  } else {
+    [_quadItemsByItem removeObjectForKey:item];
+  }
+  [_quadTree removeItemWithHandle:quadItem.handle];
+  if (_incrementalSeedIndexes) {
+    [self unclusterQuadItem:quadItem];
+  }
+  _quadItems[quadItem.index] = [NSNull null];
+  if (++_removedCount > _quadItems.count / 2) {
+    [self compactQuadItems];
+  }
 }
 
 /**
  * Clears all items.
  */
 - (void)clearItems {
-  [_items removeAllObjects];
+  NSArray<GMUStaticCluster *> *clusters =
+      [self incrementalClustersOfSeedIndexes:_incrementalSeedIndexes];
+  for (GMUStaticCluster *cluster in clusters) {
+    [self noteRemovedCluster:cluster];
+  }
+  [_incrementalSeedIndexes removeAllIndexes];
+  _incrementalState.joinsCount = 0;
+  [_quadItems removeAllObjects];
+  [_quadItemsByItem removeAllObjects];
+  _removedCount = 0;
   [_quadTree clear];
 }
 
@@ -129,69 +588,467 @@ static const double kGMUMapPointWidth = 2.0;  // MapPoint is in a [-1,1]x[-1,1]
  * Returns the set of clusters of the added items.
  */
 - (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom {
-  NSMutableArray<id<GMUCluster>> *clusters = [[NSMutableArray alloc] init];
-  NSMutableDictionary<GMUWrappingDictionaryKey *, id<GMUCluster>> *itemToClusterMap =
-      [[NSMutableDictionary alloc] init];
-  NSMutableDictionary<GMUWrappingDictionaryKey *, NSNumber *> *itemToClusterDistanceMap =
-      [[NSMutableDictionary alloc] init];
-  NSMutableSet<id<GMUClusterItem>> *processedItems = [[NSMutableSet alloc] init];
+  if (_incrementalSeedIndexes && zoom == _incrementalZoom) {
+    return [self incrementalClustersOfSeedIndexes:_incrementalSeedIndexes];
+  }
+
+  GQTBounds world = {-1, -1, 1, 1};
+  NSArray<id<GMUCluster>> *clusters =
+      _parallel ? [self parallelClustersAtZoom:zoom inBounds:world cancellationToken:nil] : nil;
+  if (!clusters) {
+    clusters = [self clustersAroundQuadItems:_quadItems atZoom:zoom cancellationToken:nil];
+  }
+#if DEBUG
+  NSUInteger totalCount = 0;
+  for (id<GMUCluster> cluster in clusters) {
+    totalCount += cluster.count;
+  }
+  NSAssert(_quadTree.count == totalCount, @"All clusters combined should make up original item set");
+#endif
+  return clusters;
+}
+
+/**
+ * Returns the clusters whose first element is within |bounds|. Only items within |bounds| are
+ * candidates for first elements, so items outside of it are only visited when they are near one.
+ */
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom inBounds:(GQTBounds)bounds {
+  return [self clustersAtZoom:zoom inBounds:bounds cancellationToken:nil];
+}
+
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom
+                                   inBounds:(GQTBounds)bounds
+                          cancellationToken:(GMUClusterCancellationToken *)token {
+  NSMutableArray<GMUClusterItemQuadItem *> *quadItems = [[NSMutableArray alloc] init];
+  [_quadTree enumerateItemsInWrappedBounds:bounds
+                                usingBlock:^(id<GQTPointQuadTreeItem> quadItem, GQTPoint point,
+                                             double offsetX, BOOL *stop) {
+    [quadItems addObject:(GMUClusterItemQuadItem *)quadItem];
+  }];
+  if (_incrementalSeedIndexes && zoom == _incrementalZoom) {
+    NSMutableIndexSet *seedIndexes = [[NSMutableIndexSet alloc] init];
+    for (GMUClusterItemQuadItem *quadItem in quadItems) {
+      if (quadItem.seed != quadItem) continue;
+      [seedIndexes addIndex:quadItem.index];
+    }
+    return [self incrementalClustersOfSeedIndexes:seedIndexes];
+  }
+  if (_parallel) {
+    NSArray<id<GMUCluster>> *clusters =
+        [self parallelClustersAtZoom:zoom inBounds:bounds cancellationToken:token];
+    if (clusters || token.isCancelled) return clusters;
+  }
+
+  // Candidates are taken in the order they were added, as in clustersAtZoom:.
+  [quadItems sortUsingComparator:^NSComparisonResult(GMUClusterItemQuadItem *item1,
+                                                     GMUClusterItemQuadItem *item2) {
+    if (item1.index == item2.index) return NSOrderedSame;
+    return item1.index < item2.index ? NSOrderedAscending : NSOrderedDescending;
+  }];
+  return [self clustersAroundQuadItems:quadItems atZoom:zoom cancellationToken:token];
+}
+
+/**
+ * Sets the aggregates of the clusters. Incrementally maintained clusters are replaced by new ones
+ * with the next clusterDeltaAtZoom: call.
+ */
+- (void)setAggregates:(NSArray<GMUClusterAggregate *> *)aggregates {
+  _aggregates = [aggregates copy];
+  if (_incrementalSeedIndexes) {
+    [self buildIncrementalClustersAtZoom:_incrementalZoom];
+  }
+}
+
+- (GMUClusterDelta *)clusterDeltaAtZoom:(float)zoom {
+  if (!_incrementalSeedIndexes || zoom != _incrementalZoom) {
+    [self buildIncrementalClustersAtZoom:zoom];
+  }
+  GMUClusterDelta *delta =
+      [[GMUClusterDelta alloc] initWithZoom:zoom
+                              addedClusters:[_addedClusters allObjects]
+                            removedClusters:[_removedClusters allObjects]
+                            changedClusters:[_changedClusters allObjects]];
+  [_addedClusters removeAllObjects];
+  [_removedClusters removeAllObjects];
+  [_changedClusters removeAllObjects];
+  return delta;
+}
+
+#pragma mark Private
+
+// Runs the clustering over |quadItems|, which may contain NSNull, as candidates for the first
+// elements of clusters in the order given. Returns nil if |token| is cancelled first.
+- (NSArray<id<GMUCluster>> *)clustersAroundQuadItems:(NSArray *)quadItems
+                                              atZoom:(float)zoom
+                                   cancellationToken:(GMUClusterCancellationToken *)token {
+  NSUInteger itemCount = _quadItems.count;
+  GMUClusteringState state = {0};
+  GMUClusteringStateReset(&state, 0, itemCount + 1);
+  NSMutableArray<GMUClusterItemQuadItem *> *seeds = [[NSMutableArray alloc] init];
+  if (![self clusterCandidates:quadItems
+                        radius:[self radiusAtZoom:zoom]
+                         state:&state
+                         seeds:seeds
+             cancellationToken:token]) {
+    GMUClusteringStateFree(&state);
+    return nil;
+  }
+
+  NSMutableArray<GMUStaticCluster *> *clusters =
+      [[NSMutableArray alloc] initWithCapacity:seeds.count];
+  uint32_t *clusterIndexes = malloc((itemCount + 1) * sizeof(uint32_t));
+  for (GMUClusterItemQuadItem *seed in seeds) {
+    clusterIndexes[seed.index] = (uint32_t)clusters.count;
+    [clusters addObject:[self clusterForSeed:seed]];
+  }
+  // Items are added to their clusters in the order they last joined one, which is the order they
+  // would be left in by adding and removing them as they move between clusters.
+  for (size_t i = 0; i < state.joinsCount; ++i) {
+    GMUJoinedItem join = state.joins[i];
+    if (!GMUClusteringStateIsCurrentJoin(&state, join)) continue;
+    GMUClusterItemQuadItem *quadItem = _quadItems[join.index];
+    [clusters[clusterIndexes[state.owners[join.index]]] addItem:quadItem.clusterItem];
+  }
+  free(clusterIndexes);
+  GMUClusteringStateFree(&state);
+  return clusters;
+}
 
-  for (id<GMUClusterItem> item in _items) {
-    if ([processedItems containsObject:item]) continue;
+// The clustering shared by all sequential paths. Every candidate of |quadItems|, which may contain
+// NSNull, that is in no cluster of |state| yet becomes the first element of a new cluster, in the
+// order given, which takes the items of its category within |radius| of it that are in no cluster
+// or no closer to their own. The new first elements are appended to |seeds|. Returns NO if |token|
+// is cancelled first.
+- (BOOL)clusterCandidates:(NSArray *)quadItems
+                   radius:(double)radius
+                    state:(GMUClusteringState *)state
+                    seeds:(NSMutableArray<GMUClusterItemQuadItem *> *)seeds
+        cancellationToken:(GMUClusterCancellationToken *)token {
+  GMUSeedSearch search = {state, _categories};
+  for (GMUClusterItemQuadItem *quadItem in quadItems) {
+    if ((id)quadItem == [NSNull null]) continue;
+    if (state->owners[quadItem->_index] != kGMUNoSeed) continue;
+    if (token.isCancelled) return NO;
 
-    GMUStaticCluster *cluster = [[GMUStaticCluster alloc] initWithPosition:item.position];
+    search.seedIndex = (uint32_t)quadItem->_index;
+    search.category = _categories[search.seedIndex];
+    [seeds addObject:quadItem];
 
-    GMSMapPoint point = GMSProject(item.position);
+    GQTPoint point = quadItem.point;
+    search.point = (GMSMapPoint){point.x, point.y};
 
     // Query for items within a fixed point distance from the current item to make up a cluster
-    // around it.
-    double radius = _clusterDistancePoints * kGMUMapPointWidth / pow(2.0, zoom + 8.0);
+    // around it, including items across the antimeridian.
     GQTBounds bounds = {point.x - radius, point.y - radius, point.x + radius, point.y + radius};
-    NSArray *nearbyItems = [_quadTree searchWithBounds:bounds];
-    for (GMUClusterItemQuadItem *quadItem in nearbyItems) {
-      id<GMUClusterItem> nearbyItem = quadItem.clusterItem;
-      [processedItems addObject:nearbyItem];
-      GMSMapPoint nearbyItemPoint = GMSProject(nearbyItem.position);
-      GMUWrappingDictionaryKey *key = [[GMUWrappingDictionaryKey alloc] initWithObject:nearbyItem];
-
-      NSNumber *existingDistance = [itemToClusterDistanceMap objectForKey:key];
-      double distanceSquared = [self distanceSquaredBetweenPointA:point andPointB:nearbyItemPoint];
-      if (existingDistance != nil) {
-        if ([existingDistance doubleValue] < distanceSquared) {
-          // Already belongs to a closer cluster.
-          continue;
-        }
-        GMUStaticCluster *existingCluster = [itemToClusterMap objectForKey:key];
-        [existingCluster removeItem:nearbyItem];
-      }
-      NSNumber *number = [NSNumber numberWithDouble:distanceSquared];
-      [itemToClusterDistanceMap setObject:number forKey:key];
-      [itemToClusterMap setObject:cluster forKey:key];
-      [cluster addItem:nearbyItem];
+    [_quadTree enumerateItemsInWrappedBounds:bounds
+                               usingFunction:GMUJoinItemToSeed
+                                     context:&search];
+  }
+  return YES;
+}
+
+// Runs the clustering of clustersAtZoom:inBounds:cancellationToken: on all cores, over the items
+// within |bounds| as candidates and those within reach of them. Returns nil if memory runs out or
+// if |token| is cancelled first.
+- (NSArray<id<GMUCluster>> *)parallelClustersAtZoom:(float)zoom
+                                           inBounds:(GQTBounds)bounds
+                                  cancellationToken:(GMUClusterCancellationToken *)token {
+  double radius = [self radiusAtZoom:zoom];
+  NSMutableArray<GMUClusterItemQuadItem *> *quadItems;
+  // Whether each item of _quadItems is within |bounds|, or NULL if all of them are.
+  bool *inBounds = NULL;
+  if (bounds.maxX - bounds.minX >= kGMUMapPointWidth && bounds.minY <= -1 && bounds.maxY >= 1) {
+    quadItems = [[NSMutableArray alloc] initWithCapacity:_quadItems.count - _removedCount];
+    for (GMUClusterItemQuadItem *quadItem in _quadItems) {
+      if ((id)quadItem == [NSNull null]) continue;
+      [quadItems addObject:quadItem];
+    }
+  } else {
+    inBounds = calloc(_quadItems.count + 1, sizeof(bool));
+    // Marks the items found within the area around |bounds|, which may be found once per copy of
+    // the tree.
+    bool *found = calloc(_quadItems.count + 1, sizeof(bool));
+    if (!inBounds || !found) {
+      free(inBounds);
+      free(found);
+      return nil;
     }
-    [clusters addObject:cluster];
+    [_quadTree enumerateItemsInWrappedBounds:bounds
+                                  usingBlock:^(id<GQTPointQuadTreeItem> quadItem, GQTPoint point,
+                                               double offsetX, BOOL *stop) {
+      inBounds[((GMUClusterItemQuadItem *)quadItem).index] = true;
+    }];
+    quadItems = [[NSMutableArray alloc] init];
+    GQTBounds reach = {bounds.minX - radius, bounds.minY - radius, bounds.maxX + radius,
+                       bounds.maxY + radius};
+    [_quadTree enumerateItemsInWrappedBounds:reach
+                                  usingBlock:^(id<GQTPointQuadTreeItem> quadItem, GQTPoint point,
+                                               double offsetX, BOOL *stop) {
+      GMUClusterItemQuadItem *clusterQuadItem = (GMUClusterItemQuadItem *)quadItem;
+      if (found[clusterQuadItem.index]) return;
+      found[clusterQuadItem.index] = true;
+      [quadItems addObject:clusterQuadItem];
+    }];
+    free(found);
+    // Candidates are taken in the order they were added, as in clustersAtZoom:.
+    [quadItems sortUsingComparator:^NSComparisonResult(GMUClusterItemQuadItem *item1,
+                                                       GMUClusterItemQuadItem *item2) {
+      return item1.index < item2.index ? NSOrderedAscending : NSOrderedDescending;
+    }];
   }
-  NSAssert(itemToClusterDistanceMap.count == _items.count,
-           @"All items should be mapped to a distance");
-  NSAssert(itemToClusterMap.count == _items.count,
-           @"All items should be mapped to a cluster");
 
-#if DEBUG
-  NSUInteger totalCount = 0;
-  for (id<GMUCluster> cluster in clusters) {
-    totalCount += cluster.count;
+  uint32_t count = (uint32_t)quadItems.count;
+  GMSMapPoint *points = malloc(((size_t)count + 1) * sizeof(GMSMapPoint));
+  uint32_t *owners = malloc(((size_t)count + 1) * sizeof(uint32_t));
+  uint32_t *clusterIndexes = malloc(((size_t)count + 1) * sizeof(uint32_t));
+  // Categories are only compared once items have some.
+  uint32_t *categories =
+      _categoryTable.count > 0 ? malloc(((size_t)count + 1) * sizeof(uint32_t)) : NULL;
+  bool *candidates = inBounds ? malloc(((size_t)count + 1) * sizeof(bool)) : NULL;
+  if (!points || !owners || !clusterIndexes || (_categoryTable.count > 0 && !categories) ||
+      (inBounds && !candidates)) {
+    free(points);
+    free(owners);
+    free(clusterIndexes);
+    free(categories);
+    free(candidates);
+    free(inBounds);
+    return nil;
   }
-  NSAssert(_items.count == totalCount, @"All clusters combined should make up original item set");
-#endif
+  for (uint32_t i = 0; i < count; ++i) {
+    GMUClusterItemQuadItem *quadItem = quadItems[i];
+    GQTPoint point = quadItem.point;
+    points[i] = (GMSMapPoint){point.x, point.y};
+    if (categories != NULL) {
+      categories[i] = _categories[quadItem.index];
+    }
+    if (candidates != NULL) {
+      candidates[i] = inBounds[quadItem.index];
+    }
+  }
+  free(inBounds);
+  bool clustered = GMUClusterPointsInParallel(points, categories, candidates, count, radius, token,
+                                              owners);
+  free(points);
+  free(categories);
+  free(candidates);
+  if (!clustered) {
+    free(owners);
+    free(clusterIndexes);
+    return nil;
+  }
+
+  // Clusters come in the order of their first elements, as in the sequential clustering, and take
+  // their items in the order they were added.
+  NSMutableArray<GMUStaticCluster *> *clusters = [[NSMutableArray alloc] init];
+  for (uint32_t i = 0; i < count; ++i) {
+    if (owners[i] != i) continue;
+    clusterIndexes[i] = (uint32_t)clusters.count;
+    [clusters addObject:[self clusterForSeed:quadItems[i]]];
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    if (owners[i] == kGMUNoSeed) continue;
+    [clusters[clusterIndexes[owners[i]]] addItem:quadItems[i].clusterItem];
+  }
+  free(owners);
+  free(clusterIndexes);
   return clusters;
 }
 
-#pragma mark Private
+// Returns a new empty cluster at |seed|, for items of its category.
+- (GMUStaticCluster *)clusterForSeed:(GMUClusterItemQuadItem *)seed {
+  NSString *category = [_categoryTable categoryForNumber:_categories[seed.index]];
+  return [[GMUStaticCluster alloc] initWithPosition:seed.clusterItem.position
+                                    clusterCategory:category
+                                         aggregates:_aggregates];
+}
 
-- (double)distanceSquaredBetweenPointA:(GMSMapPoint)pointA andPointB:(GMSMapPoint)pointB {
-  double deltaX = pointA.x - pointB.x;
-  double deltaY = pointA.y - pointB.y;
-  return deltaX * deltaX + deltaY * deltaY;
+- (double)radiusAtZoom:(float)zoom {
+  return _clusterDistancePoints * kGMUMapPointWidth / pow(2.0, zoom + 8.0);
+}
+
+// Returns the incrementally maintained clusters of the first elements at |seedIndexes|, in the
+// order of the first elements as in a full clustering.
+- (NSArray<GMUStaticCluster *> *)incrementalClustersOfSeedIndexes:(NSIndexSet *)seedIndexes {
+  NSMutableArray<GMUStaticCluster *> *clusters =
+      [[NSMutableArray alloc] initWithCapacity:seedIndexes.count];
+  [seedIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+    [clusters addObject:((GMUClusterItemQuadItem *)self->_quadItems[index]).cluster];
+  }];
+  return clusters;
+}
+
+// Replaces the incrementally maintained clusters with those of a full clustering at |zoom|.
+- (void)buildIncrementalClustersAtZoom:(float)zoom {
+  NSArray<GMUStaticCluster *> *clusters =
+      [self incrementalClustersOfSeedIndexes:_incrementalSeedIndexes];
+  for (GMUStaticCluster *cluster in clusters) {
+    [self noteRemovedCluster:cluster];
+  }
+  _incrementalSeedIndexes = [[NSMutableIndexSet alloc] init];
+  _incrementalZoom = zoom;
+  for (GMUClusterItemQuadItem *quadItem in _quadItems) {
+    if ((id)quadItem == [NSNull null]) continue;
+    quadItem.seed = nil;
+    quadItem.cluster = nil;
+    quadItem.members = nil;
+  }
+  GMUClusteringStateReset(&_incrementalState, 0, _quadItems.count);
+  _incrementalState.joinsCount = 0;
+
+  NSMutableArray<GMUClusterItemQuadItem *> *seeds = [[NSMutableArray alloc] init];
+  [self clusterCandidates:_quadItems
+                   radius:[self radiusAtZoom:zoom]
+                    state:&_incrementalState
+                    seeds:seeds
+        cancellationToken:nil];
+  [self applyIncrementalJoinsWithSeeds:seeds];
+}
+
+// Clusters |quadItems|, which are in the order they were added and in no cluster, the way a full
+// clustering would if they had been added last: every cluster already there takes the items it
+// reaches first, then the remaining items start new clusters in order.
+- (void)clusterQuadItems:(NSArray<GMUClusterItemQuadItem *> *)quadItems {
+  double radius = [self radiusAtZoom:_incrementalZoom];
+  for (GMUClusterItemQuadItem *quadItem in quadItems) {
+    [self addQuadItemToClosestSeed:quadItem radius:radius];
+  }
+  NSMutableArray<GMUClusterItemQuadItem *> *seeds = [[NSMutableArray alloc] init];
+  [self clusterCandidates:quadItems
+                   radius:radius
+                    state:&_incrementalState
+                    seeds:seeds
+        cancellationToken:nil];
+  [self applyIncrementalJoinsWithSeeds:seeds];
+}
+
+// Puts |quadItem| in the closest cluster of _incrementalState within |radius| of it, picking the
+// most recently created one on ties. Does nothing if there is none.
+- (void)addQuadItemToClosestSeed:(GMUClusterItemQuadItem *)quadItem radius:(double)radius {
+  GQTPoint point = quadItem.point;
+  GMUClosestSeedSearch search = {&_incrementalState, _categories, {point.x, point.y},
+                                 _categories[quadItem.index], kGMUNoSeed, 0};
+  GQTBounds bounds = {point.x - radius, point.y - radius, point.x + radius, point.y + radius};
+  [_quadTree enumerateItemsInWrappedBounds:bounds
+                             usingFunction:GMUFindClosestSeed
+                                   context:&search];
+  if (search.closestSeed == kGMUNoSeed) return;
+
+  GMUClusteringStateJoin(&_incrementalState, (uint32_t)quadItem.index, search.closestSeed,
+                         search.closestDistanceSquared);
+}
+
+// Brings the incrementally maintained clusters up to date with the joins of _incrementalState,
+// creating the clusters of |seeds|, the first elements found since the last call.
+- (void)applyIncrementalJoinsWithSeeds:(NSArray<GMUClusterItemQuadItem *> *)seeds {
+  for (GMUClusterItemQuadItem *seed in seeds) {
+    seed.cluster = [self clusterForSeed:seed];
+    seed.members = [[NSMutableArray alloc] init];
+    [_incrementalSeedIndexes addIndex:seed.index];
+    [_addedClusters addObject:seed.cluster];
+  }
+  GMUClusteringState *state = &_incrementalState;
+  for (size_t i = 0; i < state->joinsCount; ++i) {
+    GMUJoinedItem join = state->joins[i];
+    if (!GMUClusteringStateIsCurrentJoin(state, join)) continue;
+    GMUClusterItemQuadItem *quadItem = _quadItems[join.index];
+    GMUClusterItemQuadItem *seed = _quadItems[state->owners[join.index]];
+    GMUClusterItemQuadItem *existingSeed = quadItem.seed;
+    if (existingSeed == seed) continue;
+    if (existingSeed != nil) {
+      [self removeQuadItem:quadItem fromSeed:existingSeed];
+      [self noteChangedCluster:existingSeed.cluster];
+    }
+    [self addQuadItem:quadItem toSeed:seed];
+    [self noteChangedCluster:seed.cluster];
+  }
+  state->joinsCount = 0;
+}
+
+// Removes |quadItem|, which is no longer in the quad tree, from its cluster. If it was the first
+// element of the cluster, the rest of the cluster is clustered again.
+- (void)unclusterQuadItem:(GMUClusterItemQuadItem *)quadItem {
+  GMUClusterItemQuadItem *seed = quadItem.seed;
+  if (seed == nil) return;
+  _incrementalState.owners[quadItem.index] = kGMUNoSeed;
+  if (seed != quadItem) {
+    [self removeQuadItem:quadItem fromSeed:seed];
+    [self noteChangedCluster:seed.cluster];
+    return;
+  }
+
+  NSMutableArray<GMUClusterItemQuadItem *> *orphans = seed.members;
+  [orphans removeObjectIdenticalTo:seed];
+  [_incrementalSeedIndexes removeIndex:seed.index];
+  [self noteRemovedCluster:seed.cluster];
+  seed.seed = nil;
+  seed.cluster = nil;
+  seed.members = nil;
+  for (GMUClusterItemQuadItem *orphan in orphans) {
+    orphan.seed = nil;
+    _incrementalState.owners[orphan.index] = kGMUNoSeed;
+  }
+  [orphans sortUsingComparator:^NSComparisonResult(GMUClusterItemQuadItem *item1,
+                                                   GMUClusterItemQuadItem *item2) {
+    return item1.index < item2.index ? NSOrderedAscending : NSOrderedDescending;
+  }];
+  [self clusterQuadItems:orphans];
+}
+
+- (void)addQuadItem:(GMUClusterItemQuadItem *)quadItem toSeed:(GMUClusterItemQuadItem *)seed {
+  quadItem.seed = seed;
+  [seed.members addObject:quadItem];
+  [seed.cluster addItem:quadItem.clusterItem];
+}
+
+- (void)removeQuadItem:(GMUClusterItemQuadItem *)quadItem
+              fromSeed:(GMUClusterItemQuadItem *)seed {
+  quadItem.seed = nil;
+  [seed.members removeObjectIdenticalTo:quadItem];
+  [seed.cluster removeItemIdenticalTo:quadItem.clusterItem];
+}
+
+- (void)noteChangedCluster:(GMUStaticCluster *)cluster {
+  if ([_addedClusters containsObject:cluster]) return;
+  [_changedClusters addObject:cluster];
+}
+
+- (void)noteRemovedCluster:(GMUStaticCluster *)cluster {
+  if ([_addedClusters containsObject:cluster]) {
+    [_addedClusters removeObject:cluster];
+    return;
+  }
+  [_changedClusters removeObject:cluster];
+  [_removedClusters addObject:cluster];
+}
+
+- (void)compactQuadItems {
+  NSMutableArray<GMUClusterItemQuadItem *> *quadItems =
+      [[NSMutableArray alloc] initWithCapacity:_quadItems.count - _removedCount];
+  GMUClusteringState *state = _incrementalSeedIndexes ? &_incrementalState : NULL;
+  for (GMUClusterItemQuadItem *quadItem in _quadItems) {
+    if ((id)quadItem == [NSNull null]) continue;
+    NSUInteger index = quadItems.count;
+    if (state != NULL) {
+      // Items only move towards the front, so their state is moved in place.
+      state->distancesSquared[index] = state->distancesSquared[quadItem.index];
+      state->joinTimes[index] = state->joinTimes[quadItem.index];
+    }
+    _categories[index] = _categories[quadItem.index];
+    quadItem.index = index;
+    [quadItems addObject:quadItem];
+  }
+  _quadItems = quadItems;
+  _removedCount = 0;
+  if (state != NULL) {
+    [_incrementalSeedIndexes removeAllIndexes];
+    for (GMUClusterItemQuadItem *quadItem in _quadItems) {
+      state->owners[quadItem.index] = quadItem.seed ? (uint32_t)quadItem.seed.index : kGMUNoSeed;
+      if (quadItem.seed == quadItem) {
+        [_incrementalSeedIndexes addIndex:quadItem.index];
+      }
+    }
+  }
 }
 
 @end
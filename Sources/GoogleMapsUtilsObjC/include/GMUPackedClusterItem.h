@@ -0,0 +1,62 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUClusterItem.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A cluster item added as a coordinate and a 64-bit identifier through
+ * addItemsWithCoordinates:identifiers:count:. Algorithms which keep such items packed only create
+ * these objects when the items of a cluster are read, so one item can be represented by several
+ * objects. Objects with the same identifier are equal.
+ */
+@interface GMUPackedClusterItem : NSObject<GMUClusterItem>
+
+/**
+ * The default initializer is not available. Use initWithIdentifier:position: instead.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns a new instance of the GMUPackedClusterItem class with |identifier| at |position|.
+ */
+- (instancetype)initWithIdentifier:(int64_t)identifier
+                          position:(CLLocationCoordinate2D)position NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Returns the items with the |count| identifiers at |identifiers|, each at the coordinate with the
+ * same index in |coordinates|.
+ */
++ (NSArray<GMUPackedClusterItem *> *)
+    itemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+             identifiers:(const int64_t *)identifiers
+                   count:(NSUInteger)count;
+
+/**
+ * Returns the identifier of the item.
+ */
+@property(nonatomic, readonly) int64_t identifier;
+
+/**
+ * Returns the position of the item.
+ */
+@property(nonatomic, readonly) CLLocationCoordinate2D position;
+
+@end
+
+NS_ASSUME_NONNULL_END
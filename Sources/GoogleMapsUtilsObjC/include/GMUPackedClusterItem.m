@@ -0,0 +1,54 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUPackedClusterItem.h"
+
+@implementation GMUPackedClusterItem
+
+- (instancetype)initWithIdentifier:(int64_t)identifier position:(CLLocationCoordinate2D)position {
+  if ((self = [super init])) {
+    _identifier = identifier;
+    _position = position;
+  }
+  return self;
+}
+
++ (NSArray<GMUPackedClusterItem *> *)
+    itemsWithCoordinates:(const CLLocationCoordinate2D *)coordinates
+             identifiers:(const int64_t *)identifiers
+                   count:(NSUInteger)count {
+  NSMutableArray<GMUPackedClusterItem *> *items = [[NSMutableArray alloc] initWithCapacity:count];
+  for (NSUInteger i = 0; i < count; ++i) {
+    [items addObject:[[GMUPackedClusterItem alloc] initWithIdentifier:identifiers[i]
+                                                             position:coordinates[i]]];
+  }
+  return items;
+}
+
+- (BOOL)isEqual:(id)object {
+  if (self == object) return YES;
+  if (![object isKindOfClass:[GMUPackedClusterItem class]]) return NO;
+  return _identifier == ((GMUPackedClusterItem *)object).identifier;
+}
+
+- (NSUInteger)hash {
+  return (NSUInteger)_identifier;
+}
+
+@end
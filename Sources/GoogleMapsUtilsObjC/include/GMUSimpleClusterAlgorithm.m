@@ -19,8 +19,11 @@
 
 #import "GMUSimpleClusterAlgorithm.h"
 
+#import <GoogleMaps/GMSGeometryUtils.h>
+
 #import "GMUStaticCluster.h"
 #import "GMUClusterItem.h"
+#import "GMUMapPointBounds.h"
 
 static const NSUInteger kClusterCount = 10;
 
@@ -48,18 +51,34 @@ static const NSUInteger kClusterCount = 10;
 }
 
 - (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom {
+  return [self clustersOfItems:_items];
+}
+
+- (NSArray<id<GMUCluster>> *)clustersAtZoom:(float)zoom inBounds:(GQTBounds)bounds {
+  NSMutableArray<id<GMUClusterItem>> *items = [[NSMutableArray alloc] init];
+  for (id<GMUClusterItem> item in _items) {
+    if (GMUBoundsContainPoint(bounds, GMSProject(item.position))) {
+      [items addObject:item];
+    }
+  }
+  return [self clustersOfItems:items];
+}
+
+#pragma mark Private
+
+- (NSArray<id<GMUCluster>> *)clustersOfItems:(NSArray<id<GMUClusterItem>> *)items {
   NSMutableArray<id<GMUCluster>> *clusters =
       [[NSMutableArray alloc] initWithCapacity:kClusterCount];
 
   for (int i = 0; i < kClusterCount; ++i) {
-    if (i >= _items.count) break;
-    id<GMUClusterItem> item = _items[i];
+    if (i >= items.count) break;
+    id<GMUClusterItem> item = items[i];
     [clusters addObject:[[GMUStaticCluster alloc] initWithPosition:item.position]];
   }
 
   NSUInteger clusterIndex = 0;
-  for (int i = kClusterCount; i < _items.count; ++i) {
-    id<GMUClusterItem> item = _items[i];
+  for (int i = kClusterCount; i < items.count; ++i) {
+    id<GMUClusterItem> item = items[i];
     GMUStaticCluster *cluster = clusters[clusterIndex % kClusterCount];
     [cluster addItem:item];
     ++clusterIndex;
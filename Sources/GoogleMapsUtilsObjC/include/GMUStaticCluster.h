@@ -16,6 +16,7 @@
 #import <Foundation/Foundation.h>
 
 #import "GMUCluster.h"
+#import "GMUClusterAggregate.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -32,13 +33,39 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  * Returns a new instance of the GMUStaticCluster class defined by it's position.
  */
-- (instancetype)initWithPosition:(CLLocationCoordinate2D)position NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position;
+
+/**
+ * Returns a new instance of the GMUStaticCluster class defined by it's position, for items of
+ * |clusterCategory|.
+ */
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position
+                 clusterCategory:(nullable NSString *)clusterCategory;
+
+/**
+ * Returns a new instance of the GMUStaticCluster class defined by it's position, for items of
+ * |clusterCategory|, which computes |aggregates| over its items as they are added.
+ */
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position
+                 clusterCategory:(nullable NSString *)clusterCategory
+                      aggregates:(nullable NSArray<GMUClusterAggregate *> *)aggregates
+    NS_DESIGNATED_INITIALIZER;
 
 /**
  * Returns the position of the cluster.
  */
 @property(nonatomic, readonly) CLLocationCoordinate2D position;
 
+/**
+ * Returns the category of the items in the cluster, or nil for items without one.
+ */
+@property(nonatomic, readonly, copy, nullable) NSString *clusterCategory;
+
+/**
+ * Returns the values of the aggregates of the cluster over its items, keyed by name.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *aggregateValues;
+
 /**
  * Returns the number of items in the cluster.
  */
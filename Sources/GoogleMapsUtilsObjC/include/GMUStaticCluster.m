@@ -18,33 +18,107 @@
 #endif
 
 #import "GMUStaticCluster.h"
+#import "GMUStaticCluster+Private.h"
+
+#import "GMUClusterAggregateAccumulator.h"
+
+#include <stdlib.h>
 
 @implementation GMUStaticCluster {
   NSMutableArray<id<GMUClusterItem>> *_items;
+  // The copy of _items returned by items, or nil if _items changed since.
+  NSArray<id<GMUClusterItem>> *_itemsCopy;
+  NSArray<GMUClusterAggregate *> *_aggregates;
+  // One accumulator per aggregate, which is stale once an item is removed.
+  GMUClusterAggregateAccumulator *_accumulators;
+  BOOL _accumulatorsAreStale;
+  // The values returned by aggregateValues, or nil if the items changed since.
+  NSDictionary<NSString *, NSNumber *> *_aggregateValues;
 }
 
 - (instancetype)initWithPosition:(CLLocationCoordinate2D)position {
+  return [self initWithPosition:position clusterCategory:nil];
+}
+
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position
+                 clusterCategory:(NSString *)clusterCategory {
+  return [self initWithPosition:position clusterCategory:clusterCategory aggregates:nil];
+}
+
+- (instancetype)initWithPosition:(CLLocationCoordinate2D)position
+                 clusterCategory:(NSString *)clusterCategory
+                      aggregates:(NSArray<GMUClusterAggregate *> *)aggregates {
   if ((self = [super init])) {
     _items = [[NSMutableArray alloc] init];
     _position = position;
+    _clusterCategory = [clusterCategory copy];
+    if (aggregates.count > 0) {
+      _aggregates = [aggregates copy];
+      _accumulators = malloc(_aggregates.count * sizeof(GMUClusterAggregateAccumulator));
+      GMUClearAccumulators(_accumulators, _aggregates.count);
+    }
   }
   return self;
 }
 
+- (void)dealloc {
+  free(_accumulators);
+}
+
 - (NSUInteger)count {
   return _items.count;
 }
 
 - (NSArray<id<GMUClusterItem>> *)items {
-  return [_items copy];
+  if (!_itemsCopy) {
+    _itemsCopy = [_items copy];
+  }
+  return _itemsCopy;
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)aggregateValues {
+  if (!_aggregates) return @{};
+  if (_accumulatorsAreStale) {
+    GMUClearAccumulators(_accumulators, _aggregates.count);
+    for (id<GMUClusterItem> item in _items) {
+      GMUAccumulateItem(_accumulators, _aggregates, item);
+    }
+    _accumulatorsAreStale = NO;
+  }
+  if (!_aggregateValues) {
+    _aggregateValues = GMUAggregateValues(_aggregates, _accumulators);
+  }
+  return _aggregateValues;
 }
 
 - (void)addItem:(id<GMUClusterItem>)item {
   [_items addObject:item];
+  _itemsCopy = nil;
+  if (_aggregates && !_accumulatorsAreStale) {
+    GMUAccumulateItem(_accumulators, _aggregates, item);
+    _aggregateValues = nil;
+  }
 }
 
 - (void)removeItem:(id<GMUClusterItem>)item {
   [_items removeObject:item];
+  [self noteRemovedItems];
+}
+
+#pragma mark Private
+
+- (void)removeItemIdenticalTo:(id<GMUClusterItem>)item {
+  NSUInteger index = [_items indexOfObjectIdenticalTo:item];
+  if (index == NSNotFound) return;
+  [_items removeObjectAtIndex:index];
+  [self noteRemovedItems];
+}
+
+- (void)noteRemovedItems {
+  _itemsCopy = nil;
+  // Minima and maxima cannot be taken back, so the remaining items are accumulated again when read.
+  _accumulatorsAreStale = YES;
+  _aggregateValues = nil;
 }
 
 @end
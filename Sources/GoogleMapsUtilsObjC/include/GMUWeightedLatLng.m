@@ -37,4 +37,8 @@
   return _point;
 }
 
+- (double)weight {
+  return _intensity;
+}
+
 @end
@@ -0,0 +1,37 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#import "GQTBounds.h"
+
+#include <stddef.h>
+
+/** Summary of a group of items of a GQTPointQuadTree. */
+typedef struct {
+  /** The number of items. */
+  size_t count;
+
+  /** The sum of the weights of the items. */
+  double weight;
+
+  /**
+   * The mean of the points of the items weighted by their weights, or the center of |bounds| if
+   * the weights add up to zero.
+   */
+  GQTPoint centroid;
+
+  /** The smallest bounds containing the points of the items. */
+  GQTBounds bounds;
+} GQTAggregate;
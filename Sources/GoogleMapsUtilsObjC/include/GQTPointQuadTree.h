@@ -14,10 +14,42 @@
  */
 
 #import <Foundation/Foundation.h>
+#import "GQTAggregate.h"
 #import "GQTBounds.h"
 #import "GQTPointQuadTreeItem.h"
 
-@interface GQTPointQuadTree : NSObject
+/**
+ * Identifies an item added to a GQTPointQuadTree, so that it can be removed without searching for
+ * it. A handle stays valid, in the tree and in the copies made after the item was added, until the
+ * item is removed or the tree is cleared.
+ */
+typedef uint64_t GQTPointQuadTreeHandle;
+
+/** A handle which identifies no item. */
+extern const GQTPointQuadTreeHandle kGQTPointQuadTreeInvalidHandle;
+
+/**
+ * Called for every item found by |enumerateItemsInWrappedBounds:usingFunction:context:|, with the
+ * unretained item, to be cast back with __bridge. |point| and |offsetX| are as for
+ * |enumerateItemsInWrappedBounds:usingBlock:|.
+ *
+ * @return |false| to end the enumeration, |true| to continue.
+ */
+typedef bool (*GQTPointQuadTreeWrappedEnumerationFunction)(void *context, const void *item,
+                                                           GQTPoint point, double offsetX);
+
+/**
+ * A point quad tree.
+ *
+ * Copies made with |copy| are immutable snapshots: copying takes constant time because the copy
+ * shares its data with this tree, and the data is only duplicated when this tree is next mutated.
+ * That first mutation copies the node and point arrays, in time linear in the number of items but
+ * without touching the items themselves; the items are shared in pages which are duplicated, and
+ * their items retained, only when an item of the page is added or removed. A snapshot which is
+ * never mutated can be searched from any number of threads at once without locking, while the
+ * original keeps changing on its own thread.
+ */
+@interface GQTPointQuadTree : NSObject <NSCopying>
 
 /**
  * Create a QuadTree with bounds. Please note, this class is not thread safe.
@@ -27,6 +59,85 @@
  */
 - (id)initWithBounds:(GQTBounds)bounds;
 
+/**
+ * Create a QuadTree with bounds and fill it with |items| in a single pass. This is considerably
+ * faster than adding the items one at a time.
+ *
+ * @param bounds The bounds of this PointQuadTree. The tree will only accept items that fall
+                 within the bounds. The bounds are inclusive.
+ * @param items  The items to insert. Items outside |bounds| are ignored.
+ */
+- (id)initWithBounds:(GQTBounds)bounds items:(NSArray<id<GQTPointQuadTreeItem>> *)items;
+
+/**
+ * Create a QuadTree from a file written by |writeToURL:identifierForItem:error:|, possibly on
+ * another machine of the same byte order. The file is memory mapped and searched in place, so
+ * loading takes constant time however many items the tree holds. The file must not be modified
+ * while the tree exists.
+ *
+ * The tree is turned into a regular tree the first time it is mutated. Its items keep being
+ * resolved through |itemForIdentifier| until an item sharing a page with them is added or removed.
+ * Handles of the tree which was written remain valid. Copies share the mapped file.
+ *
+ * @param url               The file URL to read.
+ * @param itemForIdentifier Returns the item with the given identifier. It is called whenever a
+ *                          search returns an item, and must return an item which outlives the
+ *                          tree, for instance an element of an array holding all items.
+ * @param error             Receives an error in NSPOSIXErrorDomain if the file cannot be read or
+ *                          is not a valid tree.
+ * @return The tree, or nil on error.
+ */
+- (id)initWithContentsOfURL:(NSURL *)url
+          itemForIdentifier:(id<GQTPointQuadTreeItem> (^)(uint64_t identifier))itemForIdentifier
+                      error:(NSError **)error;
+
+/**
+ * Write this tree to a file in a flat binary format: a versioned header, followed by the nodes,
+ * the packed points and an identifier for each item. It can be loaded with
+ * |initWithContentsOfURL:itemForIdentifier:error:| without rebuilding the tree.
+ *
+ * @param url               The file URL to write. An existing file is replaced.
+ * @param identifierForItem Returns the identifier to store for an item.
+ * @param error             Receives an error in NSPOSIXErrorDomain if the file cannot be written.
+ * @return |YES| if the file was written.
+ */
+- (BOOL)writeToURL:(NSURL *)url
+    identifierForItem:(uint64_t (^)(id<GQTPointQuadTreeItem> item))identifierForItem
+                error:(NSError **)error;
+
+/**
+ * Create a QuadTree with bounds which optionally keeps aggregates. When |keepsAggregates| is YES,
+ * every node of the tree keeps the count, total weight, weighted centroid and bounds of the items
+ * below it, updated as items are added and removed, for |enumerateAggregatesInBounds:depth:|.
+ * Item weights are read from the optional |weight| method of GQTPointQuadTreeItem.
+ *
+ * @param bounds          The bounds of this PointQuadTree. The tree will only accept items that
+ *                        fall within the bounds. The bounds are inclusive.
+ * @param keepsAggregates Whether the nodes of this tree keep aggregates.
+ */
+- (id)initWithBounds:(GQTBounds)bounds keepsAggregates:(BOOL)keepsAggregates;
+
+/**
+ * Create a QuadTree with bounds and an explicit split policy. Smaller leaves make searches visit
+ * fewer points at the cost of more nodes and more frequent splits while inserting.
+ *
+ * @param bounds          The bounds of this PointQuadTree. The tree will only accept items that
+ *                        fall within the bounds. The bounds are inclusive.
+ * @param leafCapacity    The number of items a leaf holds before it is split, 0 for the default
+ *                        of 64. Clamped to [4, 4096].
+ * @param maxDepth        The depth below which leaves are never split, 0 for the default of 30.
+ *                        Clamped to [1, 48].
+ * @param adaptive        Whether a full leaf is only split when that separates its items. Leaves
+ *                        holding many items at one location then grow instead of splitting into
+ *                        a chain of nodes down to |maxDepth|.
+ * @param keepsAggregates Whether the nodes of this tree keep aggregates.
+ */
+- (id)initWithBounds:(GQTBounds)bounds
+        leafCapacity:(NSUInteger)leafCapacity
+            maxDepth:(NSUInteger)maxDepth
+            adaptive:(BOOL)adaptive
+     keepsAggregates:(BOOL)keepsAggregates;
+
 /**
  * Create a QuadTree with the inclusive bounds of (-1,-1) to (1,1).
  */
@@ -41,6 +152,35 @@
  */
 - (BOOL)add:(id<GQTPointQuadTreeItem>)item;
 
+/**
+ * Insert an item into this PointQuadTree and return a handle for removing it later.
+ *
+ * @param item The item to insert. Must not be nil.
+ * @return The handle of the item, or |kGQTPointQuadTreeInvalidHandle| if the item is nil or not
+ *         contained within the bounds of this tree.
+ */
+- (GQTPointQuadTreeHandle)addReturningHandle:(id<GQTPointQuadTreeItem>)item;
+
+/**
+ * Insert multiple items into this PointQuadTree. When |items| is at least as large as the tree,
+ * the whole tree is rebuilt in a single pass instead of inserting the items one at a time.
+ *
+ * @param items The items to insert. Items outside the bounds of this tree are ignored.
+ * @return The number of items added.
+ */
+- (NSUInteger)addItems:(NSArray<id<GQTPointQuadTreeItem>> *)items;
+
+/**
+ * Insert multiple items into this PointQuadTree like |addItems:|, returning a handle for each.
+ *
+ * @param items   The items to insert. Items outside the bounds of this tree are ignored.
+ * @param handles Receives |items.count| handles, in the order of |items|. Ignored items get
+ *                |kGQTPointQuadTreeInvalidHandle|.
+ * @return The number of items added.
+ */
+- (NSUInteger)addItems:(NSArray<id<GQTPointQuadTreeItem>> *)items
+               handles:(GQTPointQuadTreeHandle *)handles;
+
 /**
  * Delete an item from this PointQuadTree.
  *
@@ -49,6 +189,15 @@
  */
 - (BOOL)remove:(id<GQTPointQuadTreeItem>)item;
 
+/**
+ * Delete the item identified by |handle| from this PointQuadTree. Unlike |remove:|, this neither
+ * searches the item's leaf nor compares items, and takes constant time.
+ *
+ * @param handle The handle returned when the item was added.
+ * @return |NO| if |handle| does not identify an item of this tree, |YES| otherwise.
+ */
+- (BOOL)removeItemWithHandle:(GQTPointQuadTreeHandle)handle;
+
 /**
  * Delete all items from this PointQuadTree.
  */
@@ -63,6 +212,221 @@
  */
 - (NSArray *)searchWithBounds:(GQTBounds)bounds;
 
+/**
+ * Enumerate the items in this PointQuadTree within a bounding box without collecting them in an
+ * array. The items are not retained by the enumeration.
+ *
+ * @param bounds The bounds of the search box.
+ * @param block  Called with each item within |bounds| and its point. Set |*stop| to YES to end
+ *               the enumeration.
+ */
+- (void)enumerateItemsInBounds:(GQTBounds)bounds
+                    usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                         BOOL *stop))block;
+
+/**
+ * Retrieve the items in this PointQuadTree within each of several bounding boxes at once. Large
+ * batches are searched on all cores, with neighbouring boxes searched together. The tree must not
+ * be mutated until this returns; search a copy to keep mutating the tree meanwhile.
+ *
+ * @param boundsArray The bounds of the search boxes.
+ * @param count       The number of search boxes.
+ * @return One NSArray of id<GQTPointQuadTreeItem> per search box, in the order of |boundsArray|,
+ *         holding the items |searchWithBounds:| would return for that box.
+ */
+- (NSArray<NSArray *> *)searchWithBoundsArray:(const GQTBounds *)boundsArray
+                                        count:(NSUInteger)count;
+
+/**
+ * Count the items in this PointQuadTree within each of several bounding boxes at once, like
+ * |searchWithBoundsArray:count:|.
+ *
+ * @param boundsArray The bounds of the search boxes.
+ * @param count       The number of search boxes.
+ * @param counts      Receives |count| counts, in the order of |boundsArray|.
+ */
+- (void)countInBoundsArray:(const GQTBounds *)boundsArray
+                     count:(NSUInteger)count
+                    counts:(NSUInteger *)counts;
+
+/**
+ * Enumerate the items within a bounding box of the plane tiled horizontally by copies of this
+ * PointQuadTree, as on a map which wraps around at the antimeridian. |bounds| may extend past the
+ * left or right edge of the tree, and every copy of the tree it covers is searched in a single
+ * traversal. Items are not retained by the enumeration.
+ *
+ * @param bounds The bounds of the search box.
+ * @param block  Called with each item found, once per copy of the tree it is found in. |point| is
+ *               the point of the item in that copy, within |bounds|, and |offsetX| is the
+ *               horizontal offset of the copy. Set |*stop| to YES to end the enumeration.
+ */
+- (void)enumerateItemsInWrappedBounds:(GQTBounds)bounds
+                           usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                                double offsetX, BOOL *stop))block;
+
+/**
+ * Enumerate the items |enumerateItemsInWrappedBounds:usingBlock:| would, calling |function| with
+ * |context| instead of a block. Meant for loops visiting many items, which then make no block call
+ * or message send per item.
+ *
+ * @param bounds   The bounds of the search box.
+ * @param function Called with |context| and each item found, once per copy of the tree it is
+ *                 found in.
+ */
+- (void)enumerateItemsInWrappedBounds:(GQTBounds)bounds
+                        usingFunction:(GQTPointQuadTreeWrappedEnumerationFunction)function
+                              context:(void *)context;
+
+/**
+ * Count the items |enumerateItemsInWrappedBounds:usingBlock:| would enumerate, without retrieving
+ * them.
+ *
+ * @param bounds The bounds of the search box.
+ * @return The number of items within |bounds|, counting each copy of the tree separately.
+ */
+- (NSUInteger)countInWrappedBounds:(GQTBounds)bounds;
+
+/**
+ * Retrieve all items in this PointQuadTree within a circle. Parts of the tree entirely outside the
+ * circle are skipped and parts entirely inside it are returned without testing each item.
+ *
+ * @param center The center of the circle.
+ * @param radius The radius of the circle. Items at exactly |radius| from |center| are included.
+ * @return The collection of items within the circle, returned as an NSArray
+ *         of id<GQTPointQuadTreeItem>.
+ */
+- (NSArray *)searchWithCenter:(GQTPoint)center radius:(double)radius;
+
+/**
+ * Enumerate the items in this PointQuadTree within a circle without collecting them in an array.
+ * The items are not retained by the enumeration.
+ *
+ * @param center The center of the circle.
+ * @param radius The radius of the circle. Items at exactly |radius| from |center| are included.
+ * @param block  Called with each item within the circle and its point. Set |*stop| to YES to end
+ *               the enumeration.
+ */
+- (void)enumerateItemsWithCenter:(GQTPoint)center
+                          radius:(double)radius
+                      usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                           BOOL *stop))block;
+
+/**
+ * Retrieve all items in this PointQuadTree inside a polygon. The polygon is implicitly closed, its
+ * edges are straight lines between the points of the tree, and it may be concave or
+ * self-intersecting, in which case the even-odd rule applies. Items exactly on an edge may or may
+ * not be returned.
+ *
+ * @param vertices The vertices of the polygon.
+ * @param count    The number of vertices. Polygons with fewer than 3 vertices contain no items.
+ * @return The collection of items inside the polygon, returned as an NSArray
+ *         of id<GQTPointQuadTreeItem>.
+ */
+- (NSArray *)searchWithPolygon:(const GQTPoint *)vertices count:(NSUInteger)count;
+
+/**
+ * Enumerate the items in this PointQuadTree inside a polygon, as returned by
+ * |searchWithPolygon:count:|, without collecting them in an array. The items are not retained by
+ * the enumeration.
+ *
+ * @param vertices The vertices of the polygon.
+ * @param count    The number of vertices.
+ * @param block    Called with each item inside the polygon and its point. Set |*stop| to YES to
+ *                 end the enumeration.
+ */
+- (void)enumerateItemsInPolygon:(const GQTPoint *)vertices
+                          count:(NSUInteger)count
+                     usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                          BOOL *stop))block;
+
+/**
+ * Count the items in this PointQuadTree within a bounding box without retrieving them.
+ *
+ * @param bounds The bounds of the search box.
+ * @return The number of items within |bounds|.
+ */
+- (NSUInteger)countInBounds:(GQTBounds)bounds;
+
+/**
+ * Enumerate the aggregates of the items in this PointQuadTree, grouped by the quads at |depth|:
+ * the bounds of the tree are divided into a grid of 2^depth by 2^depth quads, and |block| is
+ * called with the aggregate of every non-empty quad intersecting |bounds|. An aggregate covers all
+ * items of its quad, including those outside |bounds|.
+ *
+ * The aggregates are read from the nodes of the tree, so the cost depends on the number of quads
+ * rather than the number of items. Does nothing unless this tree keeps aggregates.
+ *
+ * @param bounds The bounds of the search box.
+ * @param depth  The depth of the quads to aggregate. 0 aggregates the whole tree.
+ * @param block  Called with each aggregate. Set |*stop| to YES to end the enumeration.
+ */
+- (void)enumerateAggregatesInBounds:(GQTBounds)bounds
+                              depth:(NSUInteger)depth
+                         usingBlock:(void (^)(GQTAggregate aggregate, BOOL *stop))block;
+
+/**
+ * Retrieve the item closest to a point.
+ *
+ * @param point The point to search around.
+ * @return The closest item, or nil if this tree is empty.
+ */
+- (id<GQTPointQuadTreeItem>)nearestItemToPoint:(GQTPoint)point;
+
+/**
+ * Retrieve the item closest to a point, ignoring items further away than |maximumDistance|.
+ *
+ * @param point           The point to search around.
+ * @param maximumDistance The distance beyond which items are ignored.
+ * @return The closest item, or nil if there is none within |maximumDistance|.
+ */
+- (id<GQTPointQuadTreeItem>)nearestItemToPoint:(GQTPoint)point
+                               maximumDistance:(double)maximumDistance;
+
+/**
+ * Retrieve the |count| items closest to a point.
+ *
+ * @param count The maximum number of items to return.
+ * @param point The point to search around.
+ * @return Up to |count| items, returned as an NSArray of id<GQTPointQuadTreeItem> sorted from
+ *         nearest to furthest.
+ */
+- (NSArray *)nearestItems:(NSUInteger)count toPoint:(GQTPoint)point;
+
+/**
+ * Retrieve the |count| items closest to a point, ignoring items further away than
+ * |maximumDistance|. Nodes of the tree are visited in order of their distance to |point|, so only
+ * the part of the tree around |point| is searched.
+ *
+ * @param count           The maximum number of items to return.
+ * @param point           The point to search around.
+ * @param maximumDistance The distance beyond which items are ignored.
+ * @return Up to |count| items, returned as an NSArray of id<GQTPointQuadTreeItem> sorted from
+ *         nearest to furthest.
+ */
+- (NSArray *)nearestItems:(NSUInteger)count
+                  toPoint:(GQTPoint)point
+          maximumDistance:(double)maximumDistance;
+
+/**
+ * Whether the nodes of this tree keep aggregates.
+ */
+- (BOOL)keepsAggregates;
+
+/**
+ * The number of items a leaf of this tree holds before it is split.
+ */
+- (NSUInteger)leafCapacity;
+
+/**
+ * The depth below which the leaves of this tree are never split.
+ */
+- (NSUInteger)maxDepth;
+
+/**
+ * Whether this tree only splits leaves whose items can be separated.
+ */
+- (BOOL)isAdaptive;
+
 /**
  * The number of items in this entire tree.
  *
@@ -18,33 +18,158 @@
 #endif
 
 #import "GQTPointQuadTree.h"
-#import "GQTPointQuadTreeChild.h"
+#import "GQTPointQuadTreeStorage.h"
 #import <GoogleMaps/GoogleMaps.h>
 #import "GMUVersion.h"
 
-@implementation GQTPointQuadTree {
-  /**
-   * The bounds of this PointQuadTree.
-   */
-  GQTBounds bounds_;
+const GQTPointQuadTreeHandle kGQTPointQuadTreeInvalidHandle = kGQTInvalidItemHandle;
 
-  /**
-   * The Quad Tree data structure.
-   */
-  GQTPointQuadTreeChild *root_;
+static const void *GQTRetainItem(const void *item) { return CFRetain(item); }
+
+static void GQTReleaseItem(const void *item) { CFRelease(item); }
+
+static double GQTItemWeight(const void *item) {
+  id<GQTPointQuadTreeItem> quadItem = (__bridge id<GQTPointQuadTreeItem>)item;
+  return [quadItem respondsToSelector:@selector(weight)] ? [quadItem weight] : 1;
+}
+
+static const GQTItemCallBacks kGQTItemCallBacks = {GQTRetainItem, GQTReleaseItem, GQTItemWeight};
+
+static void GQTAddAttribution(void) {
+  NSString *attributionID =
+      [NSString stringWithFormat:@"gmp_git_iosmapsutils_v%@_quadtree", GMU_VERSION];
+  [GMSServices addInternalUsageAttributionID:attributionID];
+}
+
+typedef id<GQTPointQuadTreeItem> (^GQTItemForIdentifierBlock)(uint64_t identifier);
+
+static const void *GQTResolveItem(void *context, uint64_t identifier) {
+  return (__bridge const void *)((__bridge GQTItemForIdentifierBlock)context)(identifier);
+}
+
+static void GQTReleaseResolverContext(void *context) { CFBridgingRelease(context); }
+
+typedef uint64_t (^GQTIdentifierForItemBlock)(id<GQTPointQuadTreeItem> item);
+
+static uint64_t GQTIdentifyItem(void *context, const void *item) {
+  return ((__bridge GQTIdentifierForItemBlock)context)((__bridge id)item);
+}
+
+// Returns the error for the last failed file operation on |url|, as reported by errno.
+static NSError *GQTFileError(NSURL *url) {
+  int code = errno;
+  return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:@{NSURLErrorKey : url}];
+}
+
+static bool GQTAddItemToArray(void *context, const void *item, GQTPoint point) {
+  [(__bridge NSMutableArray *)context addObject:(__bridge id)item];
+  return true;
+}
 
+typedef void (^GQTPointQuadTreeEnumerationBlock)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                                 BOOL *stop);
+
+static bool GQTCallEnumerationBlock(void *context, const void *item, GQTPoint point) {
+  BOOL stop = NO;
+  ((__bridge GQTPointQuadTreeEnumerationBlock)context)((__bridge id)item, point, &stop);
+  return !stop;
+}
+
+static bool GQTAddItemToBatchArray(void *context, size_t query, const void *item,
+                                   GQTPoint point) {
+  // The batch array is not mutated during the search, and each of its arrays is only ever used by
+  // one thread at a time.
+  NSArray<NSMutableArray *> *results = (__bridge NSArray<NSMutableArray *> *)context;
+  [results[query] addObject:(__bridge id)item];
+  return true;
+}
+
+typedef void (^GQTPointQuadTreeWrappedEnumerationBlock)(id<GQTPointQuadTreeItem> item,
+                                                        GQTPoint point, double offsetX,
+                                                        BOOL *stop);
+
+static bool GQTCallWrappedEnumerationBlock(void *context, const void *item, GQTPoint point,
+                                           double offsetX) {
+  BOOL stop = NO;
+  ((__bridge GQTPointQuadTreeWrappedEnumerationBlock)context)((__bridge id)item, point, offsetX,
+                                                              &stop);
+  return !stop;
+}
+
+typedef void (^GQTPointQuadTreeAggregateBlock)(GQTAggregate aggregate, BOOL *stop);
+
+static bool GQTCallAggregateBlock(void *context, GQTAggregate aggregate) {
+  BOOL stop = NO;
+  ((__bridge GQTPointQuadTreeAggregateBlock)context)(aggregate, &stop);
+  return !stop;
+}
+
+static bool GQTItemIsEqual(void *context, const void *item) {
+  return [(__bridge id)item isEqual:(__bridge id)context];
+}
+
+@implementation GQTPointQuadTree {
   /**
-   * The number of items in this tree.
+   * The Quad Tree data structure, which also holds the bounds and number of items of this tree.
+   * It is shared with the copies of this tree until one of them is mutated.
    */
-  NSUInteger count_;
+  GQTPointQuadTreeStorage *storage_;
 }
 
 - (id)initWithBounds:(GQTBounds)bounds {
+  return [self initWithBounds:bounds keepsAggregates:NO];
+}
+
+- (id)initWithBounds:(GQTBounds)bounds keepsAggregates:(BOOL)keepsAggregates {
+  return [self initWithBounds:bounds
+                 leafCapacity:0
+                     maxDepth:0
+                     adaptive:NO
+              keepsAggregates:keepsAggregates];
+}
+
+- (id)initWithBounds:(GQTBounds)bounds
+        leafCapacity:(NSUInteger)leafCapacity
+            maxDepth:(NSUInteger)maxDepth
+            adaptive:(BOOL)adaptive
+     keepsAggregates:(BOOL)keepsAggregates {
   if (self = [super init]) {
-    NSString *attributionID = [NSString stringWithFormat:@"gmp_git_iosmapsutils_v%@_quadtree", GMU_VERSION];
-    [GMSServices addInternalUsageAttributionID:attributionID];
-    bounds_ = bounds;
-    [self clear];
+    GQTAddAttribution();
+    GQTPointQuadTreeStorageOptions options = {
+        .keepsAggregates = keepsAggregates,
+        .leafCapacity = (uint32_t)MIN(leafCapacity, (NSUInteger)kGQTMaxLeafCapacity),
+        .maxDepth = (uint32_t)MIN(maxDepth, (NSUInteger)kGQTMaxMaxDepth),
+        .adaptive = adaptive,
+    };
+    storage_ = GQTPointQuadTreeStorageCreate(bounds, &kGQTItemCallBacks, &options);
+  }
+  return self;
+}
+
+- (id)initWithBounds:(GQTBounds)bounds items:(NSArray<id<GQTPointQuadTreeItem>> *)items {
+  if (self = [self initWithBounds:bounds]) {
+    [self addItems:items];
+  }
+  return self;
+}
+
+- (id)initWithContentsOfURL:(NSURL *)url
+          itemForIdentifier:(id<GQTPointQuadTreeItem> (^)(uint64_t identifier))itemForIdentifier
+                      error:(NSError **)error {
+  if (self = [super init]) {
+    GQTAddAttribution();
+    // The storage owns the block from now on, and releases it when it is freed.
+    GQTItemResolver resolver = {GQTResolveItem, GQTReleaseResolverContext,
+                                (__bridge_retained void *)[itemForIdentifier copy]};
+    storage_ = GQTPointQuadTreeStorageCreateWithFile(url.fileSystemRepresentation,
+                                                     &kGQTItemCallBacks, &resolver);
+    if (storage_ == NULL) {
+      if (error != NULL) {
+        *error = GQTFileError(url);
+      }
+      GQTReleaseResolverContext(resolver.context);
+      return nil;
+    }
   }
   return self;
 }
@@ -53,23 +178,92 @@
   return [self initWithBounds:(GQTBounds){-1, -1, 1, 1}];
 }
 
+- (id)initWithStorage:(GQTPointQuadTreeStorage *)storage {
+  if (self = [super init]) {
+    storage_ = GQTPointQuadTreeStorageRetain(storage);
+  }
+  return self;
+}
+
+- (void)dealloc {
+  GQTPointQuadTreeStorageRelease(storage_);
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+  return [[GQTPointQuadTree allocWithZone:zone] initWithStorage:storage_];
+}
+
+/**
+ * Give this tree a storage of its own if it shares its storage with a copy, so that it can be
+ * mutated without affecting the copy.
+ */
+- (void)prepareForMutation {
+  if (GQTPointQuadTreeStorageIsShared(storage_)) {
+    GQTPointQuadTreeStorage *storage = GQTPointQuadTreeStorageCopy(storage_);
+    GQTPointQuadTreeStorageRelease(storage_);
+    storage_ = storage;
+  }
+}
+
+- (BOOL)writeToURL:(NSURL *)url
+    identifierForItem:(uint64_t (^)(id<GQTPointQuadTreeItem> item))identifierForItem
+                error:(NSError **)error {
+  if (!GQTPointQuadTreeStorageWriteToFile(storage_, url.fileSystemRepresentation, GQTIdentifyItem,
+                                          (__bridge void *)identifierForItem)) {
+    if (error != NULL) {
+      *error = GQTFileError(url);
+    }
+    return NO;
+  }
+  return YES;
+}
+
 - (BOOL)add:(id<GQTPointQuadTreeItem>)item {
   if (item == nil) {
     // Item must not be nil.
     return NO;
   }
 
-  GQTPoint point = item.point;
-  if (point.x > bounds_.maxX || point.x < bounds_.minX || point.y > bounds_.maxY ||
-      point.y < bounds_.minY) {
-    return NO;
+  [self prepareForMutation];
+  return GQTPointQuadTreeStorageAdd(storage_, item.point, (__bridge const void *)item, NULL);
+}
+
+- (GQTPointQuadTreeHandle)addReturningHandle:(id<GQTPointQuadTreeItem>)item {
+  if (item == nil) {
+    return kGQTPointQuadTreeInvalidHandle;
   }
 
-  [root_ add:item withOwnBounds:bounds_ atDepth:0];
+  [self prepareForMutation];
+  GQTItemHandle handle;
+  GQTPointQuadTreeStorageAdd(storage_, item.point, (__bridge const void *)item, &handle);
+  return handle;
+}
 
-  ++count_;
+- (NSUInteger)addItems:(NSArray<id<GQTPointQuadTreeItem>> *)items {
+  return [self addItems:items handles:NULL];
+}
 
-  return YES;
+- (NSUInteger)addItems:(NSArray<id<GQTPointQuadTreeItem>> *)items
+               handles:(GQTPointQuadTreeHandle *)handles {
+  NSUInteger count = items.count;
+  if (count == 0) {
+    return 0;
+  }
+
+  GQTPoint *points = malloc(count * sizeof(GQTPoint));
+  const void **itemPointers = malloc(count * sizeof(void *));
+  NSUInteger index = 0;
+  for (id<GQTPointQuadTreeItem> item in items) {
+    points[index] = item.point;
+    itemPointers[index] = (__bridge const void *)item;
+    ++index;
+  }
+  [self prepareForMutation];
+  NSUInteger added =
+      GQTPointQuadTreeStorageAddBatch(storage_, points, itemPointers, count, handles);
+  free(points);
+  free(itemPointers);
+  return added;
 }
 
 /**
@@ -78,27 +272,33 @@
  * @param item The item to delete.
  */
 - (BOOL)remove:(id<GQTPointQuadTreeItem>)item {
-  GQTPoint point = item.point;
-  if (point.x > bounds_.maxX || point.x < bounds_.minX || point.y > bounds_.maxY ||
-      point.y < bounds_.minY) {
+  if (item == nil) {
     return NO;
   }
 
-  BOOL removed = [root_ remove:item withOwnBounds:bounds_];
-
-  if (removed) {
-    --count_;
-  }
+  [self prepareForMutation];
+  return GQTPointQuadTreeStorageRemove(storage_, item.point, GQTItemIsEqual,
+                                       (__bridge void *)item);
+}
 
-  return removed;
+- (BOOL)removeItemWithHandle:(GQTPointQuadTreeHandle)handle {
+  [self prepareForMutation];
+  return GQTPointQuadTreeStorageRemoveHandle(storage_, handle);
 }
 
 /**
  * Delete all items from this PointQuadTree
  */
 - (void)clear {
-  root_ = [[GQTPointQuadTreeChild alloc] init];
-  count_ = 0;
+  if (GQTPointQuadTreeStorageIsShared(storage_)) {
+    // Start over with an empty storage rather than copying the items only to release them.
+    GQTBounds bounds = GQTPointQuadTreeStorageGetBounds(storage_);
+    GQTPointQuadTreeStorageOptions options = GQTPointQuadTreeStorageGetOptions(storage_);
+    GQTPointQuadTreeStorageRelease(storage_);
+    storage_ = GQTPointQuadTreeStorageCreate(bounds, &kGQTItemCallBacks, &options);
+    return;
+  }
+  GQTPointQuadTreeStorageClear(storage_);
 }
 
 /**
@@ -108,12 +308,151 @@
  */
 - (NSArray *)searchWithBounds:(GQTBounds)searchBounds {
   NSMutableArray *results = [NSMutableArray array];
-  [root_ searchWithBounds:searchBounds withOwnBounds:bounds_ results:results];
+  GQTPointQuadTreeStorageSearch(storage_, searchBounds, GQTAddItemToArray,
+                                (__bridge void *)results);
+  return results;
+}
+
+- (void)enumerateItemsInBounds:(GQTBounds)bounds
+                    usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                         BOOL *stop))block {
+  GQTPointQuadTreeStorageSearch(storage_, bounds, GQTCallEnumerationBlock,
+                                (__bridge void *)block);
+}
+
+- (NSArray<NSArray *> *)searchWithBoundsArray:(const GQTBounds *)boundsArray
+                                        count:(NSUInteger)count {
+  NSMutableArray<NSMutableArray *> *results = [[NSMutableArray alloc] initWithCapacity:count];
+  for (NSUInteger i = 0; i < count; ++i) {
+    [results addObject:[NSMutableArray array]];
+  }
+  GQTPointQuadTreeStorageSearchBatch(storage_, boundsArray, count, GQTAddItemToBatchArray,
+                                     (__bridge void *)results);
+  return results;
+}
+
+- (void)countInBoundsArray:(const GQTBounds *)boundsArray
+                     count:(NSUInteger)count
+                    counts:(NSUInteger *)counts {
+  _Static_assert(sizeof(NSUInteger) == sizeof(size_t), "NSUInteger must match size_t");
+  GQTPointQuadTreeStorageCountInBoundsBatch(storage_, boundsArray, count, (size_t *)counts);
+}
+
+- (void)enumerateItemsInWrappedBounds:(GQTBounds)bounds
+                           usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                                double offsetX, BOOL *stop))block {
+  GQTPointQuadTreeStorageSearchWrapped(storage_, bounds, GQTCallWrappedEnumerationBlock,
+                                       (__bridge void *)block);
+}
+
+- (void)enumerateItemsInWrappedBounds:(GQTBounds)bounds
+                        usingFunction:(GQTPointQuadTreeWrappedEnumerationFunction)function
+                              context:(void *)context {
+  GQTPointQuadTreeStorageSearchWrapped(storage_, bounds, function, context);
+}
+
+- (NSUInteger)countInWrappedBounds:(GQTBounds)bounds {
+  return GQTPointQuadTreeStorageCountInWrappedBounds(storage_, bounds);
+}
+
+- (NSArray *)searchWithCenter:(GQTPoint)center radius:(double)radius {
+  NSMutableArray *results = [NSMutableArray array];
+  GQTPointQuadTreeStorageSearchCircle(storage_, center, radius, GQTAddItemToArray,
+                                      (__bridge void *)results);
   return results;
 }
 
+- (void)enumerateItemsWithCenter:(GQTPoint)center
+                          radius:(double)radius
+                      usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                           BOOL *stop))block {
+  GQTPointQuadTreeStorageSearchCircle(storage_, center, radius, GQTCallEnumerationBlock,
+                                      (__bridge void *)block);
+}
+
+- (NSArray *)searchWithPolygon:(const GQTPoint *)vertices count:(NSUInteger)count {
+  NSMutableArray *results = [NSMutableArray array];
+  GQTPointQuadTreeStorageSearchPolygon(storage_, vertices, count, GQTAddItemToArray,
+                                       (__bridge void *)results);
+  return results;
+}
+
+- (void)enumerateItemsInPolygon:(const GQTPoint *)vertices
+                          count:(NSUInteger)count
+                     usingBlock:(void (^)(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                          BOOL *stop))block {
+  GQTPointQuadTreeStorageSearchPolygon(storage_, vertices, count, GQTCallEnumerationBlock,
+                                       (__bridge void *)block);
+}
+
+- (NSUInteger)countInBounds:(GQTBounds)bounds {
+  return GQTPointQuadTreeStorageCountInBounds(storage_, bounds);
+}
+
+- (void)enumerateAggregatesInBounds:(GQTBounds)bounds
+                              depth:(NSUInteger)depth
+                         usingBlock:(void (^)(GQTAggregate aggregate, BOOL *stop))block {
+  GQTPointQuadTreeStorageSearchAggregates(storage_, bounds, (uint32_t)MIN(depth, UINT32_MAX),
+                                          GQTCallAggregateBlock, (__bridge void *)block);
+}
+
+- (id<GQTPointQuadTreeItem>)nearestItemToPoint:(GQTPoint)point {
+  return [self nearestItemToPoint:point maximumDistance:INFINITY];
+}
+
+- (id<GQTPointQuadTreeItem>)nearestItemToPoint:(GQTPoint)point
+                               maximumDistance:(double)maximumDistance {
+  const void *item = NULL;
+  double distance;
+  if (GQTPointQuadTreeStorageNearest(storage_, point, 1, maximumDistance, &item, &distance) == 0) {
+    return nil;
+  }
+  return (__bridge id<GQTPointQuadTreeItem>)item;
+}
+
+- (NSArray *)nearestItems:(NSUInteger)count toPoint:(GQTPoint)point {
+  return [self nearestItems:count toPoint:point maximumDistance:INFINITY];
+}
+
+- (NSArray *)nearestItems:(NSUInteger)count
+                  toPoint:(GQTPoint)point
+          maximumDistance:(double)maximumDistance {
+  count = MIN(count, (NSUInteger)GQTPointQuadTreeStorageGetCount(storage_));
+  if (count == 0) {
+    return @[];
+  }
+
+  const void **items = malloc(count * sizeof(void *));
+  double *distances = malloc(count * sizeof(double));
+  size_t found =
+      GQTPointQuadTreeStorageNearest(storage_, point, count, maximumDistance, items, distances);
+  NSMutableArray *results = [NSMutableArray arrayWithCapacity:found];
+  for (size_t i = 0; i < found; ++i) {
+    [results addObject:(__bridge id)items[i]];
+  }
+  free(items);
+  free(distances);
+  return results;
+}
+
+- (BOOL)keepsAggregates {
+  return GQTPointQuadTreeStorageGetOptions(storage_).keepsAggregates;
+}
+
+- (NSUInteger)leafCapacity {
+  return GQTPointQuadTreeStorageGetOptions(storage_).leafCapacity;
+}
+
+- (NSUInteger)maxDepth {
+  return GQTPointQuadTreeStorageGetOptions(storage_).maxDepth;
+}
+
+- (BOOL)isAdaptive {
+  return GQTPointQuadTreeStorageGetOptions(storage_).adaptive;
+}
+
 - (NSUInteger)count {
-  return count_;
+  return GQTPointQuadTreeStorageGetCount(storage_);
 }
 
 @end
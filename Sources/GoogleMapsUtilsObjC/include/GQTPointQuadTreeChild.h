@@ -21,7 +21,9 @@
  * This is an internal class, use |GQTPointQuadTree| instead.
  * Please note, this class is not thread safe.
  *
- * This class represents an internal node of a |GQTPointQuadTree|.
+ * This class represents a node of the object-per-node quad tree which |GQTPointQuadTree| used
+ * before it moved to |GQTPointQuadTreeStorage|. It is kept as the reference implementation the
+ * quad tree benchmarks compare against.
  */
 
 @interface GQTPointQuadTreeChild : NSObject
@@ -20,4 +20,12 @@
 
 - (GQTPoint)point;
 
+@optional
+
+/**
+ * The weight of this item, added up in the aggregates of trees which keep aggregates. Items which
+ * do not implement this method weigh 1.
+ */
+- (double)weight;
+
 @end
@@ -0,0 +1,414 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "GQTAggregate.h"
+#import "GQTBounds.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * This is an internal data structure, use |GQTPointQuadTree| instead.
+ * Please note, this structure is not thread safe. A storage which is no longer mutated may however
+ * be searched from any number of threads at once.
+ *
+ * A point quad tree which keeps all of its nodes in one contiguous pool. Leaf points are stored in
+ * fixed size blocks of packed x and y coordinate arrays, with the index of the owning item stored
+ * next to them, so a range query never has to dereference an item.
+ *
+ * Items are opaque pointers which are retained and released through the GQTItemCallBacks given at
+ * creation time.
+ *
+ * Storages are reference counted so that several trees can share one until either is mutated; see
+ * GQTPointQuadTreeStorageIsShared and GQTPointQuadTreeStorageCopy. Only the reference count is
+ * thread safe.
+ */
+typedef struct GQTPointQuadTreeStorage GQTPointQuadTreeStorage;
+
+/** Index of a node, point block or item slot inside a GQTPointQuadTreeStorage. */
+typedef uint32_t GQTIndex;
+
+/** Marks the absence of a node, point block or item slot. */
+#define kGQTNullIndex ((GQTIndex)UINT32_MAX)
+
+/**
+ * Identifies an item of a GQTPointQuadTreeStorage, and of the copies made after the item was added,
+ * for as long as the item is stored. Handles of removed items are never reused.
+ */
+typedef uint64_t GQTItemHandle;
+
+/** A handle which matches no item. */
+#define kGQTInvalidItemHandle ((GQTItemHandle)UINT64_MAX)
+
+/** Called when an item is added to the storage. Returns the value to store. */
+typedef const void *(*GQTItemRetainCallBack)(const void *item);
+
+/** Called when an item is removed from the storage. */
+typedef void (*GQTItemReleaseCallBack)(const void *item);
+
+/** Called when an item is added to a storage which keeps aggregates. Returns its weight. */
+typedef double (*GQTItemWeightCallBack)(const void *item);
+
+/**
+ * Callbacks for the items of a GQTPointQuadTreeStorage. All may be NULL; items weigh 1 when
+ * |weight| is NULL.
+ */
+typedef struct {
+  GQTItemRetainCallBack retain;
+  GQTItemReleaseCallBack release;
+  GQTItemWeightCallBack weight;
+} GQTItemCallBacks;
+
+/** Called when a storage is written to a file. Returns the identifier to store for |item|. */
+typedef uint64_t (*GQTItemIdentifierCallBack)(void *context, const void *item);
+
+/**
+ * Turns the identifiers of the items of a storage created from a file back into items. Storages
+ * without a resolver hand out the identifiers themselves, cast to pointers.
+ */
+typedef struct {
+  /**
+   * Returns the item identified by |identifier|. It is called whenever a search hands out an item
+   * and must return an item which outlives the storage, without retaining it.
+   */
+  const void *(*resolve)(void *context, uint64_t identifier);
+
+  /** Called with |context| when the storage is freed. May be NULL. */
+  void (*releaseContext)(void *context);
+
+  void *context;
+} GQTItemResolver;
+
+/** Options of a GQTPointQuadTreeStorage. */
+typedef struct {
+  /**
+   * Whether every node keeps the aggregate of the items below it, updated as items are added and
+   * removed. Required by GQTPointQuadTreeStorageSearchAggregates.
+   */
+  bool keepsAggregates;
+
+  /**
+   * Number of points a leaf holds before it is split, which is also the size of the point blocks
+   * leaves are made of. 0 selects kGQTDefaultLeafCapacity; other values are clamped to
+   * [kGQTMinLeafCapacity, kGQTMaxLeafCapacity].
+   */
+  uint32_t leafCapacity;
+
+  /**
+   * Depth at which leaves stop being split and chain additional point blocks instead. 0 selects
+   * kGQTDefaultMaxDepth; other values are clamped to [1, kGQTMaxMaxDepth].
+   */
+  uint32_t maxDepth;
+
+  /**
+   * Whether a full leaf is only split when that separates its points. A leaf whose points would
+   * all end up in the same leaf at maxDepth, such as many items at one coordinate, grows instead,
+   * so dense spots get fewer, larger leaves while sparse areas keep leafCapacity.
+   */
+  bool adaptive;
+} GQTPointQuadTreeStorageOptions;
+
+/** Leaf capacity used when GQTPointQuadTreeStorageOptions.leafCapacity is 0. */
+#define kGQTDefaultLeafCapacity 64
+
+/** Bounds of GQTPointQuadTreeStorageOptions.leafCapacity. */
+#define kGQTMinLeafCapacity 4
+#define kGQTMaxLeafCapacity 4096
+
+/** Maximum depth used when GQTPointQuadTreeStorageOptions.maxDepth is 0. */
+#define kGQTDefaultMaxDepth 30
+
+/** Upper bound of GQTPointQuadTreeStorageOptions.maxDepth, past which doubles stop halving. */
+#define kGQTMaxMaxDepth 48
+
+/**
+ * Called for every item found by a search.
+ *
+ * @return |false| to stop the search, |true| to continue.
+ */
+typedef bool (*GQTPointQuadTreeVisitor)(void *context, const void *item, GQTPoint point);
+
+/**
+ * Called for every item found by the search of |searchBounds[query]| in a batch search.
+ *
+ * @return |false| to stop the search of |query|, |true| to continue.
+ */
+typedef bool (*GQTPointQuadTreeBatchVisitor)(void *context, size_t query, const void *item,
+                                             GQTPoint point);
+
+/**
+ * Called for every item found by a wrapped search. |point| is the point of |item| with |offsetX|
+ * added to its x coordinate, which moves it into the search bounds.
+ *
+ * @return |false| to stop the search, |true| to continue.
+ */
+typedef bool (*GQTPointQuadTreeWrappedVisitor)(void *context, const void *item, GQTPoint point,
+                                               double offsetX);
+
+/**
+ * Called for every group of items found by an aggregate search.
+ *
+ * @return |false| to stop the search, |true| to continue.
+ */
+typedef bool (*GQTPointQuadTreeAggregateVisitor)(void *context, GQTAggregate aggregate);
+
+/**
+ * Called to find the item to remove.
+ *
+ * @return |true| if |item| is the item being looked for.
+ */
+typedef bool (*GQTItemMatcher)(void *context, const void *item);
+
+/**
+ * Creates an empty storage accepting points within the inclusive |bounds|, with a reference count
+ * of one.
+ *
+ * @param callBacks The item callbacks, may be NULL if items need no memory management.
+ * @param options   The options, may be NULL for the defaults.
+ */
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageCreate(
+    GQTBounds bounds, const GQTItemCallBacks *callBacks,
+    const GQTPointQuadTreeStorageOptions *options);
+
+/**
+ * Creates a storage with a reference count of one from a file written by
+ * GQTPointQuadTreeStorageWriteToFile. The file is mapped into memory and searched in place, so
+ * nothing is done per item; the file must not be modified while the storage exists.
+ *
+ * The storage is read-only: GQTPointQuadTreeStorageIsShared always returns |true| for it, and it
+ * is mutated through a copy instead. The copy keeps this storage alive and resolves its items
+ * through |resolver| until a slot is changed, at which point the items sharing a page with that
+ * slot are resolved and retained through |callBacks|. It reuses the handles of the storage which
+ * was written.
+ *
+ * Every index stored in the file is checked against its pool, and the nodes, point blocks and
+ * item slots against each other, so truncated or corrupted files are rejected with EINVAL. The
+ * coordinates, weights and identifiers are used as they are. The file must be written with the
+ * same byte order, and be loaded by a 64 bit process.
+ *
+ * @param callBacks The callbacks for the resolved items, used by copies. May be NULL.
+ * @param resolver  Turns item identifiers into items. May be NULL.
+ * @return The storage, or NULL with errno set if the file cannot be mapped or is not valid.
+ */
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageCreateWithFile(const char *path,
+                                                               const GQTItemCallBacks *callBacks,
+                                                               const GQTItemResolver *resolver);
+
+/**
+ * Writes |storage| to the file at |path| in a flat, versioned binary format: a header, followed
+ * by the node pool, the packed point arrays and the item identifiers, exactly as they are laid out
+ * in memory.
+ *
+ * @param identifier Returns the identifier to store for each item. May be NULL if the items of
+ *                   |storage| are identifiers cast to pointers.
+ * @return |false| with errno set if the file cannot be written, in which case it is removed.
+ */
+bool GQTPointQuadTreeStorageWriteToFile(const GQTPointQuadTreeStorage *storage, const char *path,
+                                        GQTItemIdentifierCallBack identifier, void *context);
+
+/**
+ * Creates a storage with a reference count of one holding the same items at the same points as
+ * |storage|. Searches of the copy return items in the same order.
+ *
+ * The node and point pools are duplicated with a few memcpy calls, taking time linear in their
+ * size but calling no callbacks. The item slots are shared with |storage| in pages of 256, and a
+ * page is only duplicated, retaining its items, when either storage changes one of its slots.
+ */
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageCopy(const GQTPointQuadTreeStorage *storage);
+
+/** Increments the reference count of |storage| and returns it. */
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageRetain(GQTPointQuadTreeStorage *storage);
+
+/**
+ * Decrements the reference count of |storage|. When it reaches zero all items are released and
+ * |storage| is freed. May be called from any thread.
+ */
+void GQTPointQuadTreeStorageRelease(GQTPointQuadTreeStorage *storage);
+
+/**
+ * Returns |true| if the reference count of |storage| is greater than one, or if it was created from
+ * a file, in which case it must be copied rather than mutated.
+ */
+bool GQTPointQuadTreeStorageIsShared(const GQTPointQuadTreeStorage *storage);
+
+/** Returns the bounds of |storage|. */
+GQTBounds GQTPointQuadTreeStorageGetBounds(const GQTPointQuadTreeStorage *storage);
+
+/**
+ * Returns the options |storage| was created with, with leafCapacity and maxDepth resolved to the
+ * values in use.
+ */
+GQTPointQuadTreeStorageOptions GQTPointQuadTreeStorageGetOptions(
+    const GQTPointQuadTreeStorage *storage);
+
+/** Returns the number of items in |storage|. */
+size_t GQTPointQuadTreeStorageGetCount(const GQTPointQuadTreeStorage *storage);
+
+/**
+ * Inserts |item| at |point|.
+ *
+ * @param handle Receives the handle of the item, or kGQTInvalidItemHandle if it was not inserted.
+ *               May be NULL.
+ * @return |false| if |point| is outside the bounds of |storage|, |true| otherwise.
+ */
+bool GQTPointQuadTreeStorageAdd(GQTPointQuadTreeStorage *storage, GQTPoint point,
+                                const void *item, GQTItemHandle *handle);
+
+/**
+ * Inserts |count| items at once, skipping those whose point is outside the bounds of |storage|.
+ *
+ * When the batch is at least as large as the tree, the whole tree is laid out again: the points
+ * are sorted by their Z-order key while the nodes are built top-down, so no leaf is ever split and
+ * leaves are stored in Z-order. Otherwise the items are inserted one at a time.
+ *
+ * @param handles Receives the handle of each item, or kGQTInvalidItemHandle for items which were
+ *                not inserted. May be NULL.
+ * @return The number of items inserted.
+ */
+size_t GQTPointQuadTreeStorageAddBatch(GQTPointQuadTreeStorage *storage, const GQTPoint *points,
+                                       const void *const *items, size_t count,
+                                       GQTItemHandle *handles);
+
+/**
+ * Removes the first item in the leaf containing |point| for which |matcher| returns |true|.
+ *
+ * @return |true| if an item was removed.
+ */
+bool GQTPointQuadTreeStorageRemove(GQTPointQuadTreeStorage *storage, GQTPoint point,
+                                   GQTItemMatcher matcher, void *context);
+
+/**
+ * Removes the item identified by |handle| in constant time: the item's entry is overwritten by the
+ * last entry of its leaf, and only the ancestors of the leaf are visited to update their counts.
+ * An ancestor left with few items is merged back into a leaf.
+ *
+ * @return |false| if |handle| does not match an item of |storage|.
+ */
+bool GQTPointQuadTreeStorageRemoveHandle(GQTPointQuadTreeStorage *storage, GQTItemHandle handle);
+
+/** Releases all items, keeping the allocated pools for reuse. */
+void GQTPointQuadTreeStorageClear(GQTPointQuadTreeStorage *storage);
+
+/**
+ * Calls |visitor| for every item within the inclusive |searchBounds|.
+ *
+ * @return |false| if |visitor| stopped the search, |true| otherwise.
+ */
+bool GQTPointQuadTreeStorageSearch(const GQTPointQuadTreeStorage *storage, GQTBounds searchBounds,
+                                   GQTPointQuadTreeVisitor visitor, void *context);
+
+/**
+ * Searches each of the |count| inclusive |searchBounds|, calling |visitor| with the index of the
+ * search for every item found, and returns once all searches are done.
+ *
+ * Large batches are spread across all cores, with neighbouring searches grouped together so they
+ * share the nodes they descend through. |visitor| may therefore be called concurrently from
+ * several threads, but never concurrently for the same search, and sees the items of each search
+ * in the order GQTPointQuadTreeStorageSearch would. |storage| must not be mutated meanwhile.
+ */
+void GQTPointQuadTreeStorageSearchBatch(const GQTPointQuadTreeStorage *storage,
+                                        const GQTBounds *searchBounds, size_t count,
+                                        GQTPointQuadTreeBatchVisitor visitor, void *context);
+
+/**
+ * Stores the number of items within each of the |count| inclusive |searchBounds| in |counts|,
+ * running the searches like GQTPointQuadTreeStorageSearchBatch.
+ */
+void GQTPointQuadTreeStorageCountInBoundsBatch(const GQTPointQuadTreeStorage *storage,
+                                               const GQTBounds *searchBounds, size_t count,
+                                               size_t *counts);
+
+/**
+ * Calls |visitor| for every item within the inclusive |searchBounds| of the plane tiled in x by
+ * copies of |storage|, as on a map which wraps around at the antimeridian. |searchBounds| may
+ * extend past the x bounds of |storage| on either side; the copies it intersects, at most 32, are
+ * searched together in a single traversal. An item is visited once per copy it is found in, with
+ * the x offset of that copy.
+ *
+ * @return |false| if |visitor| stopped the search, |true| otherwise.
+ */
+bool GQTPointQuadTreeStorageSearchWrapped(const GQTPointQuadTreeStorage *storage,
+                                          GQTBounds searchBounds,
+                                          GQTPointQuadTreeWrappedVisitor visitor, void *context);
+
+/**
+ * Returns the number of items GQTPointQuadTreeStorageSearchWrapped would visit for
+ * |searchBounds|, without visiting them.
+ */
+size_t GQTPointQuadTreeStorageCountInWrappedBounds(const GQTPointQuadTreeStorage *storage,
+                                                   GQTBounds searchBounds);
+
+/**
+ * Calls |visitor| for every item within |radius| of |center|, inclusive. Nodes entirely outside
+ * the circle are skipped, and the items of nodes entirely inside it are visited without testing
+ * their points.
+ *
+ * @return |false| if |visitor| stopped the search, |true| otherwise.
+ */
+bool GQTPointQuadTreeStorageSearchCircle(const GQTPointQuadTreeStorage *storage, GQTPoint center,
+                                         double radius, GQTPointQuadTreeVisitor visitor,
+                                         void *context);
+
+/**
+ * Calls |visitor| for every item inside the polygon with the given |vertices|, following the
+ * even-odd rule; items exactly on an edge may or may not be visited. The polygon is implicitly
+ * closed and its edges are straight lines in the coordinate space of |storage|. Nodes entirely
+ * outside the polygon are skipped, and the items of nodes entirely inside it are visited without
+ * testing their points.
+ *
+ * @return |false| if |visitor| stopped the search, |true| otherwise.
+ */
+bool GQTPointQuadTreeStorageSearchPolygon(const GQTPointQuadTreeStorage *storage,
+                                          const GQTPoint *vertices, size_t vertexCount,
+                                          GQTPointQuadTreeVisitor visitor, void *context);
+
+/**
+ * Returns the number of items within the inclusive |searchBounds|. Nodes entirely inside
+ * |searchBounds| contribute their item count without being visited.
+ */
+size_t GQTPointQuadTreeStorageCountInBounds(const GQTPointQuadTreeStorage *storage,
+                                            GQTBounds searchBounds);
+
+/**
+ * Divides the bounds of |storage| into a grid of 2^|depth| by 2^|depth| quads, the nodes at
+ * |depth|, and calls |visitor| with the aggregate of every non-empty quad intersecting
+ * |searchBounds|. Aggregates cover all items of their quad, including those outside
+ * |searchBounds|.
+ *
+ * Quads which are nodes of the tree are reported from the aggregate kept by the node, so the only
+ * points visited are those of the few leaves above |depth|, which hold at most one block each.
+ * Leaves holding more than one block, whose points share one cell of the maximum depth, are
+ * reported whole. Does nothing unless |storage| keeps aggregates.
+ *
+ * @return |false| if |visitor| stopped the search, |true| otherwise.
+ */
+bool GQTPointQuadTreeStorageSearchAggregates(const GQTPointQuadTreeStorage *storage,
+                                             GQTBounds searchBounds, uint32_t depth,
+                                             GQTPointQuadTreeAggregateVisitor visitor,
+                                             void *context);
+
+/**
+ * Finds the |count| items closest to |point|, nearest first, using a best-first traversal which
+ * visits nodes in order of their distance to |point|.
+ *
+ * @param maximumDistance Items further away than this are ignored. Pass INFINITY for no limit.
+ * @param items Receives up to |count| items.
+ * @param distances Receives the distance of each returned item to |point|.
+ * @return The number of items found.
+ */
+size_t GQTPointQuadTreeStorageNearest(const GQTPointQuadTreeStorage *storage, GQTPoint point,
+                                      size_t count, double maximumDistance, const void **items,
+                                      double *distances);
@@ -0,0 +1,2414 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GQTPointQuadTreeStorage.h"
+
+#include <dispatch/dispatch.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A node of the tree. The four children of a node are stored next to each other in the node pool,
+// in the order bottom left, bottom right, top left, top right, so that the child containing a
+// point is found by GQTQuadrant.
+typedef struct {
+  // Index of the first child, kGQTNullIndex if this node is a leaf. For the first node of a free
+  // group of four, the index of the next free group.
+  GQTIndex children;
+
+  // Index of the parent, kGQTNullIndex for the root.
+  GQTIndex parent;
+
+  // First point block of a leaf, kGQTNullIndex if the leaf is empty or this node is not a leaf.
+  GQTIndex block;
+
+  // Number of items in the subtree rooted at this node.
+  uint32_t count;
+} GQTNode;
+
+// Aggregate statistics of the points of a node, kept when the storage keeps aggregates.
+typedef struct {
+  // Sum of the weights.
+  double weight;
+
+  // Sums of the coordinates multiplied by their weight.
+  double weightedX;
+  double weightedY;
+
+  // Bounds of the points, with minimums greater than maximums if there are none.
+  GQTBounds bounds;
+} GQTNodeAggregate;
+
+static const GQTNodeAggregate kGQTEmptyNodeAggregate = {
+    0, 0, 0, {INFINITY, INFINITY, -INFINITY, -INFINITY}};
+
+// A point with its item, as stored in a leaf. Used to move points between leaves.
+typedef struct {
+  GQTPoint point;
+  GQTIndex itemIndex;
+
+  // The weight of the item, only used when the storage keeps aggregates.
+  double weight;
+} GQTEntry;
+
+// Number of item slots in a GQTItemPage, as a power of two.
+#define kGQTItemPageShift 8
+#define kGQTItemPageSize ((GQTIndex)1 << kGQTItemPageShift)
+
+// A page of item slots. Copies of a storage share its pages, and a storage only gets a page of its
+// own when it changes a slot of a shared page, so that copying does not touch every item. A page
+// retains the items of its slots, except for a page holding the identifiers of the items of a
+// mapped storage, which are resolved through the resolver of that storage.
+typedef struct {
+  // Number of storages sharing this page.
+  atomic_size_t referenceCount;
+
+  // The mapped storage the identifiers in items are resolved through, retained by the page, or
+  // NULL if items holds retained items.
+  GQTPointQuadTreeStorage *mappedStorage;
+
+  // The slots which are released, only used when mappedStorage is set. Released slots of other
+  // pages are NULL.
+  uint64_t freeSlots[kGQTItemPageSize / 64];
+
+  const void *items[kGQTItemPageSize];
+} GQTItemPage;
+
+struct GQTPointQuadTreeStorage {
+  // Number of owners of this storage. Storages shared by several owners are never mutated.
+  atomic_size_t referenceCount;
+
+  GQTBounds bounds;
+  GQTItemCallBacks callBacks;
+  GQTPointQuadTreeStorageOptions options;
+
+  // Node pool. The root is always node 0. Groups of four children released by merging are reused
+  // through the freeChildren list.
+  GQTNode *nodes;
+  GQTIndex nodeCount;
+  GQTIndex nodeCapacity;
+  GQTIndex freeChildren;
+  // Aggregates of each node, NULL unless options.keepsAggregates is set.
+  GQTNodeAggregate *aggregates;
+
+  // Number of points a leaf holds before it is split. This is also the size of a point block.
+  uint32_t leafCapacity;
+  // An internal node left with this many items or fewer after a removal is merged back into a
+  // leaf. This is a quarter of leafCapacity, so that a leaf which has just been split is not
+  // merged again by the next removal.
+  uint32_t mergeCapacity;
+  // Leaves at this depth are never split, they chain additional point blocks instead.
+  uint32_t maxDepth;
+
+  // Point block pool. Block b owns the entries [b * leafCapacity, (b + 1) * leafCapacity) of xs,
+  // ys and itemIndices. Only the first block of a leaf may be partially filled; the rest of the
+  // chain is always full. Chains only exist at maxDepth, or in adaptive storages in leaves whose
+  // points all lie in one cell of maxDepth.
+  double *xs;
+  double *ys;
+  GQTIndex *itemIndices;
+  // Weight of each point, NULL unless options.keepsAggregates is set.
+  double *weights;
+  uint32_t *blockSizes;
+  GQTIndex *blockNext;
+  // The leaf owning each block.
+  GQTIndex *blockLeaves;
+  GQTIndex blockCount;
+  GQTIndex blockCapacity;
+  GQTIndex freeBlock;
+
+  // Item slots referenced by itemIndices, kGQTItemPageSize slots per page. Released slots are
+  // reused through the freeItems stack. itemEntries holds the entry of each item in xs, ys and
+  // itemIndices, and itemGenerations is bumped whenever a slot is released so that stale handles
+  // are rejected. Mapped storages have no pages; their items are the identifiers in items.
+  GQTItemPage **itemPages;
+  GQTIndex itemPageCount;
+  const void **items;
+  size_t *itemEntries;
+  uint32_t *itemGenerations;
+  GQTIndex itemCount;
+  GQTIndex itemCapacity;
+  GQTIndex *freeItems;
+  GQTIndex freeItemCount;
+
+  // Number of items in the storage.
+  size_t count;
+
+  // The file mapping the pools of a storage created by GQTPointQuadTreeStorageCreateWithFile point
+  // into, NULL otherwise. Mapped storages are never mutated. Their items are identifiers, which are
+  // passed through the resolver, if any, before being handed out.
+  void *mapping;
+  size_t mappingLength;
+  GQTItemResolver resolver;
+};
+
+#pragma mark Utilities
+
+static void *GQTReallocArray(void *array, size_t count, size_t size) {
+  void *result = realloc(array, count * size);
+  if (result == NULL && count > 0) {
+    abort();
+  }
+  return result;
+}
+
+static GQTIndex GQTGrownCapacity(GQTIndex capacity, GQTIndex required) {
+  GQTIndex result = capacity > 0 ? capacity : 16;
+  while (result < required) {
+    result = result > UINT32_MAX / 2 ? kGQTNullIndex - 1 : result * 2;
+  }
+  return result;
+}
+
+static inline bool GQTBoundsContainsPoint(GQTBounds bounds, GQTPoint point) {
+  return point.x <= bounds.maxX && point.x >= bounds.minX && point.y <= bounds.maxY &&
+         point.y >= bounds.minY;
+}
+
+static inline bool GQTBoundsIntersectsBounds(GQTBounds bounds1, GQTBounds bounds2) {
+  return (!(bounds1.maxY < bounds2.minY || bounds2.maxY < bounds1.minY) &&
+          !(bounds1.maxX < bounds2.minX || bounds2.maxX < bounds1.minX));
+}
+
+static inline bool GQTBoundsContainsBounds(GQTBounds outer, GQTBounds inner) {
+  return inner.minX >= outer.minX && inner.maxX <= outer.maxX && inner.minY >= outer.minY &&
+         inner.maxY <= outer.maxY;
+}
+
+static inline GQTPoint GQTBoundsMidpoint(GQTBounds bounds) {
+  return (GQTPoint){(bounds.minX + bounds.maxX) / 2, (bounds.minY + bounds.maxY) / 2};
+}
+
+// Returns the offset of the child quad containing |point|. Points on the midlines belong to the
+// bottom and left quads.
+static inline uint32_t GQTQuadrant(GQTPoint point, GQTPoint midPoint) {
+  return (point.x > midPoint.x ? 1 : 0) | (point.y > midPoint.y ? 2 : 0);
+}
+
+static inline GQTBounds GQTChildBounds(GQTBounds bounds, GQTPoint midPoint, uint32_t quadrant) {
+  GQTBounds result = bounds;
+  if (quadrant & 1) {
+    result.minX = midPoint.x;
+  } else {
+    result.maxX = midPoint.x;
+  }
+  if (quadrant & 2) {
+    result.minY = midPoint.y;
+  } else {
+    result.maxY = midPoint.y;
+  }
+  return result;
+}
+
+// Returns the item in slot |itemIndex| as handed out by searches.
+static inline const void *GQTResolvedItem(const GQTPointQuadTreeStorage *storage,
+                                          GQTIndex itemIndex) {
+  const GQTItemResolver *resolver = &storage->resolver;
+  const void *item;
+  if (storage->mapping != NULL) {
+    item = storage->items[itemIndex];
+  } else {
+    const GQTItemPage *page = storage->itemPages[itemIndex >> kGQTItemPageShift];
+    item = page->items[itemIndex & (kGQTItemPageSize - 1)];
+    if (page->mappedStorage == NULL) return item;
+    resolver = &page->mappedStorage->resolver;
+  }
+  if (resolver->resolve == NULL) return item;
+  return resolver->resolve(resolver->context, (uint64_t)(uintptr_t)item);
+}
+
+// Returns the item of |entry| as handed out by searches.
+static inline const void *GQTVisibleItem(const GQTPointQuadTreeStorage *storage, size_t entry) {
+  return GQTResolvedItem(storage, storage->itemIndices[entry]);
+}
+
+// Returns an array marking the released item slots, to be freed by the caller.
+static bool *GQTCreateFreeItemMask(const GQTPointQuadTreeStorage *storage) {
+  bool *mask = calloc(storage->itemCount > 0 ? storage->itemCount : 1, sizeof(bool));
+  if (mask == NULL) {
+    abort();
+  }
+  for (GQTIndex i = 0; i < storage->freeItemCount; ++i) {
+    mask[storage->freeItems[i]] = true;
+  }
+  return mask;
+}
+
+#pragma mark Item pages
+
+static GQTItemPage *GQTCreateItemPage(void) {
+  GQTItemPage *page = calloc(1, sizeof(GQTItemPage));
+  if (page == NULL) {
+    abort();
+  }
+  atomic_init(&page->referenceCount, 1);
+  return page;
+}
+
+static inline bool GQTItemPageSlotIsFree(const GQTItemPage *page, GQTIndex slot) {
+  return (page->freeSlots[slot / 64] >> (slot % 64)) & 1;
+}
+
+// Drops a reference to |page|, releasing its items through |callBacks| with the last one.
+static void GQTReleaseItemPage(GQTItemPage *page, const GQTItemCallBacks *callBacks) {
+  if (atomic_fetch_sub_explicit(&page->referenceCount, 1, memory_order_acq_rel) != 1) return;
+  if (page->mappedStorage != NULL) {
+    GQTPointQuadTreeStorageRelease(page->mappedStorage);
+  } else if (callBacks->release != NULL) {
+    for (GQTIndex slot = 0; slot < kGQTItemPageSize; ++slot) {
+      if (page->items[slot] != NULL) {
+        callBacks->release(page->items[slot]);
+      }
+    }
+  }
+  free(page);
+}
+
+// Returns the page of slot |itemIndex| for writing. A page shared with another storage is first
+// replaced by a copy of its own, and the identifiers of a mapped page are resolved into retained
+// items, so that only the pages which change are ever duplicated.
+static GQTItemPage *GQTWritableItemPage(GQTPointQuadTreeStorage *storage, GQTIndex itemIndex) {
+  GQTItemPage **pageSlot = &storage->itemPages[itemIndex >> kGQTItemPageShift];
+  GQTItemPage *page = *pageSlot;
+  if (page->mappedStorage == NULL &&
+      atomic_load_explicit(&page->referenceCount, memory_order_acquire) == 1) {
+    return page;
+  }
+  GQTItemPage *copy = GQTCreateItemPage();
+  GQTItemRetainCallBack retain = storage->callBacks.retain;
+  for (GQTIndex slot = 0; slot < kGQTItemPageSize; ++slot) {
+    const void *item = page->items[slot];
+    if (page->mappedStorage != NULL) {
+      if (GQTItemPageSlotIsFree(page, slot)) continue;
+      const GQTItemResolver *resolver = &page->mappedStorage->resolver;
+      if (resolver->resolve != NULL) {
+        item = resolver->resolve(resolver->context, (uint64_t)(uintptr_t)item);
+      }
+    }
+    copy->items[slot] = item != NULL && retain != NULL ? retain(item) : item;
+  }
+  GQTReleaseItemPage(page, &storage->callBacks);
+  *pageSlot = copy;
+  return copy;
+}
+
+// Releases all item pages of |storage|.
+static void GQTReleaseItemPages(GQTPointQuadTreeStorage *storage) {
+  for (GQTIndex i = 0; i < storage->itemPageCount; ++i) {
+    GQTReleaseItemPage(storage->itemPages[i], &storage->callBacks);
+  }
+  storage->itemPageCount = 0;
+}
+
+static inline GQTBounds GQTBoundsUnion(GQTBounds bounds1, GQTBounds bounds2) {
+  return (GQTBounds){fmin(bounds1.minX, bounds2.minX), fmin(bounds1.minY, bounds2.minY),
+                     fmax(bounds1.maxX, bounds2.maxX), fmax(bounds1.maxY, bounds2.maxY)};
+}
+
+static inline void GQTAddToAggregate(GQTNodeAggregate *aggregate, GQTPoint point, double weight) {
+  aggregate->weight += weight;
+  aggregate->weightedX += weight * point.x;
+  aggregate->weightedY += weight * point.y;
+  aggregate->bounds =
+      GQTBoundsUnion(aggregate->bounds, (GQTBounds){point.x, point.y, point.x, point.y});
+}
+
+static inline void GQTAddAggregates(GQTNodeAggregate *aggregate, const GQTNodeAggregate *other) {
+  aggregate->weight += other->weight;
+  aggregate->weightedX += other->weightedX;
+  aggregate->weightedY += other->weightedY;
+  aggregate->bounds = GQTBoundsUnion(aggregate->bounds, other->bounds);
+}
+
+// Returns the public form of |aggregate|, which summarizes |count| points.
+static GQTAggregate GQTMakeAggregate(const GQTNodeAggregate *aggregate, size_t count) {
+  GQTAggregate result;
+  result.count = count;
+  result.weight = aggregate->weight;
+  result.bounds = aggregate->bounds;
+  if (aggregate->weight != 0) {
+    result.centroid =
+        (GQTPoint){aggregate->weightedX / aggregate->weight, aggregate->weightedY / aggregate->weight};
+  } else {
+    result.centroid = GQTBoundsMidpoint(aggregate->bounds);
+  }
+  return result;
+}
+
+#pragma mark Options
+
+static uint32_t GQTClamp(uint32_t value, uint32_t minimum, uint32_t maximum) {
+  return value < minimum ? minimum : value > maximum ? maximum : value;
+}
+
+// Stores |options| with the defaults and clamping applied, and derives the split policy from them.
+static void GQTSetOptions(GQTPointQuadTreeStorage *storage,
+                          GQTPointQuadTreeStorageOptions options) {
+  options.leafCapacity =
+      options.leafCapacity == 0
+          ? kGQTDefaultLeafCapacity
+          : GQTClamp(options.leafCapacity, kGQTMinLeafCapacity, kGQTMaxLeafCapacity);
+  options.maxDepth = options.maxDepth == 0 ? kGQTDefaultMaxDepth
+                                           : GQTClamp(options.maxDepth, 1, kGQTMaxMaxDepth);
+  storage->options = options;
+  storage->leafCapacity = options.leafCapacity;
+  storage->mergeCapacity = options.leafCapacity / 4;
+  storage->maxDepth = options.maxDepth;
+}
+
+#pragma mark Pools
+
+static void GQTResetRoot(GQTPointQuadTreeStorage *storage) {
+  storage->nodeCount = 1;
+  storage->freeChildren = kGQTNullIndex;
+  storage->nodes[0] = (GQTNode){kGQTNullIndex, kGQTNullIndex, kGQTNullIndex, 0};
+  if (storage->aggregates != NULL) {
+    storage->aggregates[0] = kGQTEmptyNodeAggregate;
+  }
+}
+
+// Allocates four empty leaves under |parent| and returns the index of the first one.
+static GQTIndex GQTAllocateChildren(GQTPointQuadTreeStorage *storage, GQTIndex parent) {
+  GQTIndex children = storage->freeChildren;
+  if (children != kGQTNullIndex) {
+    storage->freeChildren = storage->nodes[children].children;
+  } else {
+    if (storage->nodeCount + 4 > storage->nodeCapacity) {
+      storage->nodeCapacity = GQTGrownCapacity(storage->nodeCapacity, storage->nodeCount + 4);
+      storage->nodes = GQTReallocArray(storage->nodes, storage->nodeCapacity, sizeof(GQTNode));
+      if (storage->aggregates != NULL) {
+        storage->aggregates = GQTReallocArray(storage->aggregates, storage->nodeCapacity,
+                                              sizeof(GQTNodeAggregate));
+      }
+    }
+    children = storage->nodeCount;
+    storage->nodeCount += 4;
+  }
+  for (uint32_t i = 0; i < 4; ++i) {
+    storage->nodes[children + i] = (GQTNode){kGQTNullIndex, parent, kGQTNullIndex, 0};
+    if (storage->aggregates != NULL) {
+      storage->aggregates[children + i] = kGQTEmptyNodeAggregate;
+    }
+  }
+  return children;
+}
+
+static void GQTFreeChildren(GQTPointQuadTreeStorage *storage, GQTIndex children) {
+  storage->nodes[children].children = storage->freeChildren;
+  storage->freeChildren = children;
+}
+
+static GQTIndex GQTAllocateBlock(GQTPointQuadTreeStorage *storage) {
+  GQTIndex block = storage->freeBlock;
+  if (block != kGQTNullIndex) {
+    storage->freeBlock = storage->blockNext[block];
+  } else {
+    if (storage->blockCount == storage->blockCapacity) {
+      GQTIndex capacity = GQTGrownCapacity(storage->blockCapacity, storage->blockCount + 1);
+      size_t pointCapacity = (size_t)capacity * storage->leafCapacity;
+      storage->xs = GQTReallocArray(storage->xs, pointCapacity, sizeof(double));
+      storage->ys = GQTReallocArray(storage->ys, pointCapacity, sizeof(double));
+      storage->itemIndices =
+          GQTReallocArray(storage->itemIndices, pointCapacity, sizeof(GQTIndex));
+      if (storage->options.keepsAggregates) {
+        storage->weights = GQTReallocArray(storage->weights, pointCapacity, sizeof(double));
+      }
+      storage->blockSizes = GQTReallocArray(storage->blockSizes, capacity, sizeof(uint32_t));
+      storage->blockNext = GQTReallocArray(storage->blockNext, capacity, sizeof(GQTIndex));
+      storage->blockLeaves = GQTReallocArray(storage->blockLeaves, capacity, sizeof(GQTIndex));
+      storage->blockCapacity = capacity;
+    }
+    block = storage->blockCount++;
+  }
+  storage->blockSizes[block] = 0;
+  storage->blockNext[block] = kGQTNullIndex;
+  return block;
+}
+
+static void GQTFreeBlock(GQTPointQuadTreeStorage *storage, GQTIndex block) {
+  storage->blockNext[block] = storage->freeBlock;
+  storage->freeBlock = block;
+}
+
+static GQTIndex GQTAllocateItem(GQTPointQuadTreeStorage *storage, const void *item) {
+  GQTIndex index;
+  if (storage->freeItemCount > 0) {
+    index = storage->freeItems[--storage->freeItemCount];
+  } else {
+    if (storage->itemCount == storage->itemCapacity) {
+      GQTIndex capacity = GQTGrownCapacity(storage->itemCapacity, storage->itemCount + 1);
+      storage->itemPages =
+          GQTReallocArray(storage->itemPages, ((size_t)capacity >> kGQTItemPageShift) + 1,
+                          sizeof(GQTItemPage *));
+      storage->itemEntries = GQTReallocArray(storage->itemEntries, capacity, sizeof(size_t));
+      storage->itemGenerations =
+          GQTReallocArray(storage->itemGenerations, capacity, sizeof(uint32_t));
+      storage->freeItems = GQTReallocArray(storage->freeItems, capacity, sizeof(GQTIndex));
+      // Slots below the old capacity keep their generation even after a clear.
+      memset(storage->itemGenerations + storage->itemCapacity, 0,
+             (capacity - storage->itemCapacity) * sizeof(uint32_t));
+      storage->itemCapacity = capacity;
+    }
+    index = storage->itemCount++;
+    if ((index >> kGQTItemPageShift) == storage->itemPageCount) {
+      storage->itemPages[storage->itemPageCount++] = GQTCreateItemPage();
+    }
+  }
+  GQTItemPage *page = GQTWritableItemPage(storage, index);
+  page->items[index & (kGQTItemPageSize - 1)] =
+      storage->callBacks.retain != NULL ? storage->callBacks.retain(item) : item;
+  return index;
+}
+
+// Returns the entry of the newly allocated item slot |index| at |point|.
+static GQTEntry GQTMakeEntry(const GQTPointQuadTreeStorage *storage, GQTPoint point,
+                             GQTIndex index) {
+  double weight = 0;
+  if (storage->options.keepsAggregates) {
+    weight = storage->callBacks.weight != NULL
+                 ? storage->callBacks.weight(GQTResolvedItem(storage, index))
+                 : 1;
+  }
+  return (GQTEntry){point, index, weight};
+}
+
+static inline GQTItemHandle GQTMakeHandle(const GQTPointQuadTreeStorage *storage,
+                                          GQTIndex index) {
+  return (GQTItemHandle)storage->itemGenerations[index] << 32 | index;
+}
+
+static void GQTFreeItem(GQTPointQuadTreeStorage *storage, GQTIndex index) {
+  GQTItemPage *page = GQTWritableItemPage(storage, index);
+  const void *item = page->items[index & (kGQTItemPageSize - 1)];
+  page->items[index & (kGQTItemPageSize - 1)] = NULL;
+  ++storage->itemGenerations[index];
+  storage->freeItems[storage->freeItemCount++] = index;
+  if (storage->callBacks.release != NULL) {
+    storage->callBacks.release(item);
+  }
+}
+
+#pragma mark Leaves
+
+static void GQTAppendToLeaf(GQTPointQuadTreeStorage *storage, GQTIndex leaf, GQTEntry newEntry) {
+  GQTIndex block = storage->nodes[leaf].block;
+  if (block == kGQTNullIndex || storage->blockSizes[block] == storage->leafCapacity) {
+    GQTIndex newBlock = GQTAllocateBlock(storage);
+    storage->blockNext[newBlock] = block;
+    storage->blockLeaves[newBlock] = leaf;
+    storage->nodes[leaf].block = newBlock;
+    block = newBlock;
+  }
+  size_t entry = (size_t)block * storage->leafCapacity + storage->blockSizes[block]++;
+  storage->xs[entry] = newEntry.point.x;
+  storage->ys[entry] = newEntry.point.y;
+  storage->itemIndices[entry] = newEntry.itemIndex;
+  storage->itemEntries[newEntry.itemIndex] = entry;
+  if (storage->aggregates != NULL) {
+    storage->weights[entry] = newEntry.weight;
+    GQTAddToAggregate(&storage->aggregates[leaf], newEntry.point, newEntry.weight);
+  }
+  ++storage->nodes[leaf].count;
+}
+
+// Removes the given entry of |leaf| by moving the last entry of the leaf's first block into it.
+static void GQTRemoveFromLeaf(GQTPointQuadTreeStorage *storage, GQTIndex leaf, size_t entry) {
+  GQTIndex head = storage->nodes[leaf].block;
+  size_t last = (size_t)head * storage->leafCapacity + --storage->blockSizes[head];
+  storage->xs[entry] = storage->xs[last];
+  storage->ys[entry] = storage->ys[last];
+  storage->itemIndices[entry] = storage->itemIndices[last];
+  storage->itemEntries[storage->itemIndices[entry]] = entry;
+  if (storage->aggregates != NULL) {
+    storage->weights[entry] = storage->weights[last];
+  }
+  if (storage->blockSizes[head] == 0) {
+    storage->nodes[leaf].block = storage->blockNext[head];
+    GQTFreeBlock(storage, head);
+  }
+  --storage->nodes[leaf].count;
+}
+
+// Recomputes the aggregate of |leaf| from its points.
+static void GQTUpdateLeafAggregate(GQTPointQuadTreeStorage *storage, GQTIndex leaf) {
+  GQTNodeAggregate aggregate = kGQTEmptyNodeAggregate;
+  for (GQTIndex block = storage->nodes[leaf].block; block != kGQTNullIndex;
+       block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      GQTPoint point = {storage->xs[entry], storage->ys[entry]};
+      GQTAddToAggregate(&aggregate, point, storage->weights[entry]);
+    }
+  }
+  storage->aggregates[leaf] = aggregate;
+}
+
+// Recomputes the aggregate of the internal node |nodeIndex| from those of its children.
+static void GQTUpdateInternalAggregate(GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex) {
+  GQTNodeAggregate aggregate = kGQTEmptyNodeAggregate;
+  GQTIndex children = storage->nodes[nodeIndex].children;
+  for (uint32_t i = 0; i < 4; ++i) {
+    GQTAddAggregates(&aggregate, &storage->aggregates[children + i]);
+  }
+  storage->aggregates[nodeIndex] = aggregate;
+}
+
+// Turns |leaf| into an internal node and distributes its points over four new leaves.
+static void GQTSplitLeaf(GQTPointQuadTreeStorage *storage, GQTIndex leaf, GQTBounds bounds) {
+  GQTIndex children = GQTAllocateChildren(storage, leaf);
+  GQTIndex block = storage->nodes[leaf].block;
+  storage->nodes[leaf].children = children;
+  storage->nodes[leaf].block = kGQTNullIndex;
+
+  GQTPoint midPoint = GQTBoundsMidpoint(bounds);
+  while (block != kGQTNullIndex) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      GQTEntry movedEntry = {{storage->xs[entry], storage->ys[entry]},
+                             storage->itemIndices[entry],
+                             storage->aggregates != NULL ? storage->weights[entry] : 0};
+      GQTAppendToLeaf(storage, children + GQTQuadrant(movedEntry.point, midPoint), movedEntry);
+    }
+    GQTIndex next = storage->blockNext[block];
+    GQTFreeBlock(storage, block);
+    block = next;
+  }
+}
+
+#pragma mark Adaptive splitting
+
+// Returns whether all points within |pointBounds| fall into the same leaf however often the node
+// with |bounds| at |depth| is split, that is whether they share one cell of maxDepth.
+static bool GQTPointsAreInseparable(const GQTPointQuadTreeStorage *storage, GQTBounds bounds,
+                                    uint32_t depth, GQTBounds pointBounds) {
+  GQTPoint minPoint = {pointBounds.minX, pointBounds.minY};
+  GQTPoint maxPoint = {pointBounds.maxX, pointBounds.maxY};
+  for (; depth < storage->maxDepth; ++depth) {
+    GQTPoint midPoint = GQTBoundsMidpoint(bounds);
+    uint32_t quadrant = GQTQuadrant(minPoint, midPoint);
+    if (quadrant != GQTQuadrant(maxPoint, midPoint)) return false;
+    bounds = GQTChildBounds(bounds, midPoint, quadrant);
+  }
+  return true;
+}
+
+// Returns whether |point| and the points of the full |leaf| share one cell of maxDepth, in which
+// case splitting the leaf would only add empty nodes.
+static bool GQTLeafIsInseparableFrom(const GQTPointQuadTreeStorage *storage, GQTIndex leaf,
+                                     GQTBounds bounds, uint32_t depth, GQTPoint point) {
+  GQTBounds pointBounds = {point.x, point.y, point.x, point.y};
+  GQTIndex block = storage->nodes[leaf].block;
+  if (storage->nodes[leaf].count > storage->leafCapacity) {
+    // The leaf has grown past one block, so its points already share a cell and any one of them
+    // stands for all.
+    size_t entry = (size_t)block * storage->leafCapacity;
+    GQTPoint other = {storage->xs[entry], storage->ys[entry]};
+    pointBounds = GQTBoundsUnion(pointBounds, (GQTBounds){other.x, other.y, other.x, other.y});
+    return GQTPointsAreInseparable(storage, bounds, depth, pointBounds);
+  }
+  for (; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      pointBounds.minX = fmin(pointBounds.minX, storage->xs[entry]);
+      pointBounds.maxX = fmax(pointBounds.maxX, storage->xs[entry]);
+      pointBounds.minY = fmin(pointBounds.minY, storage->ys[entry]);
+      pointBounds.maxY = fmax(pointBounds.maxY, storage->ys[entry]);
+    }
+  }
+  return GQTPointsAreInseparable(storage, bounds, depth, pointBounds);
+}
+
+// Returns whether |entries| share one cell of maxDepth below the node with |bounds| at |depth|.
+static bool GQTEntriesAreInseparable(const GQTPointQuadTreeStorage *storage,
+                                     const GQTEntry *entries, size_t count, GQTBounds bounds,
+                                     uint32_t depth) {
+  GQTBounds pointBounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+  for (size_t i = 0; i < count; ++i) {
+    pointBounds.minX = fmin(pointBounds.minX, entries[i].point.x);
+    pointBounds.maxX = fmax(pointBounds.maxX, entries[i].point.x);
+    pointBounds.minY = fmin(pointBounds.minY, entries[i].point.y);
+    pointBounds.maxY = fmax(pointBounds.maxY, entries[i].point.y);
+  }
+  return GQTPointsAreInseparable(storage, bounds, depth, pointBounds);
+}
+
+#pragma mark Insertion
+
+static void GQTInsert(GQTPointQuadTreeStorage *storage, GQTEntry entry) {
+  GQTIndex nodeIndex = 0;
+  GQTBounds bounds = storage->bounds;
+  uint32_t depth = 0;
+  for (;;) {
+    GQTNode *node = &storage->nodes[nodeIndex];
+    if (node->children == kGQTNullIndex) {
+      if (node->count >= storage->leafCapacity && depth < storage->maxDepth &&
+          !(storage->options.adaptive &&
+            GQTLeafIsInseparableFrom(storage, nodeIndex, bounds, depth, entry.point))) {
+        GQTSplitLeaf(storage, nodeIndex, bounds);
+        continue;
+      }
+      GQTAppendToLeaf(storage, nodeIndex, entry);
+      return;
+    }
+    ++node->count;
+    if (storage->aggregates != NULL) {
+      GQTAddToAggregate(&storage->aggregates[nodeIndex], entry.point, entry.weight);
+    }
+    GQTPoint midPoint = GQTBoundsMidpoint(bounds);
+    uint32_t quadrant = GQTQuadrant(entry.point, midPoint);
+    bounds = GQTChildBounds(bounds, midPoint, quadrant);
+    nodeIndex = node->children + quadrant;
+    ++depth;
+  }
+}
+
+#pragma mark Bulk loading
+
+// Copies the entries of the subtree rooted at |nodeIndex| to |entries|. Returns the number copied.
+static size_t GQTCollectEntries(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                                GQTEntry *entries) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->children != kGQTNullIndex) {
+    size_t collected = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+      collected += GQTCollectEntries(storage, node->children + i, entries + collected);
+    }
+    return collected;
+  }
+  size_t collected = 0;
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      entries[collected++] =
+          (GQTEntry){{storage->xs[entry], storage->ys[entry]}, storage->itemIndices[entry],
+                     storage->aggregates != NULL ? storage->weights[entry] : 0};
+    }
+  }
+  return collected;
+}
+
+// Drops all nodes and point blocks, keeping the items.
+static void GQTResetNodes(GQTPointQuadTreeStorage *storage) {
+  storage->blockCount = 0;
+  storage->freeBlock = kGQTNullIndex;
+  GQTResetRoot(storage);
+}
+
+// Builds the subtree rooted at the empty leaf |nodeIndex| out of |entries|.
+//
+// Every level partitions its entries by quadrant with a stable counting sort before recursing,
+// which is an MSD radix sort of the entries by their Z-order (Morton) key whose digits are the
+// quadrants GQTInsert would choose. Nodes are therefore created top-down and exactly once, leaves
+// are filled in Z-order, and the result matches inserting the entries one at a time.
+static void GQTBuildNode(GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex, GQTBounds bounds,
+                         GQTEntry *entries, size_t count, uint32_t depth, GQTEntry *scratch) {
+  if (count <= storage->leafCapacity || depth >= storage->maxDepth ||
+      (storage->options.adaptive && GQTEntriesAreInseparable(storage, entries, count, bounds,
+                                                             depth))) {
+    for (size_t i = 0; i < count; ++i) {
+      GQTAppendToLeaf(storage, nodeIndex, entries[i]);
+    }
+    return;
+  }
+  GQTIndex children = GQTAllocateChildren(storage, nodeIndex);
+  storage->nodes[nodeIndex].children = children;
+  storage->nodes[nodeIndex].count = (uint32_t)count;
+
+  GQTPoint midPoint = GQTBoundsMidpoint(bounds);
+  size_t ends[4] = {0, 0, 0, 0};
+  uint32_t previous = 0;
+  bool sorted = true;
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t quadrant = GQTQuadrant(entries[i].point, midPoint);
+    sorted = sorted && quadrant >= previous;
+    previous = quadrant;
+    ++ends[quadrant];
+  }
+  for (uint32_t quadrant = 1; quadrant < 4; ++quadrant) {
+    ends[quadrant] += ends[quadrant - 1];
+  }
+  if (!sorted) {
+    size_t positions[4] = {0, ends[0], ends[1], ends[2]};
+    for (size_t i = 0; i < count; ++i) {
+      scratch[positions[GQTQuadrant(entries[i].point, midPoint)]++] = entries[i];
+    }
+    memcpy(entries, scratch, count * sizeof(GQTEntry));
+  }
+
+  size_t start = 0;
+  for (uint32_t quadrant = 0; quadrant < 4; ++quadrant) {
+    GQTBuildNode(storage, children + quadrant, GQTChildBounds(bounds, midPoint, quadrant),
+                 entries + start, ends[quadrant] - start, depth + 1, scratch);
+    start = ends[quadrant];
+  }
+  if (storage->aggregates != NULL) {
+    GQTUpdateInternalAggregate(storage, nodeIndex);
+  }
+}
+
+// Builds the tree from scratch out of |entries|, which it reorders. The tree must be empty.
+static void GQTBuild(GQTPointQuadTreeStorage *storage, GQTEntry *entries, size_t count) {
+  GQTEntry *scratch = GQTReallocArray(NULL, count, sizeof(GQTEntry));
+  GQTBuildNode(storage, 0, storage->bounds, entries, count, 0, scratch);
+  free(scratch);
+}
+
+#pragma mark Removal
+
+// Returns the nodes and point blocks below |nodeIndex| to their pools and makes it an empty leaf.
+static void GQTFreeDescendants(GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex) {
+  GQTNode *node = &storage->nodes[nodeIndex];
+  GQTIndex block = node->block;
+  while (block != kGQTNullIndex) {
+    GQTIndex next = storage->blockNext[block];
+    GQTFreeBlock(storage, block);
+    block = next;
+  }
+  GQTIndex children = node->children;
+  if (children != kGQTNullIndex) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      GQTFreeDescendants(storage, children + i);
+    }
+    GQTFreeChildren(storage, children);
+  }
+  *node = (GQTNode){kGQTNullIndex, node->parent, kGQTNullIndex, 0};
+  if (storage->aggregates != NULL) {
+    storage->aggregates[nodeIndex] = kGQTEmptyNodeAggregate;
+  }
+}
+
+// Turns the internal node |nodeIndex|, which holds at most mergeCapacity items, back into a leaf.
+static void GQTMergeNode(GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex) {
+  GQTEntry *entries = GQTReallocArray(NULL, storage->mergeCapacity, sizeof(GQTEntry));
+  size_t count = GQTCollectEntries(storage, nodeIndex, entries);
+  GQTFreeDescendants(storage, nodeIndex);
+  for (size_t i = 0; i < count; ++i) {
+    GQTAppendToLeaf(storage, nodeIndex, entries[i]);
+  }
+  free(entries);
+}
+
+// Removes and releases the item stored at |entry|. Walks up from its leaf to update the counts
+// and aggregates, and merges the highest ancestor left with few enough items back into a leaf.
+static void GQTRemoveEntry(GQTPointQuadTreeStorage *storage, size_t entry) {
+  GQTIndex itemIndex = storage->itemIndices[entry];
+  GQTIndex leaf = storage->blockLeaves[entry / storage->leafCapacity];
+  GQTRemoveFromLeaf(storage, leaf, entry);
+  if (storage->aggregates != NULL) {
+    GQTUpdateLeafAggregate(storage, leaf);
+  }
+
+  GQTIndex mergeNode = kGQTNullIndex;
+  for (GQTIndex nodeIndex = storage->nodes[leaf].parent; nodeIndex != kGQTNullIndex;
+       nodeIndex = storage->nodes[nodeIndex].parent) {
+    if (--storage->nodes[nodeIndex].count <= storage->mergeCapacity) {
+      mergeNode = nodeIndex;
+    }
+    if (storage->aggregates != NULL) {
+      GQTUpdateInternalAggregate(storage, nodeIndex);
+    }
+  }
+  if (mergeNode != kGQTNullIndex) {
+    GQTMergeNode(storage, mergeNode);
+  }
+  GQTFreeItem(storage, itemIndex);
+  --storage->count;
+}
+
+#pragma mark Search
+
+static bool GQTVisitSubtree(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                            GQTPointQuadTreeVisitor visitor, void *context) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return true;
+  if (node->children != kGQTNullIndex) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (!GQTVisitSubtree(storage, node->children + i, visitor, context)) return false;
+    }
+    return true;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      GQTPoint point = {storage->xs[entry], storage->ys[entry]};
+      if (!visitor(context, GQTVisibleItem(storage, entry), point)) return false;
+    }
+  }
+  return true;
+}
+
+static bool GQTSearchNode(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                          GQTBounds ownBounds, GQTBounds searchBounds,
+                          GQTPointQuadTreeVisitor visitor, void *context) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return true;
+  if (GQTBoundsContainsBounds(searchBounds, ownBounds)) {
+    return GQTVisitSubtree(storage, nodeIndex, visitor, context);
+  }
+  if (node->children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(ownBounds);
+    for (uint32_t i = 0; i < 4; ++i) {
+      GQTBounds childBounds = GQTChildBounds(ownBounds, midPoint, i);
+      if (GQTBoundsIntersectsBounds(childBounds, searchBounds) &&
+          !GQTSearchNode(storage, node->children + i, childBounds, searchBounds, visitor,
+                         context)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      double x = storage->xs[entry];
+      double y = storage->ys[entry];
+      if (x <= searchBounds.maxX && x >= searchBounds.minX && y <= searchBounds.maxY &&
+          y >= searchBounds.minY) {
+        GQTPoint point = {x, y};
+        if (!visitor(context, GQTVisibleItem(storage, entry), point)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+static size_t GQTCountNode(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                           GQTBounds ownBounds, GQTBounds searchBounds) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return 0;
+  if (GQTBoundsContainsBounds(searchBounds, ownBounds)) return node->count;
+  size_t count = 0;
+  if (node->children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(ownBounds);
+    for (uint32_t i = 0; i < 4; ++i) {
+      GQTBounds childBounds = GQTChildBounds(ownBounds, midPoint, i);
+      if (GQTBoundsIntersectsBounds(childBounds, searchBounds)) {
+        count += GQTCountNode(storage, node->children + i, childBounds, searchBounds);
+      }
+    }
+    return count;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      double x = storage->xs[entry];
+      double y = storage->ys[entry];
+      count += x <= searchBounds.maxX && x >= searchBounds.minX && y <= searchBounds.maxY &&
+               y >= searchBounds.minY;
+    }
+  }
+  return count;
+}
+
+#pragma mark Batch search
+
+// Batches smaller than this are searched on the calling thread.
+static const size_t kGQTMinConcurrentBatch = 64;
+
+// Number of queries of a batch searched by one work item.
+static const size_t kGQTBatchChunkSize = 16;
+
+typedef struct {
+  uint32_t key;
+  uint32_t query;
+} GQTBatchQuery;
+
+typedef struct {
+  const GQTPointQuadTreeStorage *storage;
+  const GQTBounds *searchBounds;
+  const GQTBatchQuery *queries;
+  size_t count;
+  GQTPointQuadTreeBatchVisitor visitor;
+  void *context;
+  size_t *counts;
+} GQTBatch;
+
+typedef struct {
+  GQTPointQuadTreeBatchVisitor visitor;
+  void *context;
+  size_t query;
+} GQTBatchVisitorContext;
+
+static bool GQTCallBatchVisitor(void *context, const void *item, GQTPoint point) {
+  GQTBatchVisitorContext *batchContext = context;
+  return batchContext->visitor(batchContext->context, batchContext->query, item, point);
+}
+
+// Spreads the low 16 bits of |value| to the even bits of the result.
+static inline uint32_t GQTSpreadBits(uint32_t value) {
+  value &= 0xFFFF;
+  value = (value | (value << 8)) & 0x00FF00FF;
+  value = (value | (value << 4)) & 0x0F0F0F0F;
+  value = (value | (value << 2)) & 0x33333333;
+  return (value | (value << 1)) & 0x55555555;
+}
+
+// Returns the Z-order key of the center of |searchBounds| on a 2^16 by 2^16 grid over |bounds|.
+static uint32_t GQTZOrderKey(GQTBounds bounds, GQTBounds searchBounds) {
+  double x = ((searchBounds.minX + searchBounds.maxX) / 2 - bounds.minX) /
+             (bounds.maxX - bounds.minX);
+  double y = ((searchBounds.minY + searchBounds.maxY) / 2 - bounds.minY) /
+             (bounds.maxY - bounds.minY);
+  // Also maps NaN to 0.
+  x = x > 0 ? fmin(x, 1) : 0;
+  y = y > 0 ? fmin(y, 1) : 0;
+  return GQTSpreadBits((uint32_t)(x * 0xFFFF)) | (GQTSpreadBits((uint32_t)(y * 0xFFFF)) << 1);
+}
+
+static int GQTCompareBatchQueries(const void *query1, const void *query2) {
+  uint32_t key1 = ((const GQTBatchQuery *)query1)->key;
+  uint32_t key2 = ((const GQTBatchQuery *)query2)->key;
+  return key1 < key2 ? -1 : key1 > key2;
+}
+
+static void GQTSearchBatchChunk(void *context, size_t chunk) {
+  const GQTBatch *batch = context;
+  const GQTPointQuadTreeStorage *storage = batch->storage;
+  size_t start = chunk * kGQTBatchChunkSize;
+  size_t end = start + kGQTBatchChunkSize < batch->count ? start + kGQTBatchChunkSize
+                                                          : batch->count;
+  for (size_t i = start; i < end; ++i) {
+    size_t query = batch->queries != NULL ? batch->queries[i].query : i;
+    GQTBounds searchBounds = batch->searchBounds[query];
+    if (batch->counts != NULL) {
+      batch->counts[query] = GQTBoundsIntersectsBounds(storage->bounds, searchBounds)
+                                 ? GQTCountNode(storage, 0, storage->bounds, searchBounds)
+                                 : 0;
+    } else if (GQTBoundsIntersectsBounds(storage->bounds, searchBounds)) {
+      GQTBatchVisitorContext visitorContext = {batch->visitor, batch->context, query};
+      GQTSearchNode(storage, 0, storage->bounds, searchBounds, GQTCallBatchVisitor,
+                    &visitorContext);
+    }
+  }
+}
+
+// Runs |batch| on the calling thread when it is small, and otherwise sorts its queries by the
+// Z-order key of their centers and hands out chunks of neighbouring queries to all cores. Queries
+// of a chunk then descend through the same nodes, which stay in the cache of their core.
+static void GQTRunBatch(GQTBatch *batch) {
+  size_t chunkCount = (batch->count + kGQTBatchChunkSize - 1) / kGQTBatchChunkSize;
+  if (batch->count < kGQTMinConcurrentBatch) {
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+      GQTSearchBatchChunk(batch, chunk);
+    }
+    return;
+  }
+  GQTBatchQuery *queries = GQTReallocArray(NULL, batch->count, sizeof(GQTBatchQuery));
+  for (size_t i = 0; i < batch->count; ++i) {
+    queries[i] = (GQTBatchQuery){GQTZOrderKey(batch->storage->bounds, batch->searchBounds[i]),
+                                 (uint32_t)i};
+  }
+  qsort(queries, batch->count, sizeof(GQTBatchQuery), GQTCompareBatchQueries);
+  batch->queries = queries;
+  dispatch_apply_f(chunkCount, DISPATCH_APPLY_AUTO, batch, GQTSearchBatchChunk);
+  batch->queries = NULL;
+  free(queries);
+}
+
+#pragma mark Wrapped search
+
+// The largest number of copies of the tree a wrapped search covers.
+#define kGQTMaxWrapWindows 32
+
+// The search bounds of a wrapped search shifted into the bounds of the tree, one per copy of the
+// tree they intersect. A point in window i is within the search bounds once offsets[i] is added to
+// its x coordinate.
+typedef struct {
+  GQTBounds bounds[kGQTMaxWrapWindows];
+  double offsets[kGQTMaxWrapWindows];
+  uint32_t count;
+} GQTWrapWindows;
+
+static void GQTMakeWrapWindows(const GQTPointQuadTreeStorage *storage, GQTBounds searchBounds,
+                               GQTWrapWindows *windows) {
+  GQTBounds bounds = storage->bounds;
+  double width = bounds.maxX - bounds.minX;
+  windows->count = 0;
+  if (searchBounds.minY > bounds.maxY || searchBounds.maxY < bounds.minY ||
+      !(searchBounds.minX <= searchBounds.maxX)) {
+    return;
+  }
+  if (!(width > 0) || !isfinite(searchBounds.minX) || !isfinite(searchBounds.maxX)) {
+    windows->bounds[0] = searchBounds;
+    windows->offsets[0] = 0;
+    windows->count = 1;
+    return;
+  }
+  double first = ceil((searchBounds.minX - bounds.maxX) / width);
+  double last = fmin(floor((searchBounds.maxX - bounds.minX) / width),
+                     first + (kGQTMaxWrapWindows - 1));
+  for (double copy = first; copy <= last; ++copy) {
+    double offset = copy * width;
+    uint32_t i = windows->count++;
+    windows->bounds[i] = (GQTBounds){searchBounds.minX - offset, searchBounds.minY,
+                                     searchBounds.maxX - offset, searchBounds.maxY};
+    windows->offsets[i] = offset;
+  }
+}
+
+static bool GQTVisitSubtreeWrapped(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                                   double offset, GQTPointQuadTreeWrappedVisitor visitor,
+                                   void *context) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return true;
+  if (node->children != kGQTNullIndex) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (!GQTVisitSubtreeWrapped(storage, node->children + i, offset, visitor, context)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      GQTPoint point = {storage->xs[entry] + offset, storage->ys[entry]};
+      if (!visitor(context, GQTVisibleItem(storage, entry), point, offset)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Searches the windows of |windowMask| which intersect the node in one traversal. Windows
+// containing the node are visited whole and dropped from the mask.
+static bool GQTSearchWrappedNode(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                                 GQTBounds ownBounds, const GQTWrapWindows *windows,
+                                 uint32_t windowMask, GQTPointQuadTreeWrappedVisitor visitor,
+                                 void *context) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return true;
+  for (uint32_t i = 0; i < windows->count; ++i) {
+    if ((windowMask & (1u << i)) && GQTBoundsContainsBounds(windows->bounds[i], ownBounds)) {
+      windowMask &= ~(1u << i);
+      if (!GQTVisitSubtreeWrapped(storage, nodeIndex, windows->offsets[i], visitor, context)) {
+        return false;
+      }
+    }
+  }
+  if (windowMask == 0) return true;
+  if (node->children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(ownBounds);
+    for (uint32_t i = 0; i < 4; ++i) {
+      GQTBounds childBounds = GQTChildBounds(ownBounds, midPoint, i);
+      uint32_t childMask = 0;
+      for (uint32_t j = 0; j < windows->count; ++j) {
+        if ((windowMask & (1u << j)) &&
+            GQTBoundsIntersectsBounds(childBounds, windows->bounds[j])) {
+          childMask |= 1u << j;
+        }
+      }
+      if (childMask != 0 && !GQTSearchWrappedNode(storage, node->children + i, childBounds,
+                                                  windows, childMask, visitor, context)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      double x = storage->xs[entry];
+      double y = storage->ys[entry];
+      for (uint32_t i = 0; i < windows->count; ++i) {
+        if (!(windowMask & (1u << i))) continue;
+        GQTBounds window = windows->bounds[i];
+        if (x <= window.maxX && x >= window.minX && y <= window.maxY && y >= window.minY) {
+          GQTPoint point = {x + windows->offsets[i], y};
+          if (!visitor(context, GQTVisibleItem(storage, entry), point, windows->offsets[i])) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static size_t GQTCountWrappedNode(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                                  GQTBounds ownBounds, const GQTWrapWindows *windows,
+                                  uint32_t windowMask) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return 0;
+  size_t count = 0;
+  for (uint32_t i = 0; i < windows->count; ++i) {
+    if ((windowMask & (1u << i)) && GQTBoundsContainsBounds(windows->bounds[i], ownBounds)) {
+      windowMask &= ~(1u << i);
+      count += node->count;
+    }
+  }
+  if (windowMask == 0) return count;
+  if (node->children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(ownBounds);
+    for (uint32_t i = 0; i < 4; ++i) {
+      GQTBounds childBounds = GQTChildBounds(ownBounds, midPoint, i);
+      uint32_t childMask = 0;
+      for (uint32_t j = 0; j < windows->count; ++j) {
+        if ((windowMask & (1u << j)) &&
+            GQTBoundsIntersectsBounds(childBounds, windows->bounds[j])) {
+          childMask |= 1u << j;
+        }
+      }
+      if (childMask != 0) {
+        count += GQTCountWrappedNode(storage, node->children + i, childBounds, windows, childMask);
+      }
+    }
+    return count;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      double x = storage->xs[entry];
+      double y = storage->ys[entry];
+      for (uint32_t i = 0; i < windows->count; ++i) {
+        GQTBounds window = windows->bounds[i];
+        count += (windowMask & (1u << i)) && x <= window.maxX && x >= window.minX &&
+                 y <= window.maxY && y >= window.minY;
+      }
+    }
+  }
+  return count;
+}
+
+// Returns the mask of the windows intersecting the bounds of |storage|.
+static uint32_t GQTWrapWindowMask(const GQTPointQuadTreeStorage *storage,
+                                  const GQTWrapWindows *windows) {
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < windows->count; ++i) {
+    if (GQTBoundsIntersectsBounds(storage->bounds, windows->bounds[i])) mask |= 1u << i;
+  }
+  return mask;
+}
+
+#pragma mark Region search
+
+// A circle or polygon searched by GQTSearchRegionNode.
+typedef struct {
+  // Bounding box of the region.
+  GQTBounds bounds;
+
+  // The circle, used when vertices is NULL.
+  GQTPoint center;
+  double radiusSquared;
+
+  // The polygon.
+  const GQTPoint *vertices;
+  size_t vertexCount;
+} GQTRegion;
+
+typedef enum {
+  GQTRegionRelationOutside,
+  GQTRegionRelationIntersects,
+  GQTRegionRelationInside,
+} GQTRegionRelation;
+
+// Returns whether the segment from |a| to |b| has a point within |bounds|, by clipping the segment
+// to |bounds| with the Liang-Barsky algorithm.
+static bool GQTSegmentIntersectsBounds(GQTPoint a, GQTPoint b, GQTBounds bounds) {
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double p[4] = {-dx, dx, -dy, dy};
+  double q[4] = {a.x - bounds.minX, bounds.maxX - a.x, a.y - bounds.minY, bounds.maxY - a.y};
+  double start = 0;
+  double end = 1;
+  for (uint32_t i = 0; i < 4; ++i) {
+    if (p[i] == 0) {
+      if (q[i] < 0) return false;
+      continue;
+    }
+    double t = q[i] / p[i];
+    if (p[i] < 0) {
+      if (t > end) return false;
+      if (t > start) start = t;
+    } else {
+      if (t < start) return false;
+      if (t < end) end = t;
+    }
+  }
+  return true;
+}
+
+// Even-odd rule point in polygon test.
+static inline bool GQTPolygonContainsPoint(const GQTPoint *vertices, size_t vertexCount, double x,
+                                           double y) {
+  bool inside = false;
+  for (size_t i = 0, j = vertexCount - 1; i < vertexCount; j = i++) {
+    GQTPoint a = vertices[i];
+    GQTPoint b = vertices[j];
+    if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+static inline bool GQTRegionContainsPoint(const GQTRegion *region, double x, double y) {
+  if (region->vertices == NULL) {
+    double dx = x - region->center.x;
+    double dy = y - region->center.y;
+    return dx * dx + dy * dy <= region->radiusSquared;
+  }
+  return x <= region->bounds.maxX && x >= region->bounds.minX && y <= region->bounds.maxY &&
+         y >= region->bounds.minY &&
+         GQTPolygonContainsPoint(region->vertices, region->vertexCount, x, y);
+}
+
+static GQTRegionRelation GQTRegionRelationToBounds(const GQTRegion *region, GQTBounds bounds) {
+  if (!GQTBoundsIntersectsBounds(region->bounds, bounds)) return GQTRegionRelationOutside;
+  if (region->vertices == NULL) {
+    GQTPoint center = region->center;
+    double dx = center.x < bounds.minX ? bounds.minX - center.x
+                                       : (center.x > bounds.maxX ? center.x - bounds.maxX : 0);
+    double dy = center.y < bounds.minY ? bounds.minY - center.y
+                                       : (center.y > bounds.maxY ? center.y - bounds.maxY : 0);
+    if (dx * dx + dy * dy > region->radiusSquared) return GQTRegionRelationOutside;
+    // The bounds are inside the circle when their furthest corner is.
+    dx = fmax(center.x - bounds.minX, bounds.maxX - center.x);
+    dy = fmax(center.y - bounds.minY, bounds.maxY - center.y);
+    return dx * dx + dy * dy <= region->radiusSquared ? GQTRegionRelationInside
+                                                      : GQTRegionRelationIntersects;
+  }
+  for (size_t i = 0, j = region->vertexCount - 1; i < region->vertexCount; j = i++) {
+    if (GQTSegmentIntersectsBounds(region->vertices[j], region->vertices[i], bounds)) {
+      return GQTRegionRelationIntersects;
+    }
+  }
+  // No edge touches the bounds, so they are either entirely inside or entirely outside.
+  return GQTPolygonContainsPoint(region->vertices, region->vertexCount, bounds.minX, bounds.minY)
+             ? GQTRegionRelationInside
+             : GQTRegionRelationOutside;
+}
+
+static bool GQTSearchRegionNode(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                                GQTBounds ownBounds, const GQTRegion *region,
+                                GQTPointQuadTreeVisitor visitor, void *context) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return true;
+  switch (GQTRegionRelationToBounds(region, ownBounds)) {
+    case GQTRegionRelationOutside:
+      return true;
+    case GQTRegionRelationInside:
+      return GQTVisitSubtree(storage, nodeIndex, visitor, context);
+    case GQTRegionRelationIntersects:
+      break;
+  }
+  if (node->children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(ownBounds);
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (!GQTSearchRegionNode(storage, node->children + i,
+                               GQTChildBounds(ownBounds, midPoint, i), region, visitor,
+                               context)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (GQTIndex block = node->block; block != kGQTNullIndex; block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      double x = storage->xs[entry];
+      double y = storage->ys[entry];
+      if (GQTRegionContainsPoint(region, x, y)) {
+        GQTPoint point = {x, y};
+        if (!visitor(context, GQTVisibleItem(storage, entry), point)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+#pragma mark Aggregates
+
+// Reports the aggregates of |entries|, which lie within |bounds|, grouped by the quads |depth|
+// levels below |bounds|. Uses |scratch|, which is as large as |entries|, to partition them.
+static bool GQTVisitEntryAggregates(GQTEntry *entries, size_t count, GQTBounds bounds,
+                                    uint32_t depth, GQTBounds searchBounds,
+                                    GQTPointQuadTreeAggregateVisitor visitor, void *context,
+                                    GQTEntry *scratch) {
+  if (count == 0 || !GQTBoundsIntersectsBounds(bounds, searchBounds)) return true;
+  if (depth == 0) {
+    GQTNodeAggregate aggregate = kGQTEmptyNodeAggregate;
+    for (size_t i = 0; i < count; ++i) {
+      GQTAddToAggregate(&aggregate, entries[i].point, entries[i].weight);
+    }
+    return visitor(context, GQTMakeAggregate(&aggregate, count));
+  }
+
+  GQTPoint midPoint = GQTBoundsMidpoint(bounds);
+  size_t ends[4] = {0, 0, 0, 0};
+  for (size_t i = 0; i < count; ++i) {
+    ++ends[GQTQuadrant(entries[i].point, midPoint)];
+  }
+  for (uint32_t quadrant = 1; quadrant < 4; ++quadrant) {
+    ends[quadrant] += ends[quadrant - 1];
+  }
+  size_t positions[4] = {0, ends[0], ends[1], ends[2]};
+  for (size_t i = 0; i < count; ++i) {
+    scratch[positions[GQTQuadrant(entries[i].point, midPoint)]++] = entries[i];
+  }
+  memcpy(entries, scratch, count * sizeof(GQTEntry));
+
+  size_t start = 0;
+  for (uint32_t quadrant = 0; quadrant < 4; ++quadrant) {
+    if (!GQTVisitEntryAggregates(entries + start, ends[quadrant] - start,
+                                 GQTChildBounds(bounds, midPoint, quadrant), depth - 1,
+                                 searchBounds, visitor, context, scratch + start)) {
+      return false;
+    }
+    start = ends[quadrant];
+  }
+  return true;
+}
+
+// |buffer| holds two arrays of leafCapacity entries, used to group the points of leaves above
+// |depth|.
+static bool GQTSearchAggregatesNode(const GQTPointQuadTreeStorage *storage, GQTIndex nodeIndex,
+                                    GQTBounds ownBounds, uint32_t depth, GQTBounds searchBounds,
+                                    GQTPointQuadTreeAggregateVisitor visitor, void *context,
+                                    GQTEntry *buffer) {
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->count == 0) return true;
+  if (depth == 0 || (node->children == kGQTNullIndex && node->count > storage->leafCapacity)) {
+    // Leaves holding more points than a block have all of their points in one cell of maxDepth, so
+    // they cannot be divided.
+    return visitor(context, GQTMakeAggregate(&storage->aggregates[nodeIndex], node->count));
+  }
+  if (node->children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(ownBounds);
+    for (uint32_t i = 0; i < 4; ++i) {
+      GQTBounds childBounds = GQTChildBounds(ownBounds, midPoint, i);
+      if (GQTBoundsIntersectsBounds(childBounds, searchBounds) &&
+          !GQTSearchAggregatesNode(storage, node->children + i, childBounds, depth - 1,
+                                   searchBounds, visitor, context, buffer)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  size_t count = GQTCollectEntries(storage, nodeIndex, buffer);
+  return GQTVisitEntryAggregates(buffer, count, ownBounds, depth, searchBounds, visitor, context,
+                                 buffer + storage->leafCapacity);
+}
+
+#pragma mark Nearest neighbours
+
+// A node waiting to be visited by a nearest neighbour search.
+typedef struct {
+  double distanceSquared;
+  GQTIndex nodeIndex;
+  GQTBounds bounds;
+} GQTCandidate;
+
+static inline double GQTDistanceSquaredToBounds(GQTPoint point, GQTBounds bounds) {
+  double dx = point.x < bounds.minX ? bounds.minX - point.x
+                                    : (point.x > bounds.maxX ? point.x - bounds.maxX : 0);
+  double dy = point.y < bounds.minY ? bounds.minY - point.y
+                                    : (point.y > bounds.maxY ? point.y - bounds.maxY : 0);
+  return dx * dx + dy * dy;
+}
+
+// Pushes |candidate| onto the min-heap of candidates, growing it if needed.
+static void GQTPushCandidate(GQTCandidate **heap, size_t *size, size_t *capacity,
+                             GQTCandidate candidate) {
+  if (*size == *capacity) {
+    *capacity *= 2;
+    *heap = GQTReallocArray(*heap, *capacity, sizeof(GQTCandidate));
+  }
+  GQTCandidate *candidates = *heap;
+  size_t index = (*size)++;
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (candidates[parent].distanceSquared <= candidate.distanceSquared) break;
+    candidates[index] = candidates[parent];
+    index = parent;
+  }
+  candidates[index] = candidate;
+}
+
+static GQTCandidate GQTPopCandidate(GQTCandidate *heap, size_t *size) {
+  GQTCandidate top = heap[0];
+  GQTCandidate last = heap[--(*size)];
+  size_t index = 0;
+  for (;;) {
+    size_t child = 2 * index + 1;
+    if (child >= *size) break;
+    if (child + 1 < *size && heap[child + 1].distanceSquared < heap[child].distanceSquared) {
+      ++child;
+    }
+    if (last.distanceSquared <= heap[child].distanceSquared) break;
+    heap[index] = heap[child];
+    index = child;
+  }
+  if (*size > 0) {
+    heap[index] = last;
+  }
+  return top;
+}
+
+// Restores the max-heap order of the results after the root at |index| has been replaced.
+static void GQTSiftDownResult(const void **items, double *distances, size_t size, size_t index) {
+  const void *item = items[index];
+  double distance = distances[index];
+  for (;;) {
+    size_t child = 2 * index + 1;
+    if (child >= size) break;
+    if (child + 1 < size && distances[child + 1] > distances[child]) {
+      ++child;
+    }
+    if (distance >= distances[child]) break;
+    items[index] = items[child];
+    distances[index] = distances[child];
+    index = child;
+  }
+  items[index] = item;
+  distances[index] = distance;
+}
+
+static void GQTPushResult(const void **items, double *distances, size_t *size, const void *item,
+                          double distance) {
+  size_t index = (*size)++;
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (distances[parent] >= distance) break;
+    items[index] = items[parent];
+    distances[index] = distances[parent];
+    index = parent;
+  }
+  items[index] = item;
+  distances[index] = distance;
+}
+
+#pragma mark Files
+
+// Identifies quad tree files, "GQTS" in ASCII.
+static const uint32_t kGQTFileMagic = 0x47515453;
+static const uint32_t kGQTFileVersion = 1;
+// Written in the byte order of the writer, so that files of the other byte order are rejected.
+static const uint32_t kGQTFileByteOrder = 0x01020304;
+static const uint32_t kGQTFileFlagKeepsAggregates = 1;
+static const uint32_t kGQTFileFlagAdaptive = 2;
+
+// The header at the start of a file. It is followed by the pools of the storage, in the order of
+// GQTFileLayout, each starting at a multiple of 8 bytes.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t flags;
+  uint32_t leafCapacity;
+  uint32_t maxDepth;
+  GQTIndex nodeCount;
+  GQTIndex freeChildren;
+  GQTIndex blockCount;
+  GQTIndex freeBlock;
+  GQTIndex itemCount;
+  GQTIndex freeItemCount;
+  uint64_t count;
+  GQTBounds bounds;
+} GQTFileHeader;
+
+// Offsets of the pools in a file, and the length of the file.
+typedef struct {
+  size_t nodes;
+  size_t aggregates;
+  size_t xs;
+  size_t ys;
+  size_t weights;
+  size_t itemIndices;
+  size_t blockSizes;
+  size_t blockNext;
+  size_t blockLeaves;
+  size_t items;
+  size_t itemEntries;
+  size_t itemGenerations;
+  size_t freeItems;
+  size_t length;
+} GQTFileLayout;
+
+// Returns the offset of a pool of |count| elements of |size| bytes at |*offset|, and moves
+// |*offset| past it.
+static size_t GQTFileSection(size_t *offset, size_t count, size_t size) {
+  size_t start = *offset;
+  *offset = (start + count * size + 7) & ~(size_t)7;
+  return start;
+}
+
+static GQTFileLayout GQTMakeFileLayout(const GQTFileHeader *header) {
+  bool keepsAggregates = header->flags & kGQTFileFlagKeepsAggregates;
+  size_t pointCount = (size_t)header->blockCount * header->leafCapacity;
+  size_t offset = sizeof(GQTFileHeader);
+  GQTFileLayout layout;
+  layout.nodes = GQTFileSection(&offset, header->nodeCount, sizeof(GQTNode));
+  layout.aggregates =
+      GQTFileSection(&offset, keepsAggregates ? header->nodeCount : 0, sizeof(GQTNodeAggregate));
+  layout.xs = GQTFileSection(&offset, pointCount, sizeof(double));
+  layout.ys = GQTFileSection(&offset, pointCount, sizeof(double));
+  layout.weights = GQTFileSection(&offset, keepsAggregates ? pointCount : 0, sizeof(double));
+  layout.itemIndices = GQTFileSection(&offset, pointCount, sizeof(GQTIndex));
+  layout.blockSizes = GQTFileSection(&offset, header->blockCount, sizeof(uint32_t));
+  layout.blockNext = GQTFileSection(&offset, header->blockCount, sizeof(GQTIndex));
+  layout.blockLeaves = GQTFileSection(&offset, header->blockCount, sizeof(GQTIndex));
+  layout.items = GQTFileSection(&offset, header->itemCount, sizeof(uint64_t));
+  layout.itemEntries = GQTFileSection(&offset, header->itemCount, sizeof(uint64_t));
+  layout.itemGenerations = GQTFileSection(&offset, header->itemCount, sizeof(uint32_t));
+  layout.freeItems = GQTFileSection(&offset, header->freeItemCount, sizeof(GQTIndex));
+  layout.length = offset;
+  return layout;
+}
+
+// Writes zeros up to |offset| followed by |length| bytes, keeping track of the |position| in
+// |file|.
+static bool GQTWriteSection(FILE *file, size_t *position, size_t offset, const void *bytes,
+                            size_t length) {
+  static const uint8_t kZeros[8] = {0};
+  if (offset - *position > sizeof(kZeros) ||
+      fwrite(kZeros, 1, offset - *position, file) != offset - *position ||
+      (length > 0 && fwrite(bytes, 1, length, file) != length)) {
+    return false;
+  }
+  *position = offset + length;
+  return true;
+}
+
+// Writes the identifiers of the items of |storage|, 0 for released slots, at |offset|.
+static bool GQTWriteItemIdentifiers(FILE *file, size_t *position, size_t offset,
+                                    const GQTPointQuadTreeStorage *storage,
+                                    GQTItemIdentifierCallBack identifier, void *context) {
+  bool *freeMask = GQTCreateFreeItemMask(storage);
+  uint64_t buffer[256];
+  size_t buffered = 0;
+  bool written = true;
+  for (GQTIndex i = 0; i < storage->itemCount && written; ++i) {
+    uint64_t value = 0;
+    if (!freeMask[i]) {
+      const void *item = GQTResolvedItem(storage, i);
+      value = identifier != NULL ? identifier(context, item) : (uint64_t)(uintptr_t)item;
+    }
+    buffer[buffered++] = value;
+    if (buffered == sizeof(buffer) / sizeof(buffer[0]) || i + 1 == storage->itemCount) {
+      written = GQTWriteSection(file, position, offset, buffer, buffered * sizeof(uint64_t));
+      offset = *position;
+      buffered = 0;
+    }
+  }
+  free(freeMask);
+  return written;
+}
+
+// Writes the entry of every item slot of |storage| as 64 bit integers at |offset|.
+static bool GQTWriteItemEntries(FILE *file, size_t *position, size_t offset,
+                                const GQTPointQuadTreeStorage *storage) {
+  uint64_t buffer[256];
+  size_t buffered = 0;
+  for (GQTIndex i = 0; i < storage->itemCount; ++i) {
+    buffer[buffered++] = storage->itemEntries[i];
+    if (buffered == sizeof(buffer) / sizeof(buffer[0]) || i + 1 == storage->itemCount) {
+      if (!GQTWriteSection(file, position, offset, buffer, buffered * sizeof(uint64_t))) {
+        return false;
+      }
+      offset = *position;
+      buffered = 0;
+    }
+  }
+  return true;
+}
+
+static bool GQTWriteFile(FILE *file, const GQTPointQuadTreeStorage *storage,
+                         GQTItemIdentifierCallBack identifier, void *context) {
+  GQTFileHeader header = {kGQTFileMagic,
+                          kGQTFileVersion,
+                          kGQTFileByteOrder,
+                          (storage->aggregates != NULL ? kGQTFileFlagKeepsAggregates : 0) |
+                              (storage->options.adaptive ? kGQTFileFlagAdaptive : 0),
+                          storage->leafCapacity,
+                          storage->maxDepth,
+                          storage->nodeCount,
+                          storage->freeChildren,
+                          storage->blockCount,
+                          storage->freeBlock,
+                          storage->itemCount,
+                          storage->freeItemCount,
+                          storage->count,
+                          storage->bounds};
+  GQTFileLayout layout = GQTMakeFileLayout(&header);
+  size_t pointBytes = (size_t)storage->blockCount * storage->leafCapacity * sizeof(double);
+  size_t blockBytes = (size_t)storage->blockCount * sizeof(uint32_t);
+  size_t position = 0;
+  bool written =
+      GQTWriteSection(file, &position, 0, &header, sizeof(header)) &&
+      GQTWriteSection(file, &position, layout.nodes, storage->nodes,
+                      storage->nodeCount * sizeof(GQTNode)) &&
+      (storage->aggregates == NULL ||
+       GQTWriteSection(file, &position, layout.aggregates, storage->aggregates,
+                       storage->nodeCount * sizeof(GQTNodeAggregate))) &&
+      GQTWriteSection(file, &position, layout.xs, storage->xs, pointBytes) &&
+      GQTWriteSection(file, &position, layout.ys, storage->ys, pointBytes) &&
+      (storage->weights == NULL ||
+       GQTWriteSection(file, &position, layout.weights, storage->weights, pointBytes)) &&
+      GQTWriteSection(file, &position, layout.itemIndices, storage->itemIndices,
+                      pointBytes / sizeof(double) * sizeof(GQTIndex)) &&
+      GQTWriteSection(file, &position, layout.blockSizes, storage->blockSizes, blockBytes) &&
+      GQTWriteSection(file, &position, layout.blockNext, storage->blockNext, blockBytes) &&
+      GQTWriteSection(file, &position, layout.blockLeaves, storage->blockLeaves, blockBytes) &&
+      GQTWriteItemIdentifiers(file, &position, layout.items, storage, identifier, context) &&
+      GQTWriteItemEntries(file, &position, layout.itemEntries, storage) &&
+      GQTWriteSection(file, &position, layout.itemGenerations, storage->itemGenerations,
+                      storage->itemCount * sizeof(uint32_t)) &&
+      GQTWriteSection(file, &position, layout.freeItems, storage->freeItems,
+                      storage->freeItemCount * sizeof(GQTIndex));
+  // Pad the file to its full length.
+  return written && GQTWriteSection(file, &position, layout.length, NULL, 0);
+}
+
+static bool GQTFileHeaderIsValid(const GQTFileHeader *header, size_t length) {
+  return header->magic == kGQTFileMagic && header->version == kGQTFileVersion &&
+         header->byteOrder == kGQTFileByteOrder &&
+         (header->flags & ~(kGQTFileFlagKeepsAggregates | kGQTFileFlagAdaptive)) == 0 &&
+         header->leafCapacity >= kGQTMinLeafCapacity &&
+         header->leafCapacity <= kGQTMaxLeafCapacity && header->maxDepth >= 1 &&
+         header->maxDepth <= kGQTMaxMaxDepth &&
+         header->nodeCount > 0 && GQTMakeFileLayout(header).length == length;
+}
+
+// Pools of a mapped storage being validated, with the nodes, blocks and item slots reached so far,
+// so that every one of them is found in exactly one place.
+typedef struct {
+  const GQTPointQuadTreeStorage *storage;
+  bool *usedNodes;
+  bool *usedBlocks;
+  bool *usedItems;
+} GQTFileValidation;
+
+static bool *GQTCreateMask(size_t count) {
+  bool *mask = calloc(count > 0 ? count : 1, sizeof(bool));
+  if (mask == NULL) {
+    abort();
+  }
+  return mask;
+}
+
+// Returns whether |children| is the first of a group of four nodes reached for the first time, and
+// marks them as reached.
+static bool GQTFileUseChildren(GQTFileValidation *validation, GQTIndex children) {
+  const GQTPointQuadTreeStorage *storage = validation->storage;
+  // Groups of children follow the root in the node pool.
+  if (children == 0 || (children - 1) % 4 != 0 || (size_t)children + 4 > storage->nodeCount) {
+    return false;
+  }
+  for (uint32_t i = 0; i < 4; ++i) {
+    if (validation->usedNodes[children + i]) return false;
+    validation->usedNodes[children + i] = true;
+  }
+  return true;
+}
+
+// Returns whether the point blocks of |leaf| form a chain of unshared blocks, of which only the
+// first is partially filled, holding the count of the leaf and referencing unshared item slots.
+static bool GQTFileLeafIsValid(GQTFileValidation *validation, GQTIndex leaf) {
+  const GQTPointQuadTreeStorage *storage = validation->storage;
+  uint64_t count = 0;
+  for (GQTIndex block = storage->nodes[leaf].block; block != kGQTNullIndex;
+       block = storage->blockNext[block]) {
+    if (block >= storage->blockCount || validation->usedBlocks[block] ||
+        storage->blockLeaves[block] != leaf) {
+      return false;
+    }
+    uint32_t size = storage->blockSizes[block];
+    if (size == 0 || size > storage->leafCapacity ||
+        (count > 0 && size != storage->leafCapacity)) {
+      return false;
+    }
+    validation->usedBlocks[block] = true;
+    size_t start = (size_t)block * storage->leafCapacity;
+    for (size_t entry = start; entry < start + size; ++entry) {
+      GQTIndex itemIndex = storage->itemIndices[entry];
+      if (itemIndex >= storage->itemCount || validation->usedItems[itemIndex] ||
+          storage->itemEntries[itemIndex] != entry) {
+        return false;
+      }
+      validation->usedItems[itemIndex] = true;
+    }
+    count += size;
+  }
+  return count == storage->nodes[leaf].count;
+}
+
+// Returns whether the subtree rooted at |nodeIndex|, at |depth| below the root, is well formed.
+static bool GQTFileNodeIsValid(GQTFileValidation *validation, GQTIndex nodeIndex, GQTIndex parent,
+                               uint32_t depth) {
+  const GQTPointQuadTreeStorage *storage = validation->storage;
+  const GQTNode *node = &storage->nodes[nodeIndex];
+  if (node->parent != parent) {
+    return false;
+  }
+  if (node->children == kGQTNullIndex) {
+    return GQTFileLeafIsValid(validation, nodeIndex);
+  }
+  if (node->block != kGQTNullIndex || depth >= storage->maxDepth ||
+      !GQTFileUseChildren(validation, node->children)) {
+    return false;
+  }
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < 4; ++i) {
+    GQTIndex child = node->children + i;
+    if (!GQTFileNodeIsValid(validation, child, nodeIndex, depth + 1)) {
+      return false;
+    }
+    count += storage->nodes[child].count;
+  }
+  return count == node->count;
+}
+
+// Returns whether the pools of the mapped |storage| are consistent with each other, so that no
+// index read from the file leads out of its pool and every node, block and item is found exactly
+// once. The header has already been validated against the length of the file.
+static bool GQTFileSectionsAreValid(const GQTPointQuadTreeStorage *storage) {
+  if (storage->freeItemCount > storage->itemCount ||
+      storage->count + storage->freeItemCount != storage->itemCount ||
+      storage->count != storage->nodes[0].count) {
+    return false;
+  }
+  GQTFileValidation validation = {storage, GQTCreateMask(storage->nodeCount),
+                                  GQTCreateMask(storage->blockCount),
+                                  GQTCreateMask(storage->itemCount)};
+  validation.usedNodes[0] = true;
+  bool valid = GQTFileNodeIsValid(&validation, 0, kGQTNullIndex, 0);
+  // The free lists are only followed past entries found to be valid.
+  GQTIndex children = storage->freeChildren;
+  while (valid && children != kGQTNullIndex) {
+    valid = GQTFileUseChildren(&validation, children);
+    children = valid ? storage->nodes[children].children : kGQTNullIndex;
+  }
+  GQTIndex block = storage->freeBlock;
+  while (valid && block != kGQTNullIndex) {
+    valid = block < storage->blockCount && !validation.usedBlocks[block];
+    if (valid) {
+      validation.usedBlocks[block] = true;
+      block = storage->blockNext[block];
+    }
+  }
+  for (GQTIndex i = 0; valid && i < storage->freeItemCount; ++i) {
+    GQTIndex itemIndex = storage->freeItems[i];
+    valid = itemIndex < storage->itemCount && !validation.usedItems[itemIndex];
+    if (valid) {
+      validation.usedItems[itemIndex] = true;
+    }
+  }
+  // Every node and block is either in the tree or free, as in a storage which was written.
+  for (GQTIndex i = 0; valid && i < storage->nodeCount; ++i) {
+    valid = validation.usedNodes[i];
+  }
+  for (GQTIndex i = 0; valid && i < storage->blockCount; ++i) {
+    valid = validation.usedBlocks[i];
+  }
+  free(validation.usedNodes);
+  free(validation.usedBlocks);
+  free(validation.usedItems);
+  return valid;
+}
+
+#pragma mark Public
+
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageCreate(
+    GQTBounds bounds, const GQTItemCallBacks *callBacks,
+    const GQTPointQuadTreeStorageOptions *options) {
+  GQTPointQuadTreeStorage *storage = calloc(1, sizeof(GQTPointQuadTreeStorage));
+  if (storage == NULL) {
+    abort();
+  }
+  storage->bounds = bounds;
+  if (callBacks != NULL) {
+    storage->callBacks = *callBacks;
+  }
+  GQTSetOptions(storage, options != NULL ? *options : (GQTPointQuadTreeStorageOptions){0});
+  atomic_init(&storage->referenceCount, 1);
+  storage->nodeCapacity = 1;
+  storage->nodes = GQTReallocArray(NULL, storage->nodeCapacity, sizeof(GQTNode));
+  if (storage->options.keepsAggregates) {
+    storage->aggregates =
+        GQTReallocArray(NULL, storage->nodeCapacity, sizeof(GQTNodeAggregate));
+  }
+  storage->freeBlock = kGQTNullIndex;
+  GQTResetRoot(storage);
+  return storage;
+}
+
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageCopy(const GQTPointQuadTreeStorage *storage) {
+  GQTPointQuadTreeStorage *copy =
+      GQTPointQuadTreeStorageCreate(storage->bounds, &storage->callBacks, &storage->options);
+  copy->nodeCapacity = storage->nodeCount;
+  copy->nodes = GQTReallocArray(copy->nodes, copy->nodeCapacity, sizeof(GQTNode));
+  memcpy(copy->nodes, storage->nodes, storage->nodeCount * sizeof(GQTNode));
+  if (storage->aggregates != NULL) {
+    copy->aggregates =
+        GQTReallocArray(copy->aggregates, copy->nodeCapacity, sizeof(GQTNodeAggregate));
+    memcpy(copy->aggregates, storage->aggregates, storage->nodeCount * sizeof(GQTNodeAggregate));
+  }
+  copy->nodeCount = storage->nodeCount;
+  copy->freeChildren = storage->freeChildren;
+
+  // Blocks past blockCount are unused, so only the allocated blocks are copied.
+  size_t pointCount = (size_t)storage->blockCount * storage->leafCapacity;
+  copy->blockCapacity = storage->blockCount;
+  copy->xs = GQTReallocArray(NULL, pointCount, sizeof(double));
+  copy->ys = GQTReallocArray(NULL, pointCount, sizeof(double));
+  copy->itemIndices = GQTReallocArray(NULL, pointCount, sizeof(GQTIndex));
+  copy->blockSizes = GQTReallocArray(NULL, copy->blockCapacity, sizeof(uint32_t));
+  copy->blockNext = GQTReallocArray(NULL, copy->blockCapacity, sizeof(GQTIndex));
+  copy->blockLeaves = GQTReallocArray(NULL, copy->blockCapacity, sizeof(GQTIndex));
+  if (storage->weights != NULL) {
+    copy->weights = GQTReallocArray(NULL, pointCount, sizeof(double));
+  }
+  if (pointCount > 0) {
+    memcpy(copy->xs, storage->xs, pointCount * sizeof(double));
+    memcpy(copy->ys, storage->ys, pointCount * sizeof(double));
+    memcpy(copy->itemIndices, storage->itemIndices, pointCount * sizeof(GQTIndex));
+    memcpy(copy->blockSizes, storage->blockSizes, storage->blockCount * sizeof(uint32_t));
+    memcpy(copy->blockNext, storage->blockNext, storage->blockCount * sizeof(GQTIndex));
+    memcpy(copy->blockLeaves, storage->blockLeaves, storage->blockCount * sizeof(GQTIndex));
+    if (storage->weights != NULL) {
+      memcpy(copy->weights, storage->weights, pointCount * sizeof(double));
+    }
+  }
+  copy->blockCount = storage->blockCount;
+  copy->freeBlock = storage->freeBlock;
+
+  // The generations of all slots are kept, including those unused since a clear, so that handles
+  // taken from |storage| never match a different item of the copy.
+  copy->itemCapacity = storage->itemCapacity;
+  GQTIndex pageCount = (storage->itemCount + kGQTItemPageSize - 1) >> kGQTItemPageShift;
+  copy->itemPages = GQTReallocArray(
+      NULL, ((size_t)copy->itemCapacity >> kGQTItemPageShift) + 1, sizeof(GQTItemPage *));
+  copy->itemEntries = GQTReallocArray(NULL, copy->itemCapacity, sizeof(size_t));
+  copy->itemGenerations = GQTReallocArray(NULL, copy->itemCapacity, sizeof(uint32_t));
+  copy->freeItems = GQTReallocArray(NULL, copy->itemCapacity, sizeof(GQTIndex));
+  if (storage->itemCapacity > 0) {
+    memcpy(copy->itemEntries, storage->itemEntries, storage->itemCount * sizeof(size_t));
+    memcpy(copy->itemGenerations, storage->itemGenerations,
+           storage->itemCapacity * sizeof(uint32_t));
+  }
+  if (storage->mapping == NULL) {
+    // The pages are shared, and only duplicated once either storage changes one of their slots.
+    for (GQTIndex i = 0; i < pageCount; ++i) {
+      copy->itemPages[i] = storage->itemPages[i];
+      atomic_fetch_add_explicit(&copy->itemPages[i]->referenceCount, 1, memory_order_relaxed);
+    }
+  } else {
+    // The identifiers of a mapped storage are copied into pages which keep the storage alive, and
+    // are only resolved into retained items when the copy changes a slot of their page.
+    bool *freeMask = GQTCreateFreeItemMask(storage);
+    for (GQTIndex i = 0; i < pageCount; ++i) {
+      GQTItemPage *page = GQTCreateItemPage();
+      page->mappedStorage = GQTPointQuadTreeStorageRetain((GQTPointQuadTreeStorage *)storage);
+      GQTIndex first = i << kGQTItemPageShift;
+      GQTIndex count = storage->itemCount - first;
+      if (count > kGQTItemPageSize) count = kGQTItemPageSize;
+      memcpy(page->items, storage->items + first, count * sizeof(void *));
+      for (GQTIndex slot = 0; slot < kGQTItemPageSize; ++slot) {
+        if (slot >= count || freeMask[first + slot]) {
+          page->freeSlots[slot / 64] |= (uint64_t)1 << (slot % 64);
+        }
+      }
+      copy->itemPages[i] = page;
+    }
+    free(freeMask);
+  }
+  copy->itemPageCount = pageCount;
+  if (storage->freeItemCount > 0) {
+    memcpy(copy->freeItems, storage->freeItems, storage->freeItemCount * sizeof(GQTIndex));
+  }
+  copy->itemCount = storage->itemCount;
+  copy->freeItemCount = storage->freeItemCount;
+  copy->count = storage->count;
+  return copy;
+}
+
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageCreateWithFile(const char *path,
+                                                               const GQTItemCallBacks *callBacks,
+                                                               const GQTItemResolver *resolver) {
+  // Item identifiers and entries are stored as 64 bit integers and used in place.
+  if (sizeof(void *) != sizeof(uint64_t) || sizeof(size_t) != sizeof(uint64_t)) {
+    errno = ENOTSUP;
+    return NULL;
+  }
+  int file = open(path, O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    return NULL;
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0) {
+    int error = errno;
+    close(file);
+    errno = error;
+    return NULL;
+  }
+  size_t length = (size_t)status.st_size;
+  if (length < sizeof(GQTFileHeader)) {
+    close(file);
+    errno = EINVAL;
+    return NULL;
+  }
+  void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+  int error = errno;
+  close(file);
+  if (mapping == MAP_FAILED) {
+    errno = error;
+    return NULL;
+  }
+  const GQTFileHeader *header = mapping;
+  if (!GQTFileHeaderIsValid(header, length)) {
+    munmap(mapping, length);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  GQTPointQuadTreeStorage *storage = calloc(1, sizeof(GQTPointQuadTreeStorage));
+  if (storage == NULL) {
+    abort();
+  }
+  atomic_init(&storage->referenceCount, 1);
+  storage->bounds = header->bounds;
+  if (callBacks != NULL) {
+    storage->callBacks = *callBacks;
+  }
+  GQTSetOptions(storage, (GQTPointQuadTreeStorageOptions){
+                            .keepsAggregates = header->flags & kGQTFileFlagKeepsAggregates,
+                            .leafCapacity = header->leafCapacity,
+                            .maxDepth = header->maxDepth,
+                            .adaptive = header->flags & kGQTFileFlagAdaptive,
+                        });
+  if (resolver != NULL) {
+    storage->resolver = *resolver;
+  }
+  storage->mapping = mapping;
+  storage->mappingLength = length;
+
+  GQTFileLayout layout = GQTMakeFileLayout(header);
+  char *bytes = mapping;
+  storage->nodes = (GQTNode *)(bytes + layout.nodes);
+  storage->nodeCount = header->nodeCount;
+  storage->nodeCapacity = header->nodeCount;
+  storage->freeChildren = header->freeChildren;
+  if (storage->options.keepsAggregates) {
+    storage->aggregates = (GQTNodeAggregate *)(bytes + layout.aggregates);
+    storage->weights = (double *)(bytes + layout.weights);
+  }
+  storage->xs = (double *)(bytes + layout.xs);
+  storage->ys = (double *)(bytes + layout.ys);
+  storage->itemIndices = (GQTIndex *)(bytes + layout.itemIndices);
+  storage->blockSizes = (uint32_t *)(bytes + layout.blockSizes);
+  storage->blockNext = (GQTIndex *)(bytes + layout.blockNext);
+  storage->blockLeaves = (GQTIndex *)(bytes + layout.blockLeaves);
+  storage->blockCount = header->blockCount;
+  storage->blockCapacity = header->blockCount;
+  storage->freeBlock = header->freeBlock;
+  storage->items = (const void **)(bytes + layout.items);
+  storage->itemEntries = (size_t *)(bytes + layout.itemEntries);
+  storage->itemGenerations = (uint32_t *)(bytes + layout.itemGenerations);
+  storage->itemCount = header->itemCount;
+  storage->itemCapacity = header->itemCount;
+  storage->freeItems = (GQTIndex *)(bytes + layout.freeItems);
+  storage->freeItemCount = header->freeItemCount;
+  storage->count = (size_t)header->count;
+  if (!GQTFileSectionsAreValid(storage)) {
+    munmap(mapping, length);
+    free(storage);
+    errno = EINVAL;
+    return NULL;
+  }
+  return storage;
+}
+
+bool GQTPointQuadTreeStorageWriteToFile(const GQTPointQuadTreeStorage *storage, const char *path,
+                                        GQTItemIdentifierCallBack identifier, void *context) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bool written = GQTWriteFile(file, storage, identifier, context);
+  int error = ferror(file) ? errno : EIO;
+  if (fclose(file) != 0 && written) {
+    written = false;
+    error = errno;
+  }
+  if (!written) {
+    remove(path);
+    errno = error;
+  }
+  return written;
+}
+
+GQTPointQuadTreeStorage *GQTPointQuadTreeStorageRetain(GQTPointQuadTreeStorage *storage) {
+  atomic_fetch_add_explicit(&storage->referenceCount, 1, memory_order_relaxed);
+  return storage;
+}
+
+void GQTPointQuadTreeStorageRelease(GQTPointQuadTreeStorage *storage) {
+  if (storage == NULL) return;
+  if (atomic_fetch_sub_explicit(&storage->referenceCount, 1, memory_order_acq_rel) != 1) return;
+  if (storage->mapping != NULL) {
+    munmap(storage->mapping, storage->mappingLength);
+    if (storage->resolver.releaseContext != NULL) {
+      storage->resolver.releaseContext(storage->resolver.context);
+    }
+    free(storage);
+    return;
+  }
+  GQTPointQuadTreeStorageClear(storage);
+  free(storage->nodes);
+  free(storage->aggregates);
+  free(storage->xs);
+  free(storage->ys);
+  free(storage->itemIndices);
+  free(storage->weights);
+  free(storage->blockSizes);
+  free(storage->blockNext);
+  free(storage->blockLeaves);
+  free(storage->itemPages);
+  free(storage->itemEntries);
+  free(storage->itemGenerations);
+  free(storage->freeItems);
+  free(storage);
+}
+
+bool GQTPointQuadTreeStorageIsShared(const GQTPointQuadTreeStorage *storage) {
+  GQTPointQuadTreeStorage *mutableStorage = (GQTPointQuadTreeStorage *)storage;
+  return storage->mapping != NULL ||
+         atomic_load_explicit(&mutableStorage->referenceCount, memory_order_acquire) > 1;
+}
+
+GQTBounds GQTPointQuadTreeStorageGetBounds(const GQTPointQuadTreeStorage *storage) {
+  return storage->bounds;
+}
+
+GQTPointQuadTreeStorageOptions GQTPointQuadTreeStorageGetOptions(
+    const GQTPointQuadTreeStorage *storage) {
+  return storage->options;
+}
+
+size_t GQTPointQuadTreeStorageGetCount(const GQTPointQuadTreeStorage *storage) {
+  return storage->count;
+}
+
+bool GQTPointQuadTreeStorageAdd(GQTPointQuadTreeStorage *storage, GQTPoint point,
+                                const void *item, GQTItemHandle *handle) {
+  if (!GQTBoundsContainsPoint(storage->bounds, point)) {
+    if (handle != NULL) {
+      *handle = kGQTInvalidItemHandle;
+    }
+    return false;
+  }
+  GQTIndex itemIndex = GQTAllocateItem(storage, item);
+  GQTInsert(storage, GQTMakeEntry(storage, point, itemIndex));
+  ++storage->count;
+  if (handle != NULL) {
+    *handle = GQTMakeHandle(storage, itemIndex);
+  }
+  return true;
+}
+
+size_t GQTPointQuadTreeStorageAddBatch(GQTPointQuadTreeStorage *storage, const GQTPoint *points,
+                                       const void *const *items, size_t count,
+                                       GQTItemHandle *handles) {
+  GQTEntry *entries = GQTReallocArray(NULL, count, sizeof(GQTEntry));
+  size_t added = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (!GQTBoundsContainsPoint(storage->bounds, points[i])) {
+      if (handles != NULL) {
+        handles[i] = kGQTInvalidItemHandle;
+      }
+      continue;
+    }
+    entries[added] = GQTMakeEntry(storage, points[i], GQTAllocateItem(storage, items[i]));
+    if (handles != NULL) {
+      handles[i] = GQTMakeHandle(storage, entries[added].itemIndex);
+    }
+    ++added;
+  }
+  if (added == 0) {
+    free(entries);
+    return 0;
+  }
+
+  if (added >= storage->count) {
+    // The batch dominates the tree, so lay out the whole tree again instead of splitting leaves
+    // as it grows.
+    size_t existing = storage->count;
+    entries = GQTReallocArray(entries, added + existing, sizeof(GQTEntry));
+    GQTCollectEntries(storage, 0, entries + added);
+    GQTResetNodes(storage);
+    GQTBuild(storage, entries, added + existing);
+  } else {
+    for (size_t i = 0; i < added; ++i) {
+      GQTInsert(storage, entries[i]);
+    }
+  }
+  storage->count += added;
+  free(entries);
+  return added;
+}
+
+bool GQTPointQuadTreeStorageRemove(GQTPointQuadTreeStorage *storage, GQTPoint point,
+                                   GQTItemMatcher matcher, void *context) {
+  if (!GQTBoundsContainsPoint(storage->bounds, point)) {
+    return false;
+  }
+
+  GQTIndex nodeIndex = 0;
+  GQTBounds bounds = storage->bounds;
+  while (storage->nodes[nodeIndex].children != kGQTNullIndex) {
+    GQTPoint midPoint = GQTBoundsMidpoint(bounds);
+    uint32_t quadrant = GQTQuadrant(point, midPoint);
+    bounds = GQTChildBounds(bounds, midPoint, quadrant);
+    nodeIndex = storage->nodes[nodeIndex].children + quadrant;
+  }
+
+  for (GQTIndex block = storage->nodes[nodeIndex].block; block != kGQTNullIndex;
+       block = storage->blockNext[block]) {
+    size_t start = (size_t)block * storage->leafCapacity;
+    size_t end = start + storage->blockSizes[block];
+    for (size_t entry = start; entry < end; ++entry) {
+      if (matcher(context, GQTVisibleItem(storage, entry))) {
+        GQTRemoveEntry(storage, entry);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool GQTPointQuadTreeStorageRemoveHandle(GQTPointQuadTreeStorage *storage, GQTItemHandle handle) {
+  GQTIndex itemIndex = (GQTIndex)handle;
+  if (itemIndex >= storage->itemCount || GQTMakeHandle(storage, itemIndex) != handle) {
+    return false;
+  }
+  GQTRemoveEntry(storage, storage->itemEntries[itemIndex]);
+  return true;
+}
+
+void GQTPointQuadTreeStorageClear(GQTPointQuadTreeStorage *storage) {
+  for (GQTIndex i = 0; i < storage->itemCount; ++i) {
+    ++storage->itemGenerations[i];
+  }
+  GQTReleaseItemPages(storage);
+  storage->itemCount = 0;
+  storage->freeItemCount = 0;
+  storage->blockCount = 0;
+  storage->freeBlock = kGQTNullIndex;
+  storage->count = 0;
+  GQTResetRoot(storage);
+}
+
+bool GQTPointQuadTreeStorageSearch(const GQTPointQuadTreeStorage *storage, GQTBounds searchBounds,
+                                   GQTPointQuadTreeVisitor visitor, void *context) {
+  if (!GQTBoundsIntersectsBounds(storage->bounds, searchBounds)) {
+    return true;
+  }
+  return GQTSearchNode(storage, 0, storage->bounds, searchBounds, visitor, context);
+}
+
+size_t GQTPointQuadTreeStorageCountInBounds(const GQTPointQuadTreeStorage *storage,
+                                            GQTBounds searchBounds) {
+  if (!GQTBoundsIntersectsBounds(storage->bounds, searchBounds)) {
+    return 0;
+  }
+  return GQTCountNode(storage, 0, storage->bounds, searchBounds);
+}
+
+void GQTPointQuadTreeStorageSearchBatch(const GQTPointQuadTreeStorage *storage,
+                                        const GQTBounds *searchBounds, size_t count,
+                                        GQTPointQuadTreeBatchVisitor visitor, void *context) {
+  if (count == 0 || count > UINT32_MAX) {
+    return;
+  }
+  GQTBatch batch = {storage, searchBounds, NULL, count, visitor, context, NULL};
+  GQTRunBatch(&batch);
+}
+
+void GQTPointQuadTreeStorageCountInBoundsBatch(const GQTPointQuadTreeStorage *storage,
+                                               const GQTBounds *searchBounds, size_t count,
+                                               size_t *counts) {
+  if (count == 0 || count > UINT32_MAX) {
+    return;
+  }
+  GQTBatch batch = {storage, searchBounds, NULL, count, NULL, NULL, counts};
+  GQTRunBatch(&batch);
+}
+
+bool GQTPointQuadTreeStorageSearchWrapped(const GQTPointQuadTreeStorage *storage,
+                                          GQTBounds searchBounds,
+                                          GQTPointQuadTreeWrappedVisitor visitor, void *context) {
+  GQTWrapWindows windows;
+  GQTMakeWrapWindows(storage, searchBounds, &windows);
+  uint32_t mask = GQTWrapWindowMask(storage, &windows);
+  if (mask == 0) {
+    return true;
+  }
+  return GQTSearchWrappedNode(storage, 0, storage->bounds, &windows, mask, visitor, context);
+}
+
+size_t GQTPointQuadTreeStorageCountInWrappedBounds(const GQTPointQuadTreeStorage *storage,
+                                                   GQTBounds searchBounds) {
+  GQTWrapWindows windows;
+  GQTMakeWrapWindows(storage, searchBounds, &windows);
+  uint32_t mask = GQTWrapWindowMask(storage, &windows);
+  if (mask == 0) {
+    return 0;
+  }
+  return GQTCountWrappedNode(storage, 0, storage->bounds, &windows, mask);
+}
+
+bool GQTPointQuadTreeStorageSearchCircle(const GQTPointQuadTreeStorage *storage, GQTPoint center,
+                                         double radius, GQTPointQuadTreeVisitor visitor,
+                                         void *context) {
+  if (!(radius >= 0)) {
+    return true;
+  }
+  GQTRegion region = {{center.x - radius, center.y - radius, center.x + radius, center.y + radius},
+                      center,
+                      radius * radius,
+                      NULL,
+                      0};
+  return GQTSearchRegionNode(storage, 0, storage->bounds, &region, visitor, context);
+}
+
+bool GQTPointQuadTreeStorageSearchPolygon(const GQTPointQuadTreeStorage *storage,
+                                          const GQTPoint *vertices, size_t vertexCount,
+                                          GQTPointQuadTreeVisitor visitor, void *context) {
+  if (vertexCount < 3) {
+    return true;
+  }
+  GQTRegion region = {{INFINITY, INFINITY, -INFINITY, -INFINITY}, {0, 0}, 0, vertices,
+                      vertexCount};
+  for (size_t i = 0; i < vertexCount; ++i) {
+    region.bounds = GQTBoundsUnion(region.bounds, (GQTBounds){vertices[i].x, vertices[i].y,
+                                                              vertices[i].x, vertices[i].y});
+  }
+  return GQTSearchRegionNode(storage, 0, storage->bounds, &region, visitor, context);
+}
+
+bool GQTPointQuadTreeStorageSearchAggregates(const GQTPointQuadTreeStorage *storage,
+                                             GQTBounds searchBounds, uint32_t depth,
+                                             GQTPointQuadTreeAggregateVisitor visitor,
+                                             void *context) {
+  if (storage->aggregates == NULL || !GQTBoundsIntersectsBounds(storage->bounds, searchBounds)) {
+    return true;
+  }
+  GQTEntry *buffer = GQTReallocArray(NULL, 2 * storage->leafCapacity, sizeof(GQTEntry));
+  bool result = GQTSearchAggregatesNode(storage, 0, storage->bounds, depth, searchBounds, visitor,
+                                        context, buffer);
+  free(buffer);
+  return result;
+}
+
+size_t GQTPointQuadTreeStorageNearest(const GQTPointQuadTreeStorage *storage, GQTPoint point,
+                                      size_t count, double maximumDistance, const void **items,
+                                      double *distances) {
+  if (count == 0 || storage->count == 0 || !(maximumDistance >= 0)) {
+    return 0;
+  }
+  double limit = maximumDistance * maximumDistance;
+
+  // Best-first traversal: nodes are visited in order of their distance to |point|, and the search
+  // ends as soon as the closest unvisited node is further away than the worst result kept.
+  // |items| and |distances| hold the results as a max-heap on squared distance while searching.
+  size_t capacity = 64;
+  size_t size = 0;
+  GQTCandidate *heap = GQTReallocArray(NULL, capacity, sizeof(GQTCandidate));
+  size_t found = 0;
+  double rootDistance = GQTDistanceSquaredToBounds(point, storage->bounds);
+  if (rootDistance <= limit) {
+    GQTPushCandidate(&heap, &size, &capacity, (GQTCandidate){rootDistance, 0, storage->bounds});
+  }
+  while (size > 0) {
+    GQTCandidate candidate = GQTPopCandidate(heap, &size);
+    double worst = found == count ? distances[0] : limit;
+    if (candidate.distanceSquared > worst) break;
+
+    const GQTNode *node = &storage->nodes[candidate.nodeIndex];
+    if (node->count == 0) continue;
+    if (node->children != kGQTNullIndex) {
+      GQTPoint midPoint = GQTBoundsMidpoint(candidate.bounds);
+      GQTIndex children = node->children;
+      for (uint32_t i = 0; i < 4; ++i) {
+        GQTBounds childBounds = GQTChildBounds(candidate.bounds, midPoint, i);
+        double distance = GQTDistanceSquaredToBounds(point, childBounds);
+        if (distance <= worst && storage->nodes[children + i].count > 0) {
+          GQTPushCandidate(&heap, &size, &capacity,
+                           (GQTCandidate){distance, children + i, childBounds});
+        }
+      }
+      continue;
+    }
+    for (GQTIndex block = node->block; block != kGQTNullIndex;
+         block = storage->blockNext[block]) {
+      size_t start = (size_t)block * storage->leafCapacity;
+      size_t end = start + storage->blockSizes[block];
+      for (size_t entry = start; entry < end; ++entry) {
+        double dx = storage->xs[entry] - point.x;
+        double dy = storage->ys[entry] - point.y;
+        double distance = dx * dx + dy * dy;
+        if (found < count) {
+          if (distance <= limit) {
+            GQTPushResult(items, distances, &found, GQTVisibleItem(storage, entry), distance);
+          }
+        } else if (distance < distances[0]) {
+          items[0] = GQTVisibleItem(storage, entry);
+          distances[0] = distance;
+          GQTSiftDownResult(items, distances, found, 0);
+        }
+      }
+    }
+  }
+  free(heap);
+
+  // Heap sort the results into ascending order of distance.
+  for (size_t end = found; end > 1; --end) {
+    const void *item = items[0];
+    double distance = distances[0];
+    items[0] = items[end - 1];
+    distances[0] = distances[end - 1];
+    GQTSiftDownResult(items, distances, end - 1, 0);
+    items[end - 1] = item;
+    distances[end - 1] = distance;
+  }
+  for (size_t i = 0; i < found; ++i) {
+    distances[i] = sqrt(distances[i]);
+  }
+  return found;
+}
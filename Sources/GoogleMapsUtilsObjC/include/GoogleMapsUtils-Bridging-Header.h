@@ -32,15 +32,25 @@ FOUNDATION_EXPORT const unsigned char GoogleMapsUtilsVersionString[];
 // Clustering
 #import "GMUMarkerClustering.h"
 #import "GMUClusterAlgorithm.h"
+#import "GMUClusterCancellationToken.h"
+#import "GMUCachingClusterAlgorithm.h"
 #import "GMUGridBasedClusterAlgorithm.h"
+#import "GMUHierarchicalDistanceBasedAlgorithm.h"
 #import "GMUNonHierarchicalDistanceBasedAlgorithm.h"
+#import "GMUNonHierarchicalDistanceBasedAlgorithm+Testing.h"
 #import "GMUSimpleClusterAlgorithm.h"
 #import "GMUWrappingDictionaryKey.h"
 #import "GMUCluster.h"
+#import "GMUClusterAggregate.h"
+#import "GMUClusterAggregateAccumulator.h"
+#import "GMUClusterDelta.h"
 #import "GMUClusterItem.h"
+#import "GMUClusterCategoryTable.h"
 #import "GMUClusterManager.h"
 #import "GMUClusterManager+Testing.h"
+#import "GMUPackedClusterItem.h"
 #import "GMUStaticCluster.h"
+#import "GMUStaticCluster+Private.h"
 #import "GMUClusterIconGenerator.h"
 #import "GMUClusterRenderer.h"
 #import "GMUDefaultClusterIconGenerator.h"
@@ -68,6 +78,7 @@ FOUNDATION_EXPORT const unsigned char GoogleMapsUtilsVersionString[];
 #import "GMUPair.h"
 
 // QuadTree
+#import "GQTAggregate.h"
 #import "GQTBounds.h"
 #import "GQTPoint.h"
 #import "GQTPointQuadTree.h"
@@ -0,0 +1,231 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import <XCTest/XCTest.h>
+
+#import "GMUCachingClusterAlgorithm.h"
+#import "GMUClusterAlgorithm.h"
+#import "GMUClusterBenchmarkDataset.h"
+#import "GMUGridBasedClusterAlgorithm.h"
+#import "GMUHierarchicalDistanceBasedAlgorithm.h"
+#import "GMUNonHierarchicalDistanceBasedAlgorithm.h"
+#import "GMUSimpleClusterAlgorithm.h"
+
+#include <time.h>
+
+// The benchmarks only run when GMU_RUN_BENCHMARKS is set in the environment of the test process,
+// and are configured through these other variables:
+// - GMU_BENCHMARK_SIZES: comma separated item counts (default 10000,100000,1000000,2000000).
+// - GMU_BENCHMARK_SEED: seed of the generated datasets (default 1).
+// - GMU_BENCHMARK_REPLAY_FILE: a recorded dataset to benchmark along with the generated ones, in
+//   the format read by GMUClusterBenchmarkDataset.
+// - GMU_BENCHMARK_OUTPUT: path the JSON report is written to (default
+//   gmu_cluster_benchmarks.json in the temporary directory). It is also attached to the test.
+// xcodebuild passes variables prefixed with TEST_RUNNER_ to the test process without the prefix.
+static NSString *const kGMURunBenchmarksKey = @"GMU_RUN_BENCHMARKS";
+static NSString *const kGMUSizesKey = @"GMU_BENCHMARK_SIZES";
+static NSString *const kGMUSeedKey = @"GMU_BENCHMARK_SEED";
+static NSString *const kGMUReplayFileKey = @"GMU_BENCHMARK_REPLAY_FILE";
+static NSString *const kGMUOutputKey = @"GMU_BENCHMARK_OUTPUT";
+
+static NSString *const kGMUDefaultSizes = @"10000,100000,1000000,2000000";
+static const uint64_t kGMUDefaultSeed = 1;
+static const NSUInteger kGMUMaxZoom = 20;
+// removeItem: takes linear time in some algorithms, so only this many items are removed.
+static const NSUInteger kGMURemovedItemCount = 1000;
+
+typedef id<GMUClusterAlgorithm> (^GMUAlgorithmFactory)(void);
+
+static uint64_t GMUNow(void) {
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static double GMUSecondsSince(uint64_t start) {
+  return (GMUNow() - start) / 1e9;
+}
+
+@interface GMUClusterAlgorithmBenchmarks : XCTestCase
+@end
+
+@implementation GMUClusterAlgorithmBenchmarks
+
+- (void)setUp {
+  [super setUp];
+  NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+  XCTSkipUnless(environment[kGMURunBenchmarksKey] != nil, @"Set %@ to run the benchmarks.",
+                kGMURunBenchmarksKey);
+  self.executionTimeAllowance = 24 * 60 * 60;
+}
+
+- (void)testClusterAlgorithms {
+  NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+  uint64_t seed = kGMUDefaultSeed;
+  if (environment[kGMUSeedKey] != nil) {
+    seed = strtoull(environment[kGMUSeedKey].UTF8String, NULL, 10);
+  }
+  NSMutableArray<GMUClusterBenchmarkDataset *> *datasets = [[NSMutableArray alloc] init];
+  NSString *sizes = environment[kGMUSizesKey] ?: kGMUDefaultSizes;
+  for (NSString *size in [sizes componentsSeparatedByString:@","]) {
+    NSUInteger count = (NSUInteger)size.longLongValue;
+    for (GMUClusterBenchmarkDistribution distribution = GMUClusterBenchmarkDistributionUniform;
+         distribution <= GMUClusterBenchmarkDistributionDuplicateHeavy; ++distribution) {
+      [datasets addObject:[[GMUClusterBenchmarkDataset alloc] initWithDistribution:distribution
+                                                                             count:count
+                                                                              seed:seed]];
+    }
+  }
+  NSString *replayFile = environment[kGMUReplayFileKey];
+  if (replayFile != nil) {
+    GMUClusterBenchmarkDataset *dataset =
+        [[GMUClusterBenchmarkDataset alloc] initWithContentsOfFile:replayFile];
+    XCTAssertNotNil(dataset, @"Can't read %@", replayFile);
+    if (dataset != nil) [datasets addObject:dataset];
+  }
+
+  NSMutableArray<NSDictionary *> *results = [[NSMutableArray alloc] init];
+  NSArray<NSString *> *algorithmNames = [self algorithmNames];
+  NSDictionary<NSString *, GMUAlgorithmFactory> *algorithmFactories = [self algorithmFactories];
+  for (GMUClusterBenchmarkDataset *dataset in datasets) {
+    @autoreleasepool {
+      NSArray<id<GMUClusterItem>> *items = [dataset items];
+      for (NSString *algorithmName in algorithmNames) {
+        @autoreleasepool {
+          NSDictionary *result = [self benchmarkAlgorithmFactory:algorithmFactories[algorithmName]
+                                                        dataset:dataset
+                                                          items:items];
+          NSMutableDictionary *namedResult = [result mutableCopy];
+          namedResult[@"algorithm"] = algorithmName;
+          namedResult[@"dataset"] = dataset.name;
+          namedResult[@"itemCount"] = @(dataset.count);
+          [results addObject:namedResult];
+        }
+      }
+    }
+  }
+
+  NSDictionary *report = @{@"seed" : @(seed), @"results" : results};
+  NSError *error;
+  NSData *json = [NSJSONSerialization dataWithJSONObject:report
+                                                 options:NSJSONWritingPrettyPrinted |
+                                                         NSJSONWritingSortedKeys
+                                                   error:&error];
+  XCTAssertNotNil(json, @"%@", error);
+  NSString *outputPath =
+      environment[kGMUOutputKey]
+          ?: [NSTemporaryDirectory() stringByAppendingPathComponent:@"gmu_cluster_benchmarks.json"];
+  XCTAssertTrue([json writeToFile:outputPath atomically:YES], @"Can't write %@", outputPath);
+  NSLog(@"Wrote cluster benchmark results to %@", outputPath);
+  XCTAttachment *attachment = [XCTAttachment attachmentWithData:json
+                                          uniformTypeIdentifier:@"public.json"];
+  attachment.name = outputPath.lastPathComponent;
+  attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+  [self addAttachment:attachment];
+}
+
+#pragma mark Private
+
+// Returns the timings of adding |items| to a new algorithm, clustering them at every zoom level
+// and removing some of them.
+- (NSDictionary *)benchmarkAlgorithmFactory:(GMUAlgorithmFactory)factory
+                                    dataset:(GMUClusterBenchmarkDataset *)dataset
+                                      items:(NSArray<id<GMUClusterItem>> *)items {
+  NSMutableDictionary *result = [[NSMutableDictionary alloc] init];
+  id<GMUClusterAlgorithm> algorithm = factory();
+  uint64_t start = GMUNow();
+  [algorithm addItems:items];
+  result[@"addItemsSeconds"] = @(GMUSecondsSince(start));
+
+  NSMutableArray<NSDictionary *> *zoomResults = [[NSMutableArray alloc] init];
+  for (NSUInteger zoom = 0; zoom <= kGMUMaxZoom; ++zoom) {
+    @autoreleasepool {
+      start = GMUNow();
+      NSUInteger clusterCount = [algorithm clustersAtZoom:zoom].count;
+      double seconds = GMUSecondsSince(start);
+      [zoomResults addObject:@{
+        @"zoom" : @(zoom),
+        @"seconds" : @(seconds),
+        @"clusterCount" : @(clusterCount)
+      }];
+    }
+  }
+  result[@"clustersAtZoom"] = zoomResults;
+
+  // Removes items spread evenly over the order they were added in.
+  NSUInteger removedCount = MIN(kGMURemovedItemCount, items.count);
+  NSUInteger stride = removedCount > 0 ? items.count / removedCount : 1;
+  start = GMUNow();
+  for (NSUInteger i = 0; i < removedCount; ++i) {
+    [algorithm removeItem:items[i * stride]];
+  }
+  result[@"removeItem"] = @{@"itemCount" : @(removedCount), @"seconds" : @(GMUSecondsSince(start))};
+
+  id<GMUClusterAlgorithm> packedAlgorithm = factory();
+  if ([packedAlgorithm respondsToSelector:@selector(addItemsWithCoordinates:identifiers:count:)]) {
+    int64_t *identifiers = malloc(MAX(dataset.count, 1) * sizeof(int64_t));
+    for (NSUInteger i = 0; i < dataset.count; ++i) {
+      identifiers[i] = (int64_t)i;
+    }
+    start = GMUNow();
+    [packedAlgorithm addItemsWithCoordinates:dataset.coordinates
+                                 identifiers:identifiers
+                                       count:dataset.count];
+    result[@"addItemsWithCoordinatesSeconds"] = @(GMUSecondsSince(start));
+    free(identifiers);
+  }
+  return result;
+}
+
+// Names of the benchmarked algorithms, in the order they are benchmarked.
+- (NSArray<NSString *> *)algorithmNames {
+  return @[
+    @"GMUSimpleClusterAlgorithm", @"GMUGridBasedClusterAlgorithm",
+    @"GMUNonHierarchicalDistanceBasedAlgorithm",
+    @"GMUNonHierarchicalDistanceBasedAlgorithm(parallel)",
+    @"GMUHierarchicalDistanceBasedAlgorithm", @"GMUCachingClusterAlgorithm(hierarchical)"
+  ];
+}
+
+- (NSDictionary<NSString *, GMUAlgorithmFactory> *)algorithmFactories {
+  return @{
+    @"GMUSimpleClusterAlgorithm" : ^{
+      return [[GMUSimpleClusterAlgorithm alloc] init];
+    },
+    @"GMUGridBasedClusterAlgorithm" : ^{
+      return [[GMUGridBasedClusterAlgorithm alloc] init];
+    },
+    @"GMUNonHierarchicalDistanceBasedAlgorithm" : ^{
+      return [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+    },
+    @"GMUNonHierarchicalDistanceBasedAlgorithm(parallel)" : ^{
+      GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+          [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+      algorithm.parallel = YES;
+      return algorithm;
+    },
+    @"GMUHierarchicalDistanceBasedAlgorithm" : ^{
+      return [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+    },
+    @"GMUCachingClusterAlgorithm(hierarchical)" : ^{
+      return [[GMUCachingClusterAlgorithm alloc]
+          initWithAlgorithm:[[GMUHierarchicalDistanceBasedAlgorithm alloc] init]];
+    },
+  };
+}
+
+@end
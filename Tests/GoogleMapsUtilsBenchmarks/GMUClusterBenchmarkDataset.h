@@ -0,0 +1,61 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "GMUPackedClusterItem.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// How the positions of a generated dataset are distributed.
+typedef NS_ENUM(NSInteger, GMUClusterBenchmarkDistribution) {
+  // Uniform over latitudes -85 to 85 and all longitudes.
+  GMUClusterBenchmarkDistributionUniform,
+  // Normally distributed around 64 uniformly placed hotspots, half a degree wide.
+  GMUClusterBenchmarkDistributionGaussianHotspots,
+  // Uniformly drawn from one distinct position per 100 items, so most positions repeat.
+  GMUClusterBenchmarkDistributionDuplicateHeavy,
+};
+
+// Item positions to benchmark clustering with. A generated dataset only depends on its
+// distribution, count and seed, so a benchmark run can be replayed exactly. Recorded datasets are
+// read from a file instead.
+@interface GMUClusterBenchmarkDataset : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+// Generates |count| positions following |distribution| from |seed|.
+- (instancetype)initWithDistribution:(GMUClusterBenchmarkDistribution)distribution
+                               count:(NSUInteger)count
+                                seed:(uint64_t)seed;
+
+// Reads the positions of the text file at |path|, which holds one "latitude,longitude" pair per
+// line. Returns nil if the file can't be read.
+- (nullable instancetype)initWithContentsOfFile:(NSString *)path;
+
+// Name of the distribution, or of the file for recorded datasets.
+@property(nonatomic, readonly, copy) NSString *name;
+
+@property(nonatomic, readonly) NSUInteger count;
+
+// The |count| positions of the dataset.
+@property(nonatomic, readonly) const CLLocationCoordinate2D *coordinates;
+
+// Returns an item for every position, identified by its index.
+- (NSArray<GMUPackedClusterItem *> *)items;
+
+@end
+
+NS_ASSUME_NONNULL_END
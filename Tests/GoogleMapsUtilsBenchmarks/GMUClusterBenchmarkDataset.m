@@ -0,0 +1,164 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUClusterBenchmarkDataset.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+static const double kGMUMaxLatitude = 85.0;
+static const NSUInteger kGMUHotspotCount = 64;
+static const double kGMUHotspotDegrees = 0.5;
+static const NSUInteger kGMUItemsPerDistinctPosition = 100;
+
+// Returns the next number of the splitmix64 sequence in |state|.
+static uint64_t GMUNextRandom(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Returns a number uniformly distributed in [0, 1).
+static double GMUNextUniform(uint64_t *state) {
+  return (GMUNextRandom(state) >> 11) * 0x1.0p-53;
+}
+
+// Returns a normally distributed number with mean 0 and standard deviation 1 (Box-Muller).
+static double GMUNextGaussian(uint64_t *state) {
+  double u = 1.0 - GMUNextUniform(state);
+  double v = GMUNextUniform(state);
+  return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static CLLocationCoordinate2D GMUNextUniformCoordinate(uint64_t *state) {
+  double latitude = (2.0 * GMUNextUniform(state) - 1.0) * kGMUMaxLatitude;
+  double longitude = GMUNextUniform(state) * 360.0 - 180.0;
+  return CLLocationCoordinate2DMake(latitude, longitude);
+}
+
+// Returns |coordinate| with its latitude clamped to the map and its longitude wrapped to
+// [-180, 180).
+static CLLocationCoordinate2D GMUNormalizedCoordinate(CLLocationCoordinate2D coordinate) {
+  double latitude = fmin(fmax(coordinate.latitude, -kGMUMaxLatitude), kGMUMaxLatitude);
+  double longitude = fmod(coordinate.longitude + 180.0, 360.0);
+  if (longitude < 0) longitude += 360.0;
+  return CLLocationCoordinate2DMake(latitude, longitude - 180.0);
+}
+
+static NSString *GMUDistributionName(GMUClusterBenchmarkDistribution distribution) {
+  switch (distribution) {
+    case GMUClusterBenchmarkDistributionUniform:
+      return @"uniform";
+    case GMUClusterBenchmarkDistributionGaussianHotspots:
+      return @"gaussianHotspots";
+    case GMUClusterBenchmarkDistributionDuplicateHeavy:
+      return @"duplicateHeavy";
+  }
+  return @"unknown";
+}
+
+@implementation GMUClusterBenchmarkDataset {
+  CLLocationCoordinate2D *_coordinates;
+}
+
+- (instancetype)initWithDistribution:(GMUClusterBenchmarkDistribution)distribution
+                               count:(NSUInteger)count
+                                seed:(uint64_t)seed {
+  if ((self = [super init])) {
+    _name = GMUDistributionName(distribution);
+    _count = count;
+    _coordinates = malloc(MAX(count, 1) * sizeof(CLLocationCoordinate2D));
+    uint64_t state = seed;
+    switch (distribution) {
+      case GMUClusterBenchmarkDistributionUniform:
+        for (NSUInteger i = 0; i < count; ++i) {
+          _coordinates[i] = GMUNextUniformCoordinate(&state);
+        }
+        break;
+      case GMUClusterBenchmarkDistributionGaussianHotspots: {
+        CLLocationCoordinate2D *hotspots =
+            malloc(kGMUHotspotCount * sizeof(CLLocationCoordinate2D));
+        for (NSUInteger i = 0; i < kGMUHotspotCount; ++i) {
+          hotspots[i] = GMUNextUniformCoordinate(&state);
+        }
+        for (NSUInteger i = 0; i < count; ++i) {
+          CLLocationCoordinate2D hotspot = hotspots[GMUNextRandom(&state) % kGMUHotspotCount];
+          _coordinates[i] = GMUNormalizedCoordinate(CLLocationCoordinate2DMake(
+              hotspot.latitude + GMUNextGaussian(&state) * kGMUHotspotDegrees,
+              hotspot.longitude + GMUNextGaussian(&state) * kGMUHotspotDegrees));
+        }
+        free(hotspots);
+        break;
+      }
+      case GMUClusterBenchmarkDistributionDuplicateHeavy: {
+        NSUInteger distinctCount = MAX(count / kGMUItemsPerDistinctPosition, 1);
+        CLLocationCoordinate2D *positions = malloc(distinctCount * sizeof(CLLocationCoordinate2D));
+        for (NSUInteger i = 0; i < distinctCount; ++i) {
+          positions[i] = GMUNextUniformCoordinate(&state);
+        }
+        for (NSUInteger i = 0; i < count; ++i) {
+          _coordinates[i] = positions[GMUNextRandom(&state) % distinctCount];
+        }
+        free(positions);
+        break;
+      }
+    }
+  }
+  return self;
+}
+
+- (instancetype)initWithContentsOfFile:(NSString *)path {
+  NSString *contents = [NSString stringWithContentsOfFile:path
+                                                 encoding:NSUTF8StringEncoding
+                                                    error:nil];
+  if (contents == nil) return nil;
+  if ((self = [super init])) {
+    _name = path.lastPathComponent;
+    NSArray<NSString *> *lines = [contents componentsSeparatedByCharactersInSet:
+                                               [NSCharacterSet newlineCharacterSet]];
+    _coordinates = malloc(MAX(lines.count, 1) * sizeof(CLLocationCoordinate2D));
+    for (NSString *line in lines) {
+      NSArray<NSString *> *fields = [line componentsSeparatedByString:@","];
+      if (fields.count < 2) continue;
+      _coordinates[_count++] =
+          CLLocationCoordinate2DMake(fields[0].doubleValue, fields[1].doubleValue);
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  free(_coordinates);
+}
+
+- (const CLLocationCoordinate2D *)coordinates {
+  return _coordinates;
+}
+
+- (NSArray<GMUPackedClusterItem *> *)items {
+  NSMutableArray<GMUPackedClusterItem *> *items = [[NSMutableArray alloc] initWithCapacity:_count];
+  for (NSUInteger i = 0; i < _count; ++i) {
+    [items addObject:[[GMUPackedClusterItem alloc] initWithIdentifier:(int64_t)i
+                                                             position:_coordinates[i]]];
+  }
+  return items;
+}
+
+@end
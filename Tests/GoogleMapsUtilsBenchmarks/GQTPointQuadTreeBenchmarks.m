@@ -0,0 +1,215 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import <XCTest/XCTest.h>
+
+#import "GQTBounds.h"
+#import "GQTPoint.h"
+#import "GQTPointQuadTree.h"
+#import "GQTPointQuadTreeItem.h"
+
+#include <time.h>
+
+// The benchmarks only run when GMU_RUN_BENCHMARKS is set in the environment of the test process,
+// and are configured through these other variables:
+// - GMU_BENCHMARK_SEED: seed of the generated items (default 1).
+// - GMU_QUAD_TREE_BENCHMARK_OUTPUT: path the JSON report is written to (default
+//   gmu_quad_tree_benchmarks.json in the temporary directory). It is also attached to the test.
+// xcodebuild passes variables prefixed with TEST_RUNNER_ to the test process without the prefix.
+static NSString *const kGQTRunBenchmarksKey = @"GMU_RUN_BENCHMARKS";
+static NSString *const kGQTSeedKey = @"GMU_BENCHMARK_SEED";
+static NSString *const kGQTOutputKey = @"GMU_QUAD_TREE_BENCHMARK_OUTPUT";
+
+static const long kGQTDefaultSeed = 1;
+static const NSUInteger kGQTItemCount = 100000;
+static const NSUInteger kGQTSearchCount = 1000;
+static const double kGQTSearchSize = 0.05;
+static const GQTBounds kGQTTreeBounds = {-1, -1, 1, 1};
+
+// Split policies compared by testSplitPolicySweep.
+static const NSUInteger kGQTSweepLeafCapacities[] = {8, 16, 32, 64, 128, 256};
+static const NSUInteger kGQTSweepMaxDepths[] = {16, 30};
+
+// Point distributions of the items generated by itemsWithCount:distribution:.
+typedef NS_ENUM(NSInteger, GQTBenchmarkDistribution) {
+  // Uniformly distributed over kGQTTreeBounds.
+  GQTBenchmarkDistributionUniform,
+  // Packed into four hotspots about 0.002 units wide.
+  GQTBenchmarkDistributionClustered,
+  // Stacked on 100 distinct points.
+  GQTBenchmarkDistributionCoincident,
+};
+
+static uint64_t GQTNow(void) {
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static double GQTSecondsSince(uint64_t start) {
+  return (GQTNow() - start) / 1e9;
+}
+
+// Quad tree item with a fixed point.
+@interface GQTSplitPolicyBenchmarkItem : NSObject<GQTPointQuadTreeItem>
+
+- (instancetype)initWithPoint:(GQTPoint)point;
+
+@end
+
+@implementation GQTSplitPolicyBenchmarkItem {
+  GQTPoint _point;
+}
+
+- (instancetype)initWithPoint:(GQTPoint)point {
+  if ((self = [super init])) {
+    _point = point;
+  }
+  return self;
+}
+
+- (GQTPoint)point {
+  return _point;
+}
+
+@end
+
+@interface GQTPointQuadTreeBenchmarks : XCTestCase
+@end
+
+@implementation GQTPointQuadTreeBenchmarks
+
+- (void)setUp {
+  [super setUp];
+  NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+  XCTSkipUnless(environment[kGQTRunBenchmarksKey] != nil, @"Set %@ to run the benchmarks.",
+                kGQTRunBenchmarksKey);
+  self.executionTimeAllowance = 24 * 60 * 60;
+}
+
+// Builds and searches trees for every combination of kGQTSweepLeafCapacities, kGQTSweepMaxDepths
+// and adaptive splitting on uniform, clustered and coincident data, to pick the split policy for a
+// data set.
+- (void)testSplitPolicySweep {
+  NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+  long seed = kGQTDefaultSeed;
+  if (environment[kGQTSeedKey] != nil) {
+    seed = (long)strtoull(environment[kGQTSeedKey].UTF8String, NULL, 10);
+  }
+  srand48(seed);
+  GQTBounds *searchBounds = malloc(kGQTSearchCount * sizeof(GQTBounds));
+  for (NSUInteger i = 0; i < kGQTSearchCount; ++i) {
+    double x = drand48() * (2 - kGQTSearchSize) - 1;
+    double y = drand48() * (2 - kGQTSearchSize) - 1;
+    searchBounds[i] = (GQTBounds){x, y, x + kGQTSearchSize, y + kGQTSearchSize};
+  }
+  NSDictionary<NSString *, NSNumber *> *distributions = @{
+    @"uniform" : @(GQTBenchmarkDistributionUniform),
+    @"clustered" : @(GQTBenchmarkDistributionClustered),
+    @"coincident" : @(GQTBenchmarkDistributionCoincident),
+  };
+
+  NSMutableArray<NSDictionary *> *results = [[NSMutableArray alloc] init];
+  NSUInteger capacityCount = sizeof(kGQTSweepLeafCapacities) / sizeof(kGQTSweepLeafCapacities[0]);
+  NSUInteger depthCount = sizeof(kGQTSweepMaxDepths) / sizeof(kGQTSweepMaxDepths[0]);
+  for (NSString *name in [distributions.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+    NSArray<GQTSplitPolicyBenchmarkItem *> *items =
+        [self itemsWithCount:kGQTItemCount
+                distribution:(GQTBenchmarkDistribution)distributions[name].integerValue];
+    for (NSUInteger c = 0; c < capacityCount; ++c) {
+      for (NSUInteger d = 0; d < depthCount; ++d) {
+        for (int adaptive = 0; adaptive < 2; ++adaptive) {
+          @autoreleasepool {
+            GQTPointQuadTree *tree =
+                [[GQTPointQuadTree alloc] initWithBounds:kGQTTreeBounds
+                                            leafCapacity:kGQTSweepLeafCapacities[c]
+                                                maxDepth:kGQTSweepMaxDepths[d]
+                                                adaptive:adaptive
+                                         keepsAggregates:NO];
+            uint64_t start = GQTNow();
+            for (GQTSplitPolicyBenchmarkItem *item in items) {
+              [tree add:item];
+            }
+            double insertSeconds = GQTSecondsSince(start);
+            start = GQTNow();
+            NSUInteger found = 0;
+            for (NSUInteger i = 0; i < kGQTSearchCount; ++i) {
+              found += [tree countInBounds:searchBounds[i]];
+            }
+            double searchSeconds = GQTSecondsSince(start);
+            XCTAssertEqual(tree.count, kGQTItemCount);
+            [results addObject:@{
+              @"dataset" : name,
+              @"itemCount" : @(kGQTItemCount),
+              @"leafCapacity" : @(tree.leafCapacity),
+              @"maxDepth" : @(tree.maxDepth),
+              @"adaptive" : @(adaptive != 0),
+              @"insertSeconds" : @(insertSeconds),
+              @"searchCount" : @(kGQTSearchCount),
+              @"searchSeconds" : @(searchSeconds),
+              @"foundCount" : @(found)
+            }];
+          }
+        }
+      }
+    }
+  }
+  free(searchBounds);
+
+  NSDictionary *report = @{@"seed" : @(seed), @"results" : results};
+  NSError *error;
+  NSData *json = [NSJSONSerialization dataWithJSONObject:report
+                                                 options:NSJSONWritingPrettyPrinted |
+                                                         NSJSONWritingSortedKeys
+                                                   error:&error];
+  XCTAssertNotNil(json, @"%@", error);
+  NSString *outputPath = environment[kGQTOutputKey];
+  if (outputPath == nil) {
+    outputPath =
+        [NSTemporaryDirectory() stringByAppendingPathComponent:@"gmu_quad_tree_benchmarks.json"];
+  }
+  XCTAssertTrue([json writeToFile:outputPath atomically:YES], @"Can't write %@", outputPath);
+  NSLog(@"Wrote quad tree benchmark results to %@", outputPath);
+  XCTAttachment *attachment = [XCTAttachment attachmentWithData:json
+                                          uniformTypeIdentifier:@"public.json"];
+  attachment.name = outputPath.lastPathComponent;
+  attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+  [self addAttachment:attachment];
+}
+
+#pragma mark Private
+
+- (NSArray<GQTSplitPolicyBenchmarkItem *> *)itemsWithCount:(NSUInteger)count
+                                              distribution:(GQTBenchmarkDistribution)distribution {
+  NSMutableArray<GQTSplitPolicyBenchmarkItem *> *items =
+      [[NSMutableArray alloc] initWithCapacity:count];
+  for (NSUInteger i = 0; i < count; ++i) {
+    GQTPoint point;
+    if (distribution == GQTBenchmarkDistributionUniform) {
+      point = (GQTPoint){drand48() * 2 - 1, drand48() * 2 - 1};
+    } else if (distribution == GQTBenchmarkDistributionClustered) {
+      double hotspot = (double)(i % 4) / 2 - 1;
+      point = (GQTPoint){hotspot + drand48() * 0.002, -hotspot - drand48() * 0.002};
+    } else {
+      point = (GQTPoint){(double)(i % 10) / 5 - 0.9, (double)(i / 10 % 10) / 5 - 0.9};
+    }
+    [items addObject:[[GQTSplitPolicyBenchmarkItem alloc] initWithPoint:point]];
+  }
+  return items;
+}
+
+@end
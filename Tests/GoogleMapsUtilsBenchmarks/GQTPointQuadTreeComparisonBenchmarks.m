@@ -0,0 +1,250 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import <XCTest/XCTest.h>
+
+#import "GQTBounds.h"
+#import "GQTPoint.h"
+#import "GQTPointQuadTree.h"
+#import "GQTPointQuadTreeChild.h"
+#import "GQTPointQuadTreeItem.h"
+
+// The benchmarks only run when GMU_RUN_BENCHMARKS is set in the environment of the test process.
+static NSString *const kGQTRunBenchmarksKey = @"GMU_RUN_BENCHMARKS";
+
+static const NSUInteger kItemCount = 100000;
+static const NSUInteger kInsertCount = 10000;
+static const NSUInteger kSearchCount = 1000;
+static const double kSearchSize = 0.05;
+static const GQTBounds kTreeBounds = {-1, -1, 1, 1};
+
+// Quad tree item with a fixed point. OCMock items are too slow to benchmark with.
+@interface GQTComparisonBenchmarkItem : NSObject<GQTPointQuadTreeItem>
+
+- (instancetype)initWithPoint:(GQTPoint)point identifier:(NSUInteger)identifier;
+
+@property(nonatomic, readonly) NSUInteger identifier;
+
+@end
+
+@implementation GQTComparisonBenchmarkItem {
+  GQTPoint _point;
+}
+
+- (instancetype)initWithPoint:(GQTPoint)point identifier:(NSUInteger)identifier {
+  if ((self = [super init])) {
+    _point = point;
+    _identifier = identifier;
+  }
+  return self;
+}
+
+- (GQTPoint)point {
+  return _point;
+}
+
+@end
+
+/**
+ * Compares GQTPointQuadTree against the object-per-node GQTPointQuadTreeChild implementation it
+ * replaced. Half of the items are uniformly distributed, the other half are packed into a few
+ * dense hotspots which is typical for clustering data.
+ */
+@interface GQTPointQuadTreeComparisonBenchmarks : XCTestCase
+@end
+
+@implementation GQTPointQuadTreeComparisonBenchmarks {
+  NSArray<GQTComparisonBenchmarkItem *> *_items;
+  NSArray<GQTComparisonBenchmarkItem *> *_insertedItems;
+  GQTBounds *_searchBounds;
+}
+
+- (void)setUp {
+  [super setUp];
+  NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+  XCTSkipUnless(environment[kGQTRunBenchmarksKey] != nil, @"Set %@ to run the benchmarks.",
+                kGQTRunBenchmarksKey);
+  srand48(42);
+  _items = [self randomItemsWithCount:kItemCount];
+  _insertedItems = [self randomItemsWithCount:kInsertCount];
+  _searchBounds = malloc(kSearchCount * sizeof(GQTBounds));
+  for (NSUInteger i = 0; i < kSearchCount; ++i) {
+    double x = drand48() * (2 - kSearchSize) - 1;
+    double y = drand48() * (2 - kSearchSize) - 1;
+    _searchBounds[i] = (GQTBounds){x, y, x + kSearchSize, y + kSearchSize};
+  }
+}
+
+- (void)tearDown {
+  free(_searchBounds);
+  [super tearDown];
+}
+
+#pragma mark GQTPointQuadTree
+
+- (void)testBuildPerformance {
+  [self measureBlock:^{
+    GQTPointQuadTree *tree = [self treeWithItems:self->_items];
+    XCTAssertEqual(tree.count, kItemCount);
+  }];
+}
+
+- (void)testBulkBuildPerformance {
+  [self measureBlock:^{
+    GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithBounds:kTreeBounds
+                                                                items:self->_items];
+    XCTAssertEqual(tree.count, kItemCount);
+  }];
+}
+
+- (void)testLoadPerformance {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithBounds:kTreeBounds items:_items];
+  NSURL *url = [NSURL fileURLWithPath:[NSTemporaryDirectory()
+                                          stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+  NSArray<GQTComparisonBenchmarkItem *> *items = _items;
+  XCTAssertTrue([tree writeToURL:url
+               identifierForItem:^uint64_t(id<GQTPointQuadTreeItem> item) {
+                 return ((GQTComparisonBenchmarkItem *)item).identifier;
+               }
+                           error:nil]);
+  [self measureBlock:^{
+    GQTPointQuadTree *loadedTree =
+        [[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                      itemForIdentifier:^(uint64_t identifier) {
+                                        return (id<GQTPointQuadTreeItem>)items[identifier];
+                                      }
+                                                  error:nil];
+    XCTAssertEqual(loadedTree.count, kItemCount);
+  }];
+  [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+}
+
+- (void)testInsertPerformance {
+  GQTPointQuadTree *tree = [self treeWithItems:_items];
+  [self measureMetrics:[[self class] defaultPerformanceMetrics]
+      automaticallyStartMeasuring:NO
+                         forBlock:^{
+                           [self startMeasuring];
+                           for (GQTComparisonBenchmarkItem *item in self->_insertedItems) {
+                             [tree add:item];
+                           }
+                           [self stopMeasuring];
+                           for (GQTComparisonBenchmarkItem *item in self->_insertedItems) {
+                             [tree remove:item];
+                           }
+                         }];
+}
+
+- (void)testSearchPerformance {
+  GQTPointQuadTree *tree = [self treeWithItems:_items];
+  [self measureBlock:^{
+    NSUInteger found = 0;
+    for (NSUInteger i = 0; i < kSearchCount; ++i) {
+      found += [tree searchWithBounds:self->_searchBounds[i]].count;
+    }
+    XCTAssertGreaterThan(found, 0);
+  }];
+}
+
+- (void)testBatchSearchPerformance {
+  GQTPointQuadTree *tree = [self treeWithItems:_items];
+  [self measureBlock:^{
+    NSUInteger found = 0;
+    for (NSArray *results in [tree searchWithBoundsArray:self->_searchBounds
+                                                    count:kSearchCount]) {
+      found += results.count;
+    }
+    XCTAssertGreaterThan(found, 0);
+  }];
+}
+
+#pragma mark Reference implementation
+
+- (void)testReferenceBuildPerformance {
+  [self measureBlock:^{
+    GQTPointQuadTreeChild *root = [self referenceTreeWithItems:self->_items];
+    XCTAssertNotNil(root);
+  }];
+}
+
+- (void)testReferenceInsertPerformance {
+  GQTPointQuadTreeChild *root = [self referenceTreeWithItems:_items];
+  [self measureMetrics:[[self class] defaultPerformanceMetrics]
+      automaticallyStartMeasuring:NO
+                         forBlock:^{
+                           [self startMeasuring];
+                           for (GQTComparisonBenchmarkItem *item in self->_insertedItems) {
+                             [root add:item withOwnBounds:kTreeBounds atDepth:0];
+                           }
+                           [self stopMeasuring];
+                           for (GQTComparisonBenchmarkItem *item in self->_insertedItems) {
+                             [root remove:item withOwnBounds:kTreeBounds];
+                           }
+                         }];
+}
+
+- (void)testReferenceSearchPerformance {
+  GQTPointQuadTreeChild *root = [self referenceTreeWithItems:_items];
+  [self measureBlock:^{
+    NSUInteger found = 0;
+    for (NSUInteger i = 0; i < kSearchCount; ++i) {
+      NSMutableArray *results = [NSMutableArray array];
+      [root searchWithBounds:self->_searchBounds[i] withOwnBounds:kTreeBounds results:results];
+      found += results.count;
+    }
+    XCTAssertGreaterThan(found, 0);
+  }];
+}
+
+#pragma mark Utilities
+
+- (GQTPointQuadTree *)treeWithItems:(NSArray<GQTComparisonBenchmarkItem *> *)items {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithBounds:kTreeBounds];
+  for (GQTComparisonBenchmarkItem *item in items) {
+    [tree add:item];
+  }
+  return tree;
+}
+
+- (GQTPointQuadTreeChild *)referenceTreeWithItems:(NSArray<GQTComparisonBenchmarkItem *> *)items {
+  GQTPointQuadTreeChild *root = [[GQTPointQuadTreeChild alloc] init];
+  for (GQTComparisonBenchmarkItem *item in items) {
+    [root add:item withOwnBounds:kTreeBounds atDepth:0];
+  }
+  return root;
+}
+
+- (NSArray<GQTComparisonBenchmarkItem *> *)randomItemsWithCount:(NSUInteger)count {
+  NSMutableArray<GQTComparisonBenchmarkItem *> *items =
+      [[NSMutableArray alloc] initWithCapacity:count];
+  for (NSUInteger i = 0; i < count; ++i) {
+    GQTPoint point;
+    if (i % 2 == 0) {
+      point = (GQTPoint){drand48() * 2 - 1, drand48() * 2 - 1};
+    } else {
+      // One of four hotspots, each about 0.002 units wide.
+      double hotspot = (double)(i % 8) / 4 - 1;
+      point = (GQTPoint){hotspot + drand48() * 0.002, -hotspot - drand48() * 0.002};
+    }
+    [items addObject:[[GQTComparisonBenchmarkItem alloc] initWithPoint:point identifier:i]];
+  }
+  return items;
+}
+
+@end
@@ -0,0 +1,193 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUCachingClusterAlgorithm.h"
+#import "GMUStaticCluster.h"
+#import <OCMock/OCMock.h>
+#import <XCTest/XCTest.h>
+
+@interface GMUCachingClusterAlgorithmTest : XCTestCase
+@end
+
+static const CLLocationCoordinate2D kClusterPosition = {-35, 151};
+
+@implementation GMUCachingClusterAlgorithmTest {
+  id _algorithm;
+}
+
+- (void)setUp {
+  [super setUp];
+  _algorithm = OCMProtocolMock(@protocol(GMUClusterAlgorithm));
+}
+
+- (void)testClustersAtZoomSecondCallReturnsCachedClusters {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm];
+  NSArray<id<GMUCluster>> *clusters = [self clustersOfCount:2];
+  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:10];
+
+  // Act.
+  NSArray<id<GMUCluster>> *firstClusters = [cachingAlgorithm clustersAtZoom:10];
+  NSArray<id<GMUCluster>> *secondClusters = [cachingAlgorithm clustersAtZoom:10];
+
+  // Assert.
+  XCTAssertEqualObjects(firstClusters, clusters);
+  XCTAssertEqualObjects(secondClusters, clusters);
+  XCTAssertEqual(cachingAlgorithm.cachedClusterCount, 2);
+  [_algorithm verify];
+}
+
+- (void)testClustersAtZoomAfterAddingItemsClustersAgain {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm];
+  NSArray<id<GMUCluster>> *clusters = [self clustersOfCount:1];
+  NSArray<id<GMUCluster>> *newClusters = [self clustersOfCount:2];
+  id<GMUClusterItem> item = OCMProtocolMock(@protocol(GMUClusterItem));
+  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:10];
+  [[_algorithm expect] addItems:@[ item ]];
+  [[[_algorithm expect] andReturn:newClusters] clustersAtZoom:10];
+
+  // Act.
+  [cachingAlgorithm clustersAtZoom:10];
+  [cachingAlgorithm addItems:@[ item ]];
+  NSArray<id<GMUCluster>> *result = [cachingAlgorithm clustersAtZoom:10];
+
+  // Assert.
+  XCTAssertEqualObjects(result, newClusters);
+  [_algorithm verify];
+}
+
+- (void)testClustersAtZoomAfterRemovingAndClearingItemsClustersAgain {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm];
+  id<GMUClusterItem> item = OCMProtocolMock(@protocol(GMUClusterItem));
+  [[[_algorithm expect] andReturn:[self clustersOfCount:1]] clustersAtZoom:10];
+  [[_algorithm expect] removeItem:item];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:1]] clustersAtZoom:10];
+  [[_algorithm expect] clearItems];
+  [[[_algorithm expect] andReturn:@[]] clustersAtZoom:10];
+
+  // Act.
+  [cachingAlgorithm clustersAtZoom:10];
+  [cachingAlgorithm removeItem:item];
+  [cachingAlgorithm clustersAtZoom:10];
+  [cachingAlgorithm clearItems];
+  [cachingAlgorithm clustersAtZoom:10];
+
+  // Assert.
+  XCTAssertEqual(cachingAlgorithm.cachedClusterCount, 0);
+  [_algorithm verify];
+}
+
+- (void)testClustersAtZoomForgetsLeastRecentlyUsedZoomBeyondBound {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm maxCachedClusterCount:5];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:2]] clustersAtZoom:10];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:2]] clustersAtZoom:11];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:3]] clustersAtZoom:12];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:2]] clustersAtZoom:11];
+
+  // Act.
+  [cachingAlgorithm clustersAtZoom:10];
+  [cachingAlgorithm clustersAtZoom:11];
+  [cachingAlgorithm clustersAtZoom:10];
+  [cachingAlgorithm clustersAtZoom:12];
+  [cachingAlgorithm clustersAtZoom:10];
+  [cachingAlgorithm clustersAtZoom:11];
+
+  // Assert.
+  XCTAssertEqual(cachingAlgorithm.cachedClusterCount, 4);
+  [_algorithm verify];
+}
+
+- (void)testClustersAtZoomInBoundsReusesClustersOfEnclosingBounds {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm];
+  // At map points x = 0, 0.2 and 0.4 on the equator.
+  NSArray<id<GMUCluster>> *clusters =
+      @[ [self clusterAtLongitude:0], [self clusterAtLongitude:36], [self clusterAtLongitude:72] ];
+  NSArray<id<GMUCluster>> *otherClusters = [self clustersOfCount:1];
+  GQTBounds bounds = {-0.5, -0.5, 0.5, 0.5};
+  GQTBounds innerBounds = {-0.25, -0.25, 0.25, 0.25};
+  GQTBounds otherBounds = {0.25, 0.25, 0.75, 0.75};
+  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:10 inBounds:bounds];
+  [[[_algorithm expect] andReturn:otherClusters] clustersAtZoom:10 inBounds:otherBounds];
+
+  // Act.
+  [cachingAlgorithm clustersAtZoom:10 inBounds:bounds];
+  NSArray<id<GMUCluster>> *innerClusters = [cachingAlgorithm clustersAtZoom:10
+                                                                   inBounds:innerBounds];
+  NSArray<id<GMUCluster>> *result = [cachingAlgorithm clustersAtZoom:10 inBounds:otherBounds];
+
+  // Assert.
+  XCTAssertEqualObjects(innerClusters, [clusters subarrayWithRange:NSMakeRange(0, 2)]);
+  XCTAssertEqualObjects(result, otherClusters);
+  XCTAssertEqualObjects([cachingAlgorithm clustersAtZoom:10 inBounds:otherBounds], otherClusters);
+  [_algorithm verify];
+}
+
+- (void)testClustersAtZoomInBoundsFiltersCachedClustersAcrossAntimeridian {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm];
+  // At map points x = 0.6, 0.9 and -0.9 on the equator.
+  NSArray<id<GMUCluster>> *clusters = @[
+    [self clusterAtLongitude:108], [self clusterAtLongitude:162], [self clusterAtLongitude:-162]
+  ];
+  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:10];
+
+  // Act.
+  [cachingAlgorithm clustersAtZoom:10];
+  NSArray<id<GMUCluster>> *result =
+      [cachingAlgorithm clustersAtZoom:10 inBounds:(GQTBounds){0.75, -0.25, 1.25, 0.25}];
+
+  // Assert.
+  XCTAssertEqualObjects(result, [clusters subarrayWithRange:NSMakeRange(1, 2)]);
+  [_algorithm verify];
+}
+
+- (void)testClustersAtNonIntegralZoomAreNotCached {
+  GMUCachingClusterAlgorithm *cachingAlgorithm =
+      [[GMUCachingClusterAlgorithm alloc] initWithAlgorithm:_algorithm];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:1]] clustersAtZoom:10.5];
+  [[[_algorithm expect] andReturn:[self clustersOfCount:1]] clustersAtZoom:10.5];
+
+  // Act.
+  [cachingAlgorithm clustersAtZoom:10.5];
+  [cachingAlgorithm clustersAtZoom:10.5];
+
+  // Assert.
+  XCTAssertEqual(cachingAlgorithm.cachedClusterCount, 0);
+  [_algorithm verify];
+}
+
+#pragma mark Private
+
+- (NSArray<id<GMUCluster>> *)clustersOfCount:(NSUInteger)count {
+  NSMutableArray<id<GMUCluster>> *clusters = [[NSMutableArray alloc] init];
+  for (NSUInteger i = 0; i < count; ++i) {
+    [clusters addObject:[[GMUStaticCluster alloc] initWithPosition:kClusterPosition]];
+  }
+  return clusters;
+}
+
+- (id<GMUCluster>)clusterAtLongitude:(double)longitude {
+  return [[GMUStaticCluster alloc] initWithPosition:CLLocationCoordinate2DMake(0, longitude)];
+}
+
+@end
@@ -17,7 +17,9 @@
 
 @import GoogleMaps;
 #import "GMUCluster.h"
+#import "GMUClusterAggregate.h"
 #import "GMUClusterItem.h"
+#import "GQTBounds.h"
 
 @protocol GMUCluster;
 
@@ -38,6 +40,11 @@
                                                 zoom:(double)zoom
                                               radius:(double)screenPoints;
 
+// Returns the bounds in map points from |southWest| to |northEast|, going east across the
+// antimeridian if needed.
+- (GQTBounds)boundsFromLocation:(CLLocationCoordinate2D)southWest
+                     toLocation:(CLLocationCoordinate2D)northEast;
+
 // Sum of all clusters' item counts.
 - (NSUInteger)totalItemCountsForClusters:(NSArray<id<GMUCluster>> *)clusters;
 
@@ -54,5 +61,20 @@
 // Randomly generates a number of items around fixed centroids.
 - (NSArray<id<GMUClusterItem>> *)randomizedClusterItems;
 
+// Randomly generates items around fixed centroids, half of each of categories "a" and "b".
+- (NSArray<id<GMUClusterItem>> *)categorizedClusterItems;
+
+// Asserts that all items of each cluster in |clusters| are of the category of the cluster.
+- (void)assertClustersMatchItemCategories:(NSArray<id<GMUCluster>> *)clusters;
+
+// Randomly generates items around fixed centroids, with a weight for all but every fifth item.
+- (NSArray<id<GMUClusterItem>> *)weightedClusterItems;
+
+// Returns aggregates named "sum", "min", "max" and "mean" over the weight of items.
+- (NSArray<GMUClusterAggregate *> *)weightAggregates;
+
+// Asserts that the values of weightAggregates of each cluster in |clusters| match its items.
+- (void)assertClustersMatchItemWeights:(NSArray<id<GMUCluster>> *)clusters;
+
 @end
 
@@ -51,6 +51,14 @@ static double randd(void) { return (((double)arc4random() / 0x100000000) * 1.0);
   return items;
 }
 
+- (GQTBounds)boundsFromLocation:(CLLocationCoordinate2D)southWest
+                     toLocation:(CLLocationCoordinate2D)northEast {
+  GMSMapPoint point1 = GMSProject(southWest);
+  GMSMapPoint point2 = GMSProject(northEast);
+  double maxX = point2.x < point1.x ? point2.x + 2 : point2.x;
+  return (GQTBounds){point1.x, MIN(point1.y, point2.y), maxX, MAX(point1.y, point2.y)};
+}
+
 - (void)shuffleMutableArray:(NSMutableArray *)array {
   for (u_int32_t i = 0; i < array.count; ++i) {
     u_int32_t randomIndex = arc4random_uniform((u_int32_t)array.count);
@@ -83,6 +91,41 @@ static double randd(void) { return (((double)arc4random() / 0x100000000) * 1.0);
   }
 }
 
+- (void)assertClustersMatchItemCategories:(NSArray<id<GMUCluster>> *)clusters {
+  for (id<GMUCluster> cluster in clusters) {
+    XCTAssertNotNil(cluster.clusterCategory);
+    for (GMUTestClusterItem *item in cluster.items) {
+      XCTAssertEqualObjects(item.clusterCategory, cluster.clusterCategory);
+    }
+  }
+}
+
+- (void)assertClustersMatchItemWeights:(NSArray<id<GMUCluster>> *)clusters {
+  for (id<GMUCluster> cluster in clusters) {
+    double sum = 0;
+    double min = INFINITY;
+    double max = -INFINITY;
+    NSUInteger count = 0;
+    for (GMUTestClusterItem *item in cluster.items) {
+      if (!item.weight) continue;
+      double weight = item.weight.doubleValue;
+      sum += weight;
+      min = MIN(min, weight);
+      max = MAX(max, weight);
+      ++count;
+    }
+    NSDictionary<NSString *, NSNumber *> *values = cluster.aggregateValues;
+    if (count == 0) {
+      XCTAssertEqual(values.count, 0);
+      continue;
+    }
+    XCTAssertEqualWithAccuracy(values[@"sum"].doubleValue, sum, 1e-9);
+    XCTAssertEqual(values[@"min"].doubleValue, min);
+    XCTAssertEqual(values[@"max"].doubleValue, max);
+    XCTAssertEqualWithAccuracy(values[@"mean"].doubleValue, sum / count, 1e-9);
+  }
+}
+
 #pragma mark Fixtures
 
 - (NSArray<id<GMUClusterItem>> *)simpleClusterItems {
@@ -118,5 +161,50 @@ static double randd(void) { return (((double)arc4random() / 0x100000000) * 1.0);
   return items;
 }
 
-@end
+- (NSArray<id<GMUClusterItem>> *)categorizedClusterItems {
+  NSMutableArray<id<GMUClusterItem>> *items = [[NSMutableArray<id<GMUClusterItem>> alloc] init];
+  CLLocationCoordinate2D locations[] = {kLocation1, kLocation2, kLocation3, kLocation4};
+  for (int i = 0; i < 4; ++i) {
+    NSArray<id<GMUClusterItem>> *locationItems =
+        [self itemsAroundLocation:locations[i] count:10 zoom:10.0 radius:50.0];
+    for (NSUInteger j = 0; j < locationItems.count; ++j) {
+      GMUTestClusterItem *item = (GMUTestClusterItem *)locationItems[j];
+      item.clusterCategory = j % 2 == 0 ? @"a" : @"b";
+    }
+    [items addObjectsFromArray:locationItems];
+  }
 
+  [self shuffleMutableArray:items];
+  return items;
+}
+
+- (NSArray<id<GMUClusterItem>> *)weightedClusterItems {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  for (NSUInteger i = 0; i < items.count; ++i) {
+    if (i % 5 == 4) continue;
+    ((GMUTestClusterItem *)items[i]).weight = @(i + 0.5);
+  }
+  return items;
+}
+
+- (NSArray<GMUClusterAggregate *> *)weightAggregates {
+  return @[
+    [[GMUClusterAggregate alloc] initWithName:@"sum"
+                                     function:GMUClusterAggregateFunctionSum
+                                      keyPath:@"weight"],
+    [[GMUClusterAggregate alloc] initWithName:@"min"
+                                     function:GMUClusterAggregateFunctionMin
+                                      keyPath:@"weight"],
+    [[GMUClusterAggregate alloc] initWithName:@"max"
+                                     function:GMUClusterAggregateFunctionMax
+                                   valueBlock:^double(id<GMUClusterItem> item) {
+                                     NSNumber *weight = ((GMUTestClusterItem *)item).weight;
+                                     return weight ? weight.doubleValue : NAN;
+                                   }],
+    [[GMUClusterAggregate alloc] initWithName:@"mean"
+                                     function:GMUClusterAggregateFunctionMean
+                                      keyPath:@"weight"],
+  ];
+}
+
+@end
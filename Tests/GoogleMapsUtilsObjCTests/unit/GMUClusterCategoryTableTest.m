@@ -0,0 +1,71 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUClusterCategoryTable.h"
+
+#import <XCTest/XCTest.h>
+
+#import "GMUTestClusterItem.h"
+
+@interface GMUClusterCategoryTableTest : XCTestCase
+@end
+
+@implementation GMUClusterCategoryTableTest
+
+- (void)testItemsWithoutCategoryAreNumberedZero {
+  GMUClusterCategoryTable *table = [[GMUClusterCategoryTable alloc] init];
+  GMUTestClusterItem *item =
+      [[GMUTestClusterItem alloc] initWithPosition:CLLocationCoordinate2DMake(0, 0)];
+
+  // Act.
+  uint32_t number = [table numberForCategoryOfItem:item];
+
+  // Assert.
+  XCTAssertEqual(number, 0);
+  XCTAssertEqual(table.count, 0);
+  XCTAssertNil([table categoryForNumber:0]);
+}
+
+- (void)testCategoriesKeepTheirNumber {
+  GMUClusterCategoryTable *table = [[GMUClusterCategoryTable alloc] init];
+  GMUTestClusterItem *item1 =
+      [[GMUTestClusterItem alloc] initWithPosition:CLLocationCoordinate2DMake(0, 0)];
+  item1.clusterCategory = @"cafe";
+  GMUTestClusterItem *item2 =
+      [[GMUTestClusterItem alloc] initWithPosition:CLLocationCoordinate2DMake(1, 1)];
+  item2.clusterCategory = @"museum";
+  GMUTestClusterItem *item3 =
+      [[GMUTestClusterItem alloc] initWithPosition:CLLocationCoordinate2DMake(2, 2)];
+  item3.clusterCategory = @"cafe";
+
+  // Act.
+  uint32_t number1 = [table numberForCategoryOfItem:item1];
+  uint32_t number2 = [table numberForCategoryOfItem:item2];
+  uint32_t number3 = [table numberForCategoryOfItem:item3];
+
+  // Assert.
+  XCTAssertEqual(number1, 1);
+  XCTAssertEqual(number2, 2);
+  XCTAssertEqual(number3, number1);
+  XCTAssertEqual(table.count, 2);
+  XCTAssertEqualObjects([table categoryForNumber:number1], @"cafe");
+  XCTAssertEqualObjects([table categoryForNumber:number2], @"museum");
+}
+
+@end
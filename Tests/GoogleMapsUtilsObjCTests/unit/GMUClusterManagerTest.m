@@ -22,11 +22,18 @@
 #import <OCMock/OCMock.h>
 #import <XCTest/XCTest.h>
 
+#import "GMUGridBasedClusterAlgorithm.h"
+#import "GMUHierarchicalDistanceBasedAlgorithm.h"
+#import "GMUNonHierarchicalDistanceBasedAlgorithm+Testing.h"
+#import "GMUStaticCluster.h"
+#import "GMUTestClusterItem.h"
+
 @interface GMUClusterManagerTest : XCTestCase
 @end
 
 static const CLLocationCoordinate2D kCameraPosition = {-35, 151};
 static const double kCameraZoom = 10.0;
+static const GQTBounds kAnyBounds = {0, 0, 0, 0};
 
 @implementation GMUClusterManagerTest {
   // Object under test.
@@ -37,6 +44,7 @@ static const double kCameraZoom = 10.0;
   id _delegate;
   id _mapDelegate;
   GMSCameraPosition *_camera;
+  GMSVisibleRegion _visibleRegion;
 }
 
 - (void)setUp {
@@ -47,6 +55,12 @@ static const double kCameraZoom = 10.0;
   [[[_mapView stub] andDo:^(NSInvocation *invocation) {
     [invocation setReturnValue:&self->_camera];
   }] camera];
+  _visibleRegion = [self visibleRegionAroundPosition:kCameraPosition];
+  id projection = OCMClassMock([GMSProjection class]);
+  [[[projection stub] andDo:^(NSInvocation *invocation) {
+    [invocation setReturnValue:&self->_visibleRegion];
+  }] visibleRegion];
+  [[[_mapView stub] andReturn:projection] projection];
 
   _algorithm = OCMProtocolMock(@protocol(GMUClusterAlgorithm));
   _renderer = OCMProtocolMock(@protocol(GMUClusterRenderer));
@@ -126,16 +140,280 @@ static const double kCameraZoom = 10.0;
 
 - (void)testCluster {
   NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
-  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:kCameraZoom];
+  [[[[_algorithm expect] ignoringNonObjectArgs] andReturn:clusters] clustersAtZoom:kCameraZoom
+                                                                           inBounds:kAnyBounds];
   [[_renderer expect] renderClusters:clusters];
 
   [_clusterManager cluster];
 }
 
+- (void)testClusterLimitsAlgorithmToPaddedVisibleRegion {
+  NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
+  __block GQTBounds bounds;
+  [[[[[_algorithm expect] ignoringNonObjectArgs] andDo:^(NSInvocation *invocation) {
+    [invocation getArgument:&bounds atIndex:3];
+  }] andReturn:clusters] clustersAtZoom:kCameraZoom inBounds:kAnyBounds];
+  [[_renderer expect] renderClusters:clusters];
+
+  // Act.
+  [_clusterManager cluster];
+
+  // Assert: the bounds are twice as wide and high as the visible region.
+  GMSMapPoint nearLeft = GMSProject(_visibleRegion.nearLeft);
+  GMSMapPoint farRight = GMSProject(_visibleRegion.farRight);
+  double width = farRight.x - nearLeft.x;
+  double height = fabs(farRight.y - nearLeft.y);
+  XCTAssertEqualWithAccuracy(bounds.minX, nearLeft.x - width / 2, 1e-9);
+  XCTAssertEqualWithAccuracy(bounds.maxX, farRight.x + width / 2, 1e-9);
+  XCTAssertEqualWithAccuracy(bounds.maxY - bounds.minY, height * 2, 1e-9);
+}
+
+- (void)testCameraPannedOutOfClusteredRegionReclusterRequested {
+  // Arrange.
+  NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
+  [[[[_algorithm expect] ignoringNonObjectArgs] andReturn:clusters] clustersAtZoom:kCameraZoom
+                                                                           inBounds:kAnyBounds];
+  [[_renderer expect] renderClusters:clusters];
+  // Intial cluster.
+  [_clusterManager cluster];
+
+  // Act.
+  CLLocationCoordinate2D position =
+      CLLocationCoordinate2DMake(kCameraPosition.latitude, kCameraPosition.longitude + 10);
+  _visibleRegion = [self visibleRegionAroundPosition:position];
+  [_clusterManager observeValueForKeyPath:@"camera" ofObject:_mapView change:nil context:nil];
+  XCTAssertEqual([_clusterManager clusterRequestCount], 1);
+}
+
+- (void)testClusterAsynchronouslyWithParallelAlgorithmClustersOnAllCores {
+  // Arrange.
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  algorithm.parallel = YES;
+  id partialAlgorithm = OCMPartialMock(algorithm);
+  _clusterManager = [[GMUClusterManager alloc] initWithMap:_mapView
+                                                 algorithm:partialAlgorithm
+                                                  renderer:_renderer];
+  _clusterManager.asynchronous = YES;
+  id<GMUClusterItem> item = [[GMUTestClusterItem alloc] initWithPosition:kCameraPosition];
+  [_clusterManager addItem:item];
+  [[[[partialAlgorithm expect] ignoringNonObjectArgs] andForwardToRealObject]
+      parallelClustersAtZoom:kCameraZoom
+                    inBounds:kAnyBounds
+           cancellationToken:OCMOCK_ANY];
+  XCTestExpectation *rendered = [self expectationWithDescription:@"Clusters rendered"];
+  [[[_renderer expect] andDo:^(NSInvocation *invocation) {
+    [rendered fulfill];
+  }] renderClusters:[OCMArg checkWithBlock:^BOOL(NSArray *clusters) {
+    return clusters.count == 1 && [clusters[0] items][0] == item;
+  }]];
+
+  // Act.
+  [_clusterManager cluster];
+
+  // Assert.
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+  OCMVerifyAll(partialAlgorithm);
+}
+
+- (void)testClusterAtSameZoomWithIncrementalAlgorithmRendersDelta {
+  id algorithm = OCMProtocolMock(@protocol(GMUIncrementalClusterAlgorithm));
+  id renderer = OCMProtocolMock(@protocol(GMUClusterRenderer));
+  _clusterManager =
+      [[GMUClusterManager alloc] initWithMap:_mapView algorithm:algorithm renderer:renderer];
+  NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
+  GMUClusterDelta *delta =
+      [[GMUClusterDelta alloc] initWithZoom:kCameraZoom
+                              addedClusters:@[ OCMProtocolMock(@protocol(GMUCluster)) ]
+                            removedClusters:@[]
+                            changedClusters:clusters];
+  [[[algorithm stub] andReturn:delta] clusterDeltaAtZoom:kCameraZoom];
+  [[[algorithm stub] andReturn:clusters] clustersAtZoom:kCameraZoom];
+  __block NSUInteger renderCount = 0;
+  [[[renderer stub] andDo:^(NSInvocation *invocation) {
+    ++renderCount;
+  }] renderClusters:clusters];
+
+  // Act.
+  [_clusterManager cluster];
+  [_clusterManager cluster];
+
+  // Assert: all clusters are rendered once, then only the delta.
+  XCTAssertEqual(renderCount, 1);
+  [[renderer verify] renderClusterDelta:delta];
+}
+
+- (void)testClusterAsynchronouslyRendersClustersOnMainThread {
+  // Arrange.
+  _clusterManager.asynchronous = YES;
+  id item1 = OCMProtocolMock(@protocol(GMUClusterItem));
+  NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
+  __block BOOL addedBeforeClustering = NO;
+  [[[_algorithm expect] andDo:^(NSInvocation *invocation) {
+    XCTAssertFalse([NSThread isMainThread]);
+    addedBeforeClustering = YES;
+  }] addItems:@[ item1 ]];
+  [[[[[_algorithm expect] ignoringNonObjectArgs] andDo:^(NSInvocation *invocation) {
+    XCTAssertFalse([NSThread isMainThread]);
+    XCTAssertTrue(addedBeforeClustering);
+  }] andReturn:clusters] clustersAtZoom:kCameraZoom
+                                inBounds:kAnyBounds
+                       cancellationToken:OCMOCK_ANY];
+  XCTestExpectation *rendered = [self expectationWithDescription:@"Clusters rendered"];
+  [[[_renderer expect] andDo:^(NSInvocation *invocation) {
+    XCTAssertTrue([NSThread isMainThread]);
+    [rendered fulfill];
+  }] renderClusters:clusters];
+
+  // Act.
+  [_clusterManager addItem:item1];
+  [_clusterManager cluster];
+
+  // Assert.
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testClusterStreamingRendersClustersNearestToViewportFirst {
+  // Arrange.
+  _clusterManager.asynchronous = YES;
+  _clusterManager.streaming = YES;
+  GMUStaticCluster *visibleCluster = [[GMUStaticCluster alloc] initWithPosition:kCameraPosition];
+  GMUStaticCluster *nearbyCluster = [[GMUStaticCluster alloc]
+      initWithPosition:CLLocationCoordinate2DMake(kCameraPosition.latitude,
+                                                  kCameraPosition.longitude + 1.5)];
+  GMUStaticCluster *farCluster =
+      [[GMUStaticCluster alloc] initWithPosition:CLLocationCoordinate2DMake(0, 0)];
+  // Without exact clusters within bounds, the clusters of the whole world are computed once.
+  [[[[_algorithm expect] ignoringNonObjectArgs]
+      andReturn:@[ farCluster, nearbyCluster, visibleCluster ]] clustersAtZoom:kCameraZoom
+                                                                      inBounds:kAnyBounds
+                                                             cancellationToken:OCMOCK_ANY];
+  XCTestExpectation *rendered = [self expectationWithDescription:@"All clusters rendered"];
+  [_renderer setExpectationOrderMatters:YES];
+  [[_renderer expect] renderClusters:@[ visibleCluster ]];
+  [[_renderer expect] renderClusterDelta:[OCMArg checkWithBlock:^BOOL(GMUClusterDelta *delta) {
+                        return [delta.addedClusters isEqualToArray:@[ nearbyCluster ]] &&
+                               delta.removedClusters.count == 0;
+                      }]];
+  [[[_renderer expect] andDo:^(NSInvocation *invocation) {
+    [rendered fulfill];
+  }] renderClusterDelta:[OCMArg checkWithBlock:^BOOL(GMUClusterDelta *delta) {
+    return [delta.addedClusters isEqualToArray:@[ farCluster ]] &&
+           delta.removedClusters.count == 0;
+  }]];
+
+  // Act.
+  [_clusterManager cluster];
+
+  // Assert.
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testClusterStreamingWithGridAlgorithmRendersEveryItemExactlyOnce {
+  [self assertStreamingRendersEveryItemExactlyOnceWithAlgorithm:
+            [[GMUGridBasedClusterAlgorithm alloc] init]];
+}
+
+- (void)testClusterStreamingWithHierarchicalAlgorithmRendersEveryItemExactlyOnce {
+  [self assertStreamingRendersEveryItemExactlyOnceWithAlgorithm:
+            [[GMUHierarchicalDistanceBasedAlgorithm alloc] init]];
+}
+
+- (void)testClusterStreamingWithExactClustersInBoundsRendersVisibleClustersBeforeWorldIsClustered {
+  // Arrange.
+  _clusterManager.asynchronous = YES;
+  _clusterManager.streaming = YES;
+  [[[_algorithm stub] andReturnValue:@YES] clustersInBoundsAreExact];
+  GMUStaticCluster *visibleCluster = [[GMUStaticCluster alloc] initWithPosition:kCameraPosition];
+  GMUStaticCluster *nearbyCluster = [[GMUStaticCluster alloc]
+      initWithPosition:CLLocationCoordinate2DMake(kCameraPosition.latitude,
+                                                  kCameraPosition.longitude + 1.5)];
+  GMUStaticCluster *farCluster =
+      [[GMUStaticCluster alloc] initWithPosition:CLLocationCoordinate2DMake(0, 0)];
+  dispatch_semaphore_t visibleRendered = dispatch_semaphore_create(0);
+  // Each area is queried in turn, and its clusters include those of the previous areas.
+  [[[[_algorithm expect] ignoringNonObjectArgs] andReturn:@[ visibleCluster ]]
+         clustersAtZoom:kCameraZoom
+               inBounds:kAnyBounds
+      cancellationToken:OCMOCK_ANY];
+  [[[[_algorithm expect] ignoringNonObjectArgs]
+      andReturn:@[ nearbyCluster, visibleCluster ]] clustersAtZoom:kCameraZoom
+                                                          inBounds:kAnyBounds
+                                                 cancellationToken:OCMOCK_ANY];
+  __block BOOL renderedBeforeWorld = NO;
+  [[[[[_algorithm expect] ignoringNonObjectArgs] andDo:^(NSInvocation *invocation) {
+    dispatch_time_t timeout = dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC);
+    renderedBeforeWorld = dispatch_semaphore_wait(visibleRendered, timeout) == 0;
+  }] andReturn:@[ farCluster, nearbyCluster, visibleCluster ]] clustersAtZoom:kCameraZoom
+                                                                      inBounds:kAnyBounds
+                                                             cancellationToken:OCMOCK_ANY];
+  XCTestExpectation *rendered = [self expectationWithDescription:@"All clusters rendered"];
+  [_renderer setExpectationOrderMatters:YES];
+  [[[_renderer expect] andDo:^(NSInvocation *invocation) {
+    dispatch_semaphore_signal(visibleRendered);
+  }] renderClusters:@[ visibleCluster ]];
+  [[_renderer expect] renderClusterDelta:[OCMArg checkWithBlock:^BOOL(GMUClusterDelta *delta) {
+                        return [delta.addedClusters isEqualToArray:@[ nearbyCluster ]] &&
+                               delta.removedClusters.count == 0;
+                      }]];
+  [[[_renderer expect] andDo:^(NSInvocation *invocation) {
+    [rendered fulfill];
+  }] renderClusterDelta:[OCMArg checkWithBlock:^BOOL(GMUClusterDelta *delta) {
+    return [delta.addedClusters isEqualToArray:@[ farCluster ]] &&
+           delta.removedClusters.count == 0;
+  }]];
+
+  // Act.
+  [_clusterManager cluster];
+
+  // Assert.
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+  XCTAssertTrue(renderedBeforeWorld);
+}
+
+- (void)testClusterAsynchronouslyCancelsSupersededClustering {
+  // Arrange.
+  _clusterManager.asynchronous = YES;
+  NSArray<id<GMUCluster>> *staleClusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
+  NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
+  dispatch_semaphore_t started = dispatch_semaphore_create(0);
+  dispatch_semaphore_t superseded = dispatch_semaphore_create(0);
+  __block GMUClusterCancellationToken *staleToken;
+  // The first clustering only completes once the second one has been requested.
+  [[[[[_algorithm expect] ignoringNonObjectArgs] andDo:^(NSInvocation *invocation) {
+    __unsafe_unretained GMUClusterCancellationToken *token;
+    [invocation getArgument:&token atIndex:4];
+    staleToken = token;
+    dispatch_semaphore_signal(started);
+    dispatch_semaphore_wait(superseded, DISPATCH_TIME_FOREVER);
+  }] andReturn:staleClusters] clustersAtZoom:kCameraZoom
+                                     inBounds:kAnyBounds
+                            cancellationToken:OCMOCK_ANY];
+  [[[[_algorithm expect] ignoringNonObjectArgs] andReturn:clusters]
+         clustersAtZoom:kCameraZoom
+               inBounds:kAnyBounds
+      cancellationToken:OCMOCK_ANY];
+  XCTestExpectation *rendered = [self expectationWithDescription:@"Clusters rendered"];
+  [[[_renderer expect] andDo:^(NSInvocation *invocation) {
+    [rendered fulfill];
+  }] renderClusters:clusters];
+
+  // Act.
+  [_clusterManager cluster];
+  dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+  [_clusterManager cluster];
+  dispatch_semaphore_signal(superseded);
+
+  // Assert: only the clusters of the second call are rendered.
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+  XCTAssertTrue(staleToken.isCancelled);
+}
+
 - (void)testCameraChangedReclusterRequested {
   // Arrange.
   NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
-  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:kCameraZoom];
+  [[[[_algorithm expect] ignoringNonObjectArgs] andReturn:clusters] clustersAtZoom:kCameraZoom
+                                                                           inBounds:kAnyBounds];
   [[_renderer expect] renderClusters:clusters];
   // Intial cluster.
   [_clusterManager cluster];
@@ -150,7 +428,8 @@ static const double kCameraZoom = 10.0;
 - (void)testCameraChangedALittleReclusterNotRequested {
   // Arrange.
   NSArray<id<GMUCluster>> *clusters = @[ OCMProtocolMock(@protocol(GMUCluster)) ];
-  [[[_algorithm expect] andReturn:clusters] clustersAtZoom:kCameraZoom];
+  [[[[_algorithm expect] ignoringNonObjectArgs] andReturn:clusters] clustersAtZoom:kCameraZoom
+                                                                           inBounds:kAnyBounds];
   [[_renderer expect] renderClusters:clusters];
   // Intial cluster.
   [_clusterManager cluster];
@@ -295,5 +574,63 @@ static const double kCameraZoom = 10.0;
   [_clusterManager mapViewDidFinishTileRendering:_mapView];
 }
 
-@end
+#pragma mark Private
+
+// Returns a visible region two degrees wide and high around |position|.
+- (GMSVisibleRegion)visibleRegionAroundPosition:(CLLocationCoordinate2D)position {
+  GMSVisibleRegion region;
+  region.nearLeft = CLLocationCoordinate2DMake(position.latitude - 1, position.longitude - 1);
+  region.nearRight = CLLocationCoordinate2DMake(position.latitude - 1, position.longitude + 1);
+  region.farLeft = CLLocationCoordinate2DMake(position.latitude + 1, position.longitude - 1);
+  region.farRight = CLLocationCoordinate2DMake(position.latitude + 1, position.longitude + 1);
+  return region;
+}
+
+// Streams the clusters of |algorithm| over items in and around the visible region, many near the
+// edges of the streamed areas, and asserts that every item is rendered in exactly one cluster.
+- (void)assertStreamingRendersEveryItemExactlyOnceWithAlgorithm:(id<GMUClusterAlgorithm>)algorithm {
+  _clusterManager =
+      [[GMUClusterManager alloc] initWithMap:_mapView algorithm:algorithm renderer:_renderer];
+  _clusterManager.asynchronous = YES;
+  _clusterManager.streaming = YES;
+  // Items across the visible region, the area around it and beyond, many near their edges.
+  NSMutableArray<id<GMUClusterItem>> *items = [[NSMutableArray alloc] init];
+  for (double dLat = -4; dLat <= 4; dLat += 0.1) {
+    for (double dLng = -4; dLng <= 4; dLng += 0.1) {
+      CLLocationCoordinate2D position = CLLocationCoordinate2DMake(
+          kCameraPosition.latitude + dLat, kCameraPosition.longitude + dLng);
+      [items addObject:[[GMUTestClusterItem alloc] initWithPosition:position]];
+    }
+  }
+  [_clusterManager addItems:items];
+  NSCountedSet *renderedItems = [[NSCountedSet alloc] init];
+  __block NSUInteger chunkCount = 0;
+  XCTestExpectation *rendered = [self expectationWithDescription:@"All items rendered"];
+  void (^renderChunk)(NSArray<id<GMUCluster>> *) = ^(NSArray<id<GMUCluster>> *clusters) {
+    ++chunkCount;
+    for (id<GMUCluster> cluster in clusters) {
+      [renderedItems addObjectsFromArray:cluster.items];
+    }
+    if (renderedItems.count == items.count) [rendered fulfill];
+  };
+  [[[_renderer stub] andDo:^(NSInvocation *invocation) {
+    __unsafe_unretained NSArray<id<GMUCluster>> *clusters;
+    [invocation getArgument:&clusters atIndex:2];
+    renderChunk(clusters);
+  }] renderClusters:OCMOCK_ANY];
+  [[[_renderer stub] andDo:^(NSInvocation *invocation) {
+    __unsafe_unretained GMUClusterDelta *delta;
+    [invocation getArgument:&delta atIndex:2];
+    XCTAssertEqual(delta.removedClusters.count, 0);
+    renderChunk(delta.addedClusters);
+  }] renderClusterDelta:OCMOCK_ANY];
 
+  [_clusterManager cluster];
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+  XCTAssertEqual(chunkCount, 3);
+  for (id<GMUClusterItem> item in items) {
+    XCTAssertEqual([renderedItems countForObject:item], 1);
+  }
+}
+
+@end
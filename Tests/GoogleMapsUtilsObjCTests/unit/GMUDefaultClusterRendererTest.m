@@ -20,6 +20,7 @@
 #import <OCMock/OCMock.h>
 #import <XCTest/XCTest.h>
 
+#import "GMUClusterDelta.h"
 #import "GMUDefaultClusterRenderer+Testing.h"
 #import "GMUStaticCluster.h"
 #import "GMUTestClusterItem.h"
@@ -222,6 +223,53 @@ static const CLLocationCoordinate2D kCameraPosition = {-35, 151};
   XCTAssertNil(previousMarkers[0].map);
 }
 
+- (void)testRenderClusterDeltaOnlyReplacesMarkersOfAffectedClusters {
+  // Arrange.
+  GMUStaticCluster *cluster1 = [self clusterAroundPosition:kCameraPosition count:10];
+  GMUStaticCluster *cluster2 =
+      [self clusterAroundPosition:CLLocationCoordinate2DMake(kCameraPosition.latitude + 1.0,
+                                                             kCameraPosition.longitude)
+                            count:10];
+  GMUStaticCluster *cluster3 =
+      [self clusterAroundPosition:CLLocationCoordinate2DMake(kCameraPosition.latitude - 1.0,
+                                                             kCameraPosition.longitude)
+                            count:10];
+  [_renderer renderClusters:@[ cluster1, cluster2 ]];
+  NSArray<GMSMarker *> *previousMarkers = [_renderer markers];
+  XCTAssertEqual(previousMarkers.count, 2);
+
+  // cluster1 shrinks below the minimum cluster size, cluster2 goes away and cluster3 appears.
+  NSArray<id<GMUClusterItem>> *items = cluster1.items;
+  for (NSUInteger i = 3; i < items.count; ++i) {
+    [cluster1 removeItem:items[i]];
+  }
+  GMUClusterDelta *delta = [[GMUClusterDelta alloc] initWithZoom:10
+                                                   addedClusters:@[ cluster3 ]
+                                                 removedClusters:@[ cluster2 ]
+                                                 changedClusters:@[ cluster1 ]];
+
+  // Act.
+  [_renderer renderClusterDelta:delta];
+
+  // Assert.
+  for (GMSMarker *marker in previousMarkers) {
+    XCTAssertNil(marker.map);
+  }
+  NSArray<GMSMarker *> *markers = [_renderer markers];
+  XCTAssertEqual(markers.count, 4);
+  NSUInteger itemMarkerCount = 0;
+  for (GMSMarker *marker in markers) {
+    XCTAssertEqual(marker.map, _mapView);
+    if ([marker.userData conformsToProtocol:@protocol(GMUClusterItem)]) {
+      XCTAssertTrue([cluster1.items containsObject:marker.userData]);
+      ++itemMarkerCount;
+    } else {
+      XCTAssertEqual(marker.userData, cluster3);
+    }
+  }
+  XCTAssertEqual(itemMarkerCount, 3);
+}
+
 - (void)testShouldRenderAsClusterAtZoom {
   // Small cluster.
   XCTAssertFalse([_renderer
@@ -267,6 +315,26 @@ static const CLLocationCoordinate2D kCameraPosition = {-35, 151};
   }
 }
 
+- (void)testRenderClustersPrefersIconForCluster {
+  // Arrange.
+  id iconGenerator = OCMProtocolMock(@protocol(GMUClusterIconGenerator));
+  GMUStaticCluster *cluster = [self clusterAroundPosition:kCameraPosition count:10];
+  UIImage *icon = [[UIImage alloc] init];
+  OCMStub([iconGenerator iconForCluster:cluster]).andReturn(icon);
+  OCMReject([iconGenerator iconForSize:10]);
+  GMUDefaultClusterRenderer *renderer =
+      [[GMUDefaultClusterRenderer alloc] initWithMapView:_mapView
+                                    clusterIconGenerator:iconGenerator];
+  renderer.animatesClusters = NO;
+
+  // Act.
+  [renderer renderClusters:@[ cluster ]];
+
+  // Assert.
+  XCTAssertEqual(renderer.markers.count, 1);
+  XCTAssertEqual(renderer.markers[0].icon, icon);
+}
+
 #pragma mark Private
 
 // Returns a new cluster around a |position| with |count| items in it.
@@ -50,5 +50,111 @@
   [self assertValidClusters:clusters];
 }
 
+- (void)testClustersAtZoomOnlyGroupsItemsOfTheSameCategory {
+  GMUGridBasedClusterAlgorithm *algorithm = [[GMUGridBasedClusterAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self categorizedClusterItems];
+  [algorithm addItems:items];
+
+  // Act.
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:3];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 2);
+  XCTAssertEqual(clusters[0].items.count, items.count / 2);
+  XCTAssertEqual(clusters[1].items.count, items.count / 2);
+  XCTAssertEqualObjects(clusters[0].clusterCategory, items[0].clusterCategory);
+  [self assertClustersMatchItemCategories:clusters];
+}
+
+- (void)testClustersAtZoomComputesAggregateValues {
+  GMUGridBasedClusterAlgorithm *algorithm = [[GMUGridBasedClusterAlgorithm alloc] init];
+  algorithm.aggregates = [self weightAggregates];
+  [algorithm addItems:[self weightedClusterItems]];
+
+  // Act.
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+
+  // Assert.
+  XCTAssertGreaterThan(clusters.count, 0);
+  [self assertClustersMatchItemWeights:clusters];
+}
+
+- (void)testClustersAtZoomReturnsClustersInOrderOfFirstItems {
+  GMUGridBasedClusterAlgorithm *algorithm = [[GMUGridBasedClusterAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:@[ items[2], items[0] ]];
+  [algorithm addItems:@[ items[3], items[1] ]];
+
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+  XCTAssertEqual(clusters.count, 4);
+  XCTAssertEqualObjects(clusters[0].items, @[ items[2] ]);
+  XCTAssertEqualObjects(clusters[1].items, @[ items[0] ]);
+  XCTAssertEqualObjects(clusters[2].items, @[ items[3] ]);
+  XCTAssertEqualObjects(clusters[3].items, @[ items[1] ]);
+}
+
+- (void)testClustersAtZoomLargerGridCellsGroupItemsIntoOneCluster {
+  GMUGridBasedClusterAlgorithm *algorithm =
+      [[GMUGridBasedClusterAlgorithm alloc] initWithGridCellSizePoints:1 << 20];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:items];
+
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqual(clusters[0].items.count, 4);
+}
+
+- (void)testClustersAtZoomInBoundsWithCancelledTokenReturnsNil {
+  GMUGridBasedClusterAlgorithm *algorithm = [[GMUGridBasedClusterAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:items];
+  GMUClusterCancellationToken *cancelledToken = [[GMUClusterCancellationToken alloc] init];
+  [cancelledToken cancel];
+  GMUClusterCancellationToken *token = [[GMUClusterCancellationToken alloc] init];
+  GQTBounds world = {-1, -1, 1, 1};
+
+  // Act.
+  NSArray<id<GMUCluster>> *cancelledClusters = [algorithm clustersAtZoom:10
+                                                                inBounds:world
+                                                       cancellationToken:cancelledToken];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10
+                                                       inBounds:world
+                                              cancellationToken:token];
+
+  // Assert.
+  XCTAssertNil(cancelledClusters);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+}
+
+- (void)testRemoveItem {
+  GMUGridBasedClusterAlgorithm *algorithm = [[GMUGridBasedClusterAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:items];
+
+  [algorithm removeItem:items[1]];
+
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+  XCTAssertEqual(clusters.count, 3);
+  XCTAssertEqualObjects(clusters[0].items, @[ items[0] ]);
+  XCTAssertEqualObjects(clusters[1].items, @[ items[2] ]);
+  XCTAssertEqualObjects(clusters[2].items, @[ items[3] ]);
+  [self assertValidClusters:clusters];
+}
+
+- (void)testClustersAtZoomInBoundsOnlyClustersItemsInBounds {
+  GMUGridBasedClusterAlgorithm *algorithm = [[GMUGridBasedClusterAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:items];
+
+  // Act.
+  GQTBounds bounds = [self boundsFromLocation:CLLocationCoordinate2DMake(-1.5, -1.5)
+                                   toLocation:CLLocationCoordinate2DMake(-0.5, -0.5)];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10 inBounds:bounds];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqualObjects(clusters[0].items, @[ items[0] ]);
+}
+
 @end
 
@@ -0,0 +1,406 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(__has_feature) || !__has_feature(objc_arc)
+#error "This file requires ARC support."
+#endif
+
+#import "GMUHierarchicalDistanceBasedAlgorithm.h"
+
+#import "GMUClusterAlgorithmTest.h"
+
+@interface GMUHierarchicalDistanceBasedAlgorithmTest : GMUClusterAlgorithmTest
+@end
+
+@implementation GMUHierarchicalDistanceBasedAlgorithmTest
+
+- (void)testClustersAtZoomWithoutItemsReturnsNoClusters {
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+
+  XCTAssertEqual([algorithm clustersAtZoom:10].count, 0);
+}
+
+- (void)testClustersAtZoomLowZoomItemsGroupedIntoOneCluster {
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+
+  // Act.
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:4];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqual(clusters[0].count, items.count);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+  // The cluster is at the centroid of the four items around (0, 0).
+  XCTAssertEqualWithAccuracy(clusters[0].position.latitude, 0, 1e-9);
+  XCTAssertEqualWithAccuracy(clusters[0].position.longitude, 0, 1e-9);
+}
+
+- (void)testClustersAtZoomHighZoomItemsGroupedIntoMultipleClusters {
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+
+  // Act.
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:14];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 4);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+}
+
+/**
+ * Generates a bunch of random points around a number of "centroids", then shuffle them up and
+ * verify number of clusters should be equal to number of centroids.
+ */
+- (void)testClustersAtZoomRandomClusters {
+  // Arrange.
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+
+  // Act.
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 4);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+  for (id<GMUCluster> cluster in clusters) {
+    XCTAssertEqual(cluster.count, items.count / 4);
+    XCTAssertEqual(cluster.items.count, items.count / 4);
+  }
+  [self assertValidClusters:clusters];
+
+  // Test on high zoom, should split into multiple clusters.
+  clusters = [algorithm clustersAtZoom:18];
+
+  // Assert.
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+  [self assertValidClusters:clusters];
+}
+
+- (void)testClustersAtZoomOnlyGroupsItemsOfTheSameCategory {
+  // Arrange.
+  NSArray<id<GMUClusterItem>> *items = [self categorizedClusterItems];
+
+  // Act.
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+  NSArray<id<GMUCluster>> *lowZoomClusters = [algorithm clustersAtZoom:0];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 8);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+  for (id<GMUCluster> cluster in clusters) {
+    XCTAssertEqual(cluster.count, items.count / 8);
+  }
+  [self assertClustersMatchItemCategories:clusters];
+  XCTAssertEqual(lowZoomClusters.count, 2);
+  [self assertClustersMatchItemCategories:lowZoomClusters];
+}
+
+- (void)testClustersAtZoomComputesAggregateValues {
+  // Arrange.
+  NSArray<id<GMUClusterItem>> *items = [self weightedClusterItems];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  algorithm.aggregates = [self weightAggregates];
+  [algorithm addItems:items];
+
+  for (float zoom = 0; zoom <= 22; zoom += 2) {
+    // Act.
+    NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:zoom];
+
+    // Assert.
+    [self assertClustersMatchItemWeights:clusters];
+  }
+}
+
+- (void)testClustersAtZoomClustersAreMadeOfClustersOfNextZoom {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+
+  for (float zoom = 0; zoom < 21; ++zoom) {
+    NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:zoom];
+    NSArray<id<GMUCluster>> *nextClusters = [algorithm clustersAtZoom:zoom + 1];
+    XCTAssertLessThanOrEqual(clusters.count, nextClusters.count);
+    for (id<GMUCluster> nextCluster in nextClusters) {
+      NSSet *nextItems = [NSSet setWithArray:nextCluster.items];
+      NSUInteger containingClusters = 0;
+      for (id<GMUCluster> cluster in clusters) {
+        NSSet *clusterItems = [NSSet setWithArray:cluster.items];
+        if ([nextItems isSubsetOfSet:clusterItems]) {
+          ++containingClusters;
+        } else {
+          XCTAssertFalse([nextItems intersectsSet:clusterItems]);
+        }
+      }
+      XCTAssertEqual(containingClusters, 1);
+    }
+  }
+}
+
+- (void)testClustersAtZoomAboveMaxZoomReturnsItems {
+  NSArray<id<GMUClusterItem>> *items = @[
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 10)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 10)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 10.0001)],
+  ];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] initWithClusterDistancePoints:100
+                                                                           maxZoom:5];
+  [algorithm addItems:items];
+
+  XCTAssertEqual([algorithm clustersAtZoom:5].count, 1);
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:6];
+  XCTAssertEqual(clusters.count, 3);
+  for (id<GMUCluster> cluster in clusters) {
+    XCTAssertEqual(cluster.count, 1);
+    XCTAssertTrue([items containsObject:cluster.items[0]]);
+    XCTAssertEqual(cluster.position.latitude, cluster.items[0].position.latitude);
+    XCTAssertEqual(cluster.position.longitude, cluster.items[0].position.longitude);
+  }
+  XCTAssertEqual([algorithm clustersAtZoom:21].count, 3);
+}
+
+- (void)testClustersAtZoomItemsAcrossAntimeridianGroupedIntoOneCluster {
+  NSArray<id<GMUClusterItem>> *items = @[
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 179.9)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, -179.9)],
+  ];
+
+  // Act.
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:8];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+  XCTAssertEqualWithAccuracy(fabs(clusters[0].position.longitude), 180, 1e-9);
+}
+
+- (void)testClustersAtZoomInBoundsReturnsClustersOfZoomInBounds {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  GQTBounds bounds = [self boundsFromLocation:CLLocationCoordinate2DMake(-2, -2)
+                                   toLocation:CLLocationCoordinate2DMake(0, 0)];
+
+  for (float zoom = 0; zoom < 22; ++zoom) {
+    // Act.
+    NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:zoom inBounds:bounds];
+
+    // Assert.
+    NSMutableSet<NSArray<id<GMUClusterItem>> *> *expectedItems = [NSMutableSet set];
+    for (id<GMUCluster> cluster in [algorithm clustersAtZoom:zoom]) {
+      GMSMapPoint point = GMSProject(cluster.position);
+      if (point.x >= bounds.minX && point.x <= bounds.maxX && point.y >= bounds.minY &&
+          point.y <= bounds.maxY) {
+        [expectedItems addObject:cluster.items];
+      }
+    }
+    NSMutableSet<NSArray<id<GMUClusterItem>> *> *actualItems = [NSMutableSet set];
+    for (id<GMUCluster> cluster in clusters) {
+      [actualItems addObject:cluster.items];
+    }
+    XCTAssertEqualObjects(actualItems, expectedItems);
+  }
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10 inBounds:bounds];
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqual(clusters[0].count, items.count / 4);
+}
+
+- (void)testClustersAtZoomInBoundsAcrossAntimeridian {
+  NSArray<id<GMUClusterItem>> *items = @[
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 179.9)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 0)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, -179.9)],
+  ];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+
+  // Act.
+  GQTBounds bounds = [self boundsFromLocation:CLLocationCoordinate2DMake(9, 179)
+                                   toLocation:CLLocationCoordinate2DMake(11, -179)];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:14 inBounds:bounds];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 2);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], 2);
+}
+
+- (void)testAddItemsAfterClustering {
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[items subarrayWithRange:NSMakeRange(0, 2)]];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:14];
+  XCTAssertEqual(clusters.count, 2);
+
+  // Act.
+  [algorithm addItems:[items subarrayWithRange:NSMakeRange(2, 2)]];
+
+  // Assert.
+  XCTAssertEqual([algorithm clustersAtZoom:14].count, 4);
+  // Clusters returned earlier are unaffected.
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], 2);
+}
+
+- (void)testClustersAtZoomInBoundsWithCancelledTokenReturnsNil {
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:items];
+  GMUClusterCancellationToken *cancelledToken = [[GMUClusterCancellationToken alloc] init];
+  [cancelledToken cancel];
+  GMUClusterCancellationToken *token = [[GMUClusterCancellationToken alloc] init];
+  GQTBounds world = {-1, -1, 1, 1};
+
+  // Act.
+  NSArray<id<GMUCluster>> *cancelledClusters = [algorithm clustersAtZoom:10
+                                                                inBounds:world
+                                                       cancellationToken:cancelledToken];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10
+                                                       inBounds:world
+                                              cancellationToken:token];
+
+  // Assert.
+  XCTAssertNil(cancelledClusters);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+}
+
+- (void)testRemoveItem {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  [algorithm clustersAtZoom:18];
+
+  // Act.
+  for (NSUInteger i = 0; i < items.count; i += 2) {
+    [algorithm removeItem:items[i]];
+  }
+  // Removing an item twice is ignored.
+  [algorithm removeItem:items[0]];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:18];
+
+  // Assert.
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count / 2);
+  NSMutableSet *clusteredItems = [NSMutableSet set];
+  for (id<GMUCluster> cluster in clusters) {
+    [clusteredItems addObjectsFromArray:cluster.items];
+  }
+  for (NSUInteger i = 0; i < items.count; ++i) {
+    XCTAssertEqual([clusteredItems containsObject:items[i]], i % 2 == 1);
+  }
+  [self assertValidClusters:clusters];
+}
+
+- (void)testAddItemsWithCoordinatesClustersLikeAddItems {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  CLLocationCoordinate2D *coordinates = malloc(items.count * sizeof(CLLocationCoordinate2D));
+  int64_t *identifiers = malloc(items.count * sizeof(int64_t));
+  for (NSUInteger i = 0; i < items.count; ++i) {
+    coordinates[i] = items[i].position;
+    identifiers[i] = (int64_t)i + ((int64_t)1 << 40);
+  }
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  GMUHierarchicalDistanceBasedAlgorithm *packedAlgorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+
+  // Act.
+  [packedAlgorithm addItemsWithCoordinates:coordinates identifiers:identifiers count:items.count];
+  free(coordinates);
+  free(identifiers);
+
+  // Assert.
+  for (float zoom = 0; zoom <= 22; zoom += 2) {
+    NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:zoom];
+    NSArray<id<GMUCluster>> *packedClusters = [packedAlgorithm clustersAtZoom:zoom];
+    XCTAssertEqual(packedClusters.count, clusters.count);
+    for (NSUInteger i = 0; i < clusters.count; ++i) {
+      XCTAssertEqual(packedClusters[i].position.latitude, clusters[i].position.latitude);
+      XCTAssertEqual(packedClusters[i].position.longitude, clusters[i].position.longitude);
+      NSArray<id<GMUClusterItem>> *clusterItems = clusters[i].items;
+      NSArray<id<GMUClusterItem>> *packedItems = packedClusters[i].items;
+      XCTAssertEqual(packedItems.count, clusterItems.count);
+      for (NSUInteger j = 0; j < clusterItems.count; ++j) {
+        GMUPackedClusterItem *packedItem = (GMUPackedClusterItem *)packedItems[j];
+        XCTAssertEqual(packedItem.identifier,
+                       (int64_t)[items indexOfObject:clusterItems[j]] + ((int64_t)1 << 40));
+        XCTAssertEqual(packedItem.position.latitude, clusterItems[j].position.latitude);
+      }
+    }
+  }
+}
+
+- (void)testRemoveItemRemovesPackedItemWithIdentifier {
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  CLLocationCoordinate2D coordinates[] = {items[0].position, items[1].position};
+  int64_t identifiers[] = {7, 8};
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:@[ items[2] ]];
+  [algorithm addItemsWithCoordinates:coordinates identifiers:identifiers count:2];
+  [algorithm addItems:@[ items[3] ]];
+
+  // Act.
+  [algorithm removeItem:[[GMUPackedClusterItem alloc] initWithIdentifier:7
+                                                                position:items[3].position]];
+  [algorithm removeItem:items[2]];
+
+  // Assert.
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:21];
+  NSMutableSet *clusteredItems = [NSMutableSet set];
+  for (id<GMUCluster> cluster in clusters) {
+    [clusteredItems addObjectsFromArray:cluster.items];
+  }
+  XCTAssertEqual(clusteredItems.count, 2);
+  XCTAssertTrue([clusteredItems containsObject:items[3]]);
+  XCTAssertTrue([clusteredItems
+      containsObject:[[GMUPackedClusterItem alloc] initWithIdentifier:8
+                                                             position:items[1].position]]);
+  [self assertValidClusters:clusters];
+}
+
+- (void)testClearItems {
+  GMUHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[self randomizedClusterItems]];
+  XCTAssertEqual([algorithm clustersAtZoom:10].count, 4);
+
+  // Act.
+  [algorithm clearItems];
+
+  // Assert.
+  XCTAssertEqual([algorithm clustersAtZoom:10].count, 0);
+}
+
+@end
@@ -20,6 +20,27 @@
 #import "GMUNonHierarchicalDistanceBasedAlgorithm.h"
 
 #import "GMUClusterAlgorithmTest.h"
+#import "GMUTestClusterItem.h"
+
+// Test item equal to any other such item at the same position.
+@interface GMUPositionEqualClusterItem : GMUTestClusterItem
+@end
+
+@implementation GMUPositionEqualClusterItem
+
+- (NSUInteger)hash {
+  return @(self.position.latitude).hash ^ @(self.position.longitude).hash;
+}
+
+- (BOOL)isEqual:(id)object {
+  if (self == object) return YES;
+  if ([object class] != [self class]) return NO;
+  GMUPositionEqualClusterItem *other = (GMUPositionEqualClusterItem *)object;
+  return self.position.latitude == other.position.latitude &&
+         self.position.longitude == other.position.longitude;
+}
+
+@end
 
 @interface GMUNonHierarchicalDistanceBasedAlgorithmTest : GMUClusterAlgorithmTest
 @end
@@ -87,6 +108,228 @@
   [self assertValidClusters:clusters];
 }
 
+- (void)testClustersAtZoomOnlyGroupsItemsOfTheSameCategory {
+  NSArray<id<GMUClusterItem>> *items = [self categorizedClusterItems];
+
+  for (int parallel = 0; parallel <= 1; ++parallel) {
+    // Act.
+    GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+        [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+    algorithm.parallel = parallel;
+    [algorithm addItems:items];
+    NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+
+    // Assert.
+    XCTAssertEqual(clusters.count, 8);
+    XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+    for (id<GMUCluster> cluster in clusters) {
+      XCTAssertEqual(cluster.items.count, items.count / 8);
+    }
+    [self assertClustersMatchItemCategories:clusters];
+  }
+}
+
+- (void)testClustersAtZoomComputesAggregateValues {
+  NSArray<id<GMUClusterItem>> *items = [self weightedClusterItems];
+
+  for (int parallel = 0; parallel <= 1; ++parallel) {
+    // Act.
+    GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+        [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+    algorithm.parallel = parallel;
+    algorithm.aggregates = [self weightAggregates];
+    [algorithm addItems:items];
+    NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10];
+
+    // Assert.
+    XCTAssertEqual(clusters.count, 4);
+    [self assertClustersMatchItemWeights:clusters];
+  }
+}
+
+- (void)testClustersAtZoomItemsAcrossAntimeridianGroupedIntoOneCluster {
+  NSArray<id<GMUClusterItem>> *items = @[
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 179.9)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, -179.9)],
+  ];
+
+  // Act.
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:8];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+}
+
+- (void)testParallelClustersAtZoomMatchSequentialClusters {
+  NSMutableArray<id<GMUClusterItem>> *items = [[self randomizedClusterItems] mutableCopy];
+  [items addObjectsFromArray:[self itemsAroundLocation:CLLocationCoordinate2DMake(10, 179.99)
+                                                  count:500
+                                                   zoom:6
+                                                 radius:400]];
+  for (int i = 0; i < 2000; ++i) {
+    CLLocationCoordinate2D location =
+        CLLocationCoordinate2DMake(arc4random_uniform(160) - 80.0, arc4random_uniform(360) - 180.0);
+    [items addObject:[self itemAtLocation:location]];
+  }
+  [self shuffleMutableArray:items];
+  GMUNonHierarchicalDistanceBasedAlgorithm *sequentialAlgorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [sequentialAlgorithm addItems:items];
+  GMUNonHierarchicalDistanceBasedAlgorithm *parallelAlgorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  parallelAlgorithm.parallel = YES;
+  [parallelAlgorithm addItems:items];
+
+  for (float zoom = 0; zoom <= 16; zoom += 2) {
+    // Act.
+    NSArray<id<GMUCluster>> *expectedClusters = [sequentialAlgorithm clustersAtZoom:zoom];
+    NSArray<id<GMUCluster>> *clusters = [parallelAlgorithm clustersAtZoom:zoom];
+
+    // Assert.
+    XCTAssertEqual(clusters.count, expectedClusters.count);
+    for (NSUInteger i = 0; i < MIN(clusters.count, expectedClusters.count); ++i) {
+      XCTAssertEqual(clusters[i].position.latitude, expectedClusters[i].position.latitude);
+      XCTAssertEqual(clusters[i].position.longitude, expectedClusters[i].position.longitude);
+      XCTAssertEqualObjects([NSSet setWithArray:clusters[i].items],
+                            [NSSet setWithArray:expectedClusters[i].items]);
+    }
+  }
+}
+
+- (void)testParallelClustersAtZoomInBoundsMatchSequentialClusters {
+  NSMutableArray<id<GMUClusterItem>> *items = [[self randomizedClusterItems] mutableCopy];
+  [items addObjectsFromArray:[self itemsAroundLocation:CLLocationCoordinate2DMake(10, 179.99)
+                                                  count:500
+                                                   zoom:6
+                                                 radius:400]];
+  [self shuffleMutableArray:items];
+  GMUNonHierarchicalDistanceBasedAlgorithm *sequentialAlgorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [sequentialAlgorithm addItems:items];
+  GMUNonHierarchicalDistanceBasedAlgorithm *parallelAlgorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  parallelAlgorithm.parallel = YES;
+  [parallelAlgorithm addItems:items];
+  GQTBounds boundsList[] = {
+      [self boundsFromLocation:CLLocationCoordinate2DMake(-10, -10)
+                    toLocation:CLLocationCoordinate2DMake(10, 10)],
+      [self boundsFromLocation:CLLocationCoordinate2DMake(5, 179)
+                    toLocation:CLLocationCoordinate2DMake(15, -179)],
+      {-1, -1, 1, 1},
+  };
+
+  for (size_t b = 0; b < sizeof(boundsList) / sizeof(boundsList[0]); ++b) {
+    for (float zoom = 2; zoom <= 10; zoom += 4) {
+      // Act.
+      NSArray<id<GMUCluster>> *expectedClusters =
+          [sequentialAlgorithm clustersAtZoom:zoom inBounds:boundsList[b]];
+      NSArray<id<GMUCluster>> *clusters =
+          [parallelAlgorithm clustersAtZoom:zoom inBounds:boundsList[b]];
+
+      // Assert.
+      XCTAssertEqual(clusters.count, expectedClusters.count);
+      for (NSUInteger i = 0; i < MIN(clusters.count, expectedClusters.count); ++i) {
+        XCTAssertEqual(clusters[i].position.latitude, expectedClusters[i].position.latitude);
+        XCTAssertEqual(clusters[i].position.longitude, expectedClusters[i].position.longitude);
+        XCTAssertEqualObjects([NSSet setWithArray:clusters[i].items],
+                              [NSSet setWithArray:expectedClusters[i].items]);
+      }
+    }
+  }
+}
+
+- (void)testClustersAtZoomInBoundsOnlyReturnsClustersInBounds {
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+
+  // Act.
+  GQTBounds bounds = [self boundsFromLocation:CLLocationCoordinate2DMake(-1.5, -1.5)
+                                   toLocation:CLLocationCoordinate2DMake(-0.5, -0.5)];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:14 inBounds:bounds];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqualObjects(clusters[0].items, @[ items[0] ]);
+}
+
+- (void)testClustersAtZoomInBoundsAcrossAntimeridian {
+  NSArray<id<GMUClusterItem>> *items = @[
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 179.9)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, 0)],
+    [self itemAtLocation:CLLocationCoordinate2DMake(10, -179.9)],
+  ];
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+
+  // Act.
+  GQTBounds bounds = [self boundsFromLocation:CLLocationCoordinate2DMake(9, 179)
+                                   toLocation:CLLocationCoordinate2DMake(11, -179)];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:14 inBounds:bounds];
+
+  // Assert.
+  XCTAssertEqual(clusters.count, 2);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], 2);
+  for (id<GMUCluster> cluster in clusters) {
+    XCTAssertNotEqual(cluster.items[0], items[1]);
+  }
+}
+
+- (void)testClustersAtZoomInBoundsWithCancelledTokenReturnsNil {
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  NSArray<id<GMUClusterItem>> *items = [self simpleClusterItems];
+  [algorithm addItems:items];
+  GMUClusterCancellationToken *cancelledToken = [[GMUClusterCancellationToken alloc] init];
+  [cancelledToken cancel];
+  GMUClusterCancellationToken *token = [[GMUClusterCancellationToken alloc] init];
+  GQTBounds world = {-1, -1, 1, 1};
+
+  // Act.
+  NSArray<id<GMUCluster>> *cancelledClusters = [algorithm clustersAtZoom:10
+                                                                inBounds:world
+                                                       cancellationToken:cancelledToken];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:10
+                                                       inBounds:world
+                                              cancellationToken:token];
+
+  // Assert.
+  XCTAssertNil(cancelledClusters);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count);
+}
+
+- (void)testRemoveItem {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+
+  // Act.
+  for (NSUInteger i = 0; i < items.count; i += 2) {
+    [algorithm removeItem:items[i]];
+  }
+  // Removing an item twice is ignored.
+  [algorithm removeItem:items[0]];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:18];
+
+  // Assert.
+  XCTAssertEqual([self totalItemCountsForClusters:clusters], items.count / 2);
+  NSMutableSet *clusteredItems = [NSMutableSet set];
+  for (id<GMUCluster> cluster in clusters) {
+    [clusteredItems addObjectsFromArray:cluster.items];
+  }
+  for (NSUInteger i = 0; i < items.count; ++i) {
+    XCTAssertEqual([clusteredItems containsObject:items[i]], i % 2 == 1);
+  }
+  [self assertValidClusters:clusters];
+}
+
 /**
  * Verifies at high zoom, all clusters are distinct and total size is the same
  * as input size.
@@ -107,4 +350,210 @@
   [self assertValidClusters:clusters];
 }
 
+- (void)testClusterDeltaAtZoomFirstCallAddsAllClusters {
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[self simpleClusterItems]];
+
+  // Act.
+  GMUClusterDelta *delta = [algorithm clusterDeltaAtZoom:14];
+
+  // Assert.
+  XCTAssertEqual(delta.zoom, 14);
+  XCTAssertEqual(delta.addedClusters.count, 4);
+  XCTAssertEqual(delta.removedClusters.count, 0);
+  XCTAssertEqual(delta.changedClusters.count, 0);
+  XCTAssertEqualObjects([NSSet setWithArray:delta.addedClusters],
+                        [NSSet setWithArray:[algorithm clustersAtZoom:14]]);
+  XCTAssertTrue([algorithm clusterDeltaAtZoom:14].isEmpty);
+}
+
+- (void)testClusterDeltaAtZoomAfterAddingItemsMatchesFullClustering {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  NSUInteger count = items.count / 2;
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[items subarrayWithRange:NSMakeRange(0, count)]];
+  NSMutableSet<id<GMUCluster>> *clusters =
+      [NSMutableSet setWithArray:[algorithm clusterDeltaAtZoom:13].addedClusters];
+
+  // Act.
+  while (count < items.count) {
+    NSRange range = NSMakeRange(count, MIN(3, items.count - count));
+    [algorithm addItems:[items subarrayWithRange:range]];
+    [self applyDelta:[algorithm clusterDeltaAtZoom:13] toClusters:clusters];
+    count += range.length;
+  }
+
+  // Assert.
+  GMUNonHierarchicalDistanceBasedAlgorithm *reference =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [reference addItems:items];
+  XCTAssertEqualObjects([self itemSetsOfClusters:clusters.allObjects],
+                        [self itemSetsOfClusters:[reference clustersAtZoom:13]]);
+  XCTAssertEqualObjects(clusters, [NSSet setWithArray:[algorithm clustersAtZoom:13]]);
+}
+
+- (void)testClustersAtZoomAfterClusterDeltaAreInTheOrderOfFullClustering {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  NSUInteger count = items.count / 2;
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[items subarrayWithRange:NSMakeRange(0, count)]];
+  [algorithm clusterDeltaAtZoom:13];
+
+  // Act.
+  while (count < items.count) {
+    NSRange range = NSMakeRange(count, MIN(3, items.count - count));
+    [algorithm addItems:[items subarrayWithRange:range]];
+    [algorithm clusterDeltaAtZoom:13];
+    count += range.length;
+  }
+  NSArray<id<GMUCluster>> *clusters = [algorithm clustersAtZoom:13];
+  NSArray<id<GMUCluster>> *clustersInBounds =
+      [algorithm clustersAtZoom:13 inBounds:(GQTBounds){-1, -1, 1, 1}];
+
+  // Assert.
+  GMUNonHierarchicalDistanceBasedAlgorithm *reference =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [reference addItems:items];
+  NSArray<id<GMUCluster>> *referenceClusters = [reference clustersAtZoom:13];
+  XCTAssertEqual(clusters.count, referenceClusters.count);
+  XCTAssertEqualObjects(clustersInBounds, clusters);
+  for (NSUInteger i = 0; i < MIN(clusters.count, referenceClusters.count); ++i) {
+    XCTAssertEqualObjects([NSSet setWithArray:clusters[i].items],
+                          [NSSet setWithArray:referenceClusters[i].items]);
+  }
+}
+
+- (void)testClusterDeltaAtZoomAfterRemovingItems {
+  NSArray<id<GMUClusterItem>> *items = [self randomizedClusterItems];
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:items];
+  NSMutableSet<id<GMUCluster>> *clusters =
+      [NSMutableSet setWithArray:[algorithm clusterDeltaAtZoom:13].addedClusters];
+
+  // Act.
+  NSMutableSet<id<GMUClusterItem>> *remainingItems = [NSMutableSet setWithArray:items];
+  for (NSUInteger i = 0; i < items.count; i += 3) {
+    [algorithm removeItem:items[i]];
+    [remainingItems removeObject:items[i]];
+    [self applyDelta:[algorithm clusterDeltaAtZoom:13] toClusters:clusters];
+  }
+
+  // Assert.
+  XCTAssertEqualObjects(clusters, [NSSet setWithArray:[algorithm clustersAtZoom:13]]);
+  XCTAssertEqual([self totalItemCountsForClusters:clusters.allObjects], remainingItems.count);
+  NSMutableSet<id<GMUClusterItem>> *clusteredItems = [NSMutableSet set];
+  for (id<GMUCluster> cluster in clusters) {
+    XCTAssertGreaterThan(cluster.count, 0);
+    [clusteredItems addObjectsFromArray:cluster.items];
+  }
+  XCTAssertEqualObjects(clusteredItems, remainingItems);
+  [self assertValidClusters:clusters.allObjects];
+}
+
+- (void)testClusterDeltaAtZoomAfterRemovingItemsUpdatesAggregateValues {
+  NSArray<id<GMUClusterItem>> *items = [self weightedClusterItems];
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  algorithm.aggregates = [self weightAggregates];
+  [algorithm addItems:items];
+  [algorithm clusterDeltaAtZoom:13];
+
+  // Act.
+  for (NSUInteger i = 0; i < items.count; i += 3) {
+    [algorithm removeItem:items[i]];
+  }
+  [algorithm clusterDeltaAtZoom:13];
+
+  // Assert.
+  [self assertClustersMatchItemWeights:[algorithm clustersAtZoom:13]];
+}
+
+- (void)testClusterDeltaAtZoomAfterRemovingOneOfTwoEqualItems {
+  CLLocationCoordinate2D position = CLLocationCoordinate2DMake(10, 10);
+  GMUPositionEqualClusterItem *item1 =
+      [[GMUPositionEqualClusterItem alloc] initWithPosition:position];
+  GMUPositionEqualClusterItem *item2 =
+      [[GMUPositionEqualClusterItem alloc] initWithPosition:position];
+  XCTAssertEqualObjects(item1, item2);
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:@[ item1, item2 ]];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clusterDeltaAtZoom:13].addedClusters;
+  XCTAssertEqual(clusters.count, 1);
+  XCTAssertEqual(clusters[0].count, 2);
+
+  // Act.
+  [algorithm removeItem:item1];
+  GMUClusterDelta *delta = [algorithm clusterDeltaAtZoom:13];
+
+  // Assert.
+  XCTAssertEqualObjects(delta.changedClusters, clusters);
+  XCTAssertEqual(clusters[0].count, 1);
+  XCTAssertEqual(clusters[0].items.count, 1);
+  XCTAssertEqualObjects(clusters[0].items[0], item1);
+  XCTAssertEqualObjects([algorithm clustersAtZoom:13], clusters);
+}
+
+- (void)testClusterDeltaAtAnotherZoomReplacesAllClusters {
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[self simpleClusterItems]];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clusterDeltaAtZoom:14].addedClusters;
+
+  // Act.
+  GMUClusterDelta *delta = [algorithm clusterDeltaAtZoom:4];
+
+  // Assert.
+  XCTAssertEqualObjects([NSSet setWithArray:delta.removedClusters], [NSSet setWithArray:clusters]);
+  XCTAssertEqual(delta.addedClusters.count, 1);
+  XCTAssertEqual(delta.changedClusters.count, 0);
+}
+
+- (void)testClusterDeltaAtZoomAfterClearItemsRemovesAllClusters {
+  GMUNonHierarchicalDistanceBasedAlgorithm *algorithm =
+      [[GMUNonHierarchicalDistanceBasedAlgorithm alloc] init];
+  [algorithm addItems:[self simpleClusterItems]];
+  NSArray<id<GMUCluster>> *clusters = [algorithm clusterDeltaAtZoom:14].addedClusters;
+
+  // Act.
+  [algorithm clearItems];
+  GMUClusterDelta *delta = [algorithm clusterDeltaAtZoom:14];
+
+  // Assert.
+  XCTAssertEqualObjects([NSSet setWithArray:delta.removedClusters], [NSSet setWithArray:clusters]);
+  XCTAssertEqual(delta.addedClusters.count, 0);
+  XCTAssertEqual(delta.changedClusters.count, 0);
+  XCTAssertEqual([algorithm clustersAtZoom:14].count, 0);
+}
+
+#pragma mark Private
+
+// Applies |delta| to |clusters|, checking that it only refers to clusters it may.
+- (void)applyDelta:(GMUClusterDelta *)delta toClusters:(NSMutableSet<id<GMUCluster>> *)clusters {
+  for (id<GMUCluster> cluster in delta.removedClusters) {
+    XCTAssertTrue([clusters containsObject:cluster]);
+    [clusters removeObject:cluster];
+  }
+  for (id<GMUCluster> cluster in delta.changedClusters) {
+    XCTAssertTrue([clusters containsObject:cluster]);
+  }
+  for (id<GMUCluster> cluster in delta.addedClusters) {
+    XCTAssertFalse([clusters containsObject:cluster]);
+    [clusters addObject:cluster];
+  }
+}
+
+// Returns the sets of items of |clusters|, to compare clusterings regardless of cluster objects.
+- (NSSet<NSSet<id<GMUClusterItem>> *> *)itemSetsOfClusters:(NSArray<id<GMUCluster>> *)clusters {
+  NSMutableSet<NSSet<id<GMUClusterItem>> *> *itemSets = [NSMutableSet set];
+  for (id<GMUCluster> cluster in clusters) {
+    [itemSets addObject:[NSSet setWithArray:cluster.items]];
+  }
+  return itemSets;
+}
+
 @end
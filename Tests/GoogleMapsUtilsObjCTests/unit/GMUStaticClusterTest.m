@@ -21,6 +21,8 @@
 #import <OCMock/OCMock.h>
 #import <XCTest/XCTest.h>
 
+#import "GMUTestClusterItem.h"
+
 #define XCTAssertCoordsEqual(c1, c2, descr)        \
   XCTAssertEqual(c1.latitude, c2.latitude, descr); \
   XCTAssertEqual(c1.longitude, c2.longitude, descr);
@@ -76,5 +78,45 @@ static const CLLocationCoordinate2D kClusterPosition = {-35, 151};
   XCTAssertEqual(cluster.count, 0);
 }
 
-@end
+- (void)testItemsAreCopiedOnlyAfterChanges {
+  GMUStaticCluster *cluster = [[GMUStaticCluster alloc] initWithPosition:kClusterPosition];
+  [cluster addItem:OCMProtocolMock(@protocol(GMUClusterItem))];
+
+  NSArray<id<GMUClusterItem>> *items = cluster.items;
+  XCTAssertEqual(cluster.items, items);
 
+  [cluster addItem:OCMProtocolMock(@protocol(GMUClusterItem))];
+  XCTAssertEqual(items.count, 1);
+  XCTAssertEqual(cluster.items.count, 2);
+}
+
+- (void)testAggregateValues {
+  GMUClusterAggregate *sum =
+      [[GMUClusterAggregate alloc] initWithName:@"sum"
+                                       function:GMUClusterAggregateFunctionSum
+                                        keyPath:@"weight"];
+  GMUClusterAggregate *max =
+      [[GMUClusterAggregate alloc] initWithName:@"max"
+                                       function:GMUClusterAggregateFunctionMax
+                                        keyPath:@"weight"];
+  GMUStaticCluster *cluster = [[GMUStaticCluster alloc] initWithPosition:kClusterPosition
+                                                          clusterCategory:nil
+                                                               aggregates:@[ sum, max ]];
+  XCTAssertEqualObjects(cluster.aggregateValues, @{});
+
+  GMUTestClusterItem *item1 = [[GMUTestClusterItem alloc] initWithPosition:kClusterPosition];
+  item1.weight = @2;
+  GMUTestClusterItem *item2 = [[GMUTestClusterItem alloc] initWithPosition:kClusterPosition];
+  item2.weight = @5;
+  GMUTestClusterItem *item3 = [[GMUTestClusterItem alloc] initWithPosition:kClusterPosition];
+  [cluster addItem:item1];
+  [cluster addItem:item2];
+  [cluster addItem:item3];
+  XCTAssertEqualObjects(cluster.aggregateValues, (@{@"sum" : @7, @"max" : @5}));
+
+  // Remove the item with the largest value.
+  [cluster removeItem:item2];
+  XCTAssertEqualObjects(cluster.aggregateValues, (@{@"sum" : @2, @"max" : @2}));
+}
+
+@end
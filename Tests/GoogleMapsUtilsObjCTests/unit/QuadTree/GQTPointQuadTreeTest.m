@@ -29,6 +29,21 @@ static double randd(double min, double max) {
   return min + range * arc4random_uniform(1000) / 1000;
 }
 
+// Adds |item| and its offset to the NSMutableArray |context|.
+static bool GQTAddItemAndOffset(void *context, const void *item, GQTPoint point, double offsetX) {
+  NSMutableArray *results = (__bridge NSMutableArray *)context;
+  [results addObject:@[ (__bridge id)item, @(offsetX) ]];
+  return true;
+}
+
+// An item which does not go through OCMock, so that its lifetime is only decided by the tree.
+@interface GQTPointQuadTreeTestItem : NSObject <GQTPointQuadTreeItem>
+@property(nonatomic) GQTPoint point;
+@end
+
+@implementation GQTPointQuadTreeTestItem
+@end
+
 @interface GQTPointQuadTreeTest : XCTestCase
 @end
 
@@ -40,6 +55,12 @@ static double randd(double min, double max) {
   return item;
 }
 
+- (id<GQTPointQuadTreeItem>)itemAtPoint:(GQTPoint)point weight:(double)weight {
+  id item = [self itemAtPoint:point];
+  [[[item stub] andReturnValue:OCMOCK_VALUE(weight)] weight];
+  return item;
+}
+
 - (void)testAddInsideItemAdded {
   GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
   id<GQTPointQuadTreeItem> item = [self itemAtPoint:(GQTPoint){0.5, 0.5}];
@@ -165,6 +186,716 @@ static double randd(double min, double max) {
   XCTAssertEqual(items.count, 40);
 }
 
+- (void)testSearchWithBoundsCoincidentItems {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSMutableArray *items = [NSMutableArray array];
+  for (int i = 0; i < 200; ++i) {
+    id<GQTPointQuadTreeItem> item = [self itemAtPoint:(GQTPoint){0.25, 0.25}];
+    [items addObject:item];
+    XCTAssertTrue([tree add:item]);
+  }
+  XCTAssertEqual(tree.count, 200);
+
+  NSArray *found = [tree searchWithBounds:(GQTBounds){0.25, 0.25, 0.25, 0.25}];
+  XCTAssertEqual(found.count, 200);
+
+  for (int i = 0; i < 200; i += 2) {
+    XCTAssertTrue([tree remove:items[i]]);
+  }
+  XCTAssertEqual(tree.count, 100);
+  found = [tree searchWithBounds:(GQTBounds){0, 0, 0.5, 0.5}];
+  XCTAssertEqual(found.count, 100);
+  XCTAssertFalse([found containsObject:items[0]]);
+  XCTAssertTrue([found containsObject:items[1]]);
+}
+
+- (void)testRemoveAfterSplit {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  for (id item in items) {
+    [tree add:item];
+  }
+
+  for (id item in items) {
+    XCTAssertTrue([tree remove:item]);
+  }
+
+  XCTAssertEqual(tree.count, 0);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){-1, -1, 1, 1}].count, 0);
+}
+
+- (void)testInitWithSplitPolicy {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  XCTAssertEqual(tree.leafCapacity, 64);
+  XCTAssertEqual(tree.maxDepth, 30);
+  XCTAssertFalse(tree.isAdaptive);
+
+  tree = [[GQTPointQuadTree alloc] initWithBounds:(GQTBounds){-1, -1, 1, 1}
+                                     leafCapacity:1
+                                         maxDepth:1000
+                                         adaptive:YES
+                                  keepsAggregates:NO];
+  XCTAssertEqual(tree.leafCapacity, 4);
+  XCTAssertEqual(tree.maxDepth, 48);
+  XCTAssertTrue(tree.isAdaptive);
+  XCTAssertFalse(tree.keepsAggregates);
+}
+
+- (void)testSearchWithBoundsUnderSplitPolicies {
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  NSMutableArray *coincidentItems = [NSMutableArray array];
+  for (int i = 0; i < 300; ++i) {
+    [coincidentItems addObject:[self itemAtPoint:(GQTPoint){0.25, 0.25}]];
+  }
+  NSUInteger capacities[] = {4, 16, 256};
+  NSUInteger depths[] = {2, 30};
+  for (int adaptive = 0; adaptive < 2; ++adaptive) {
+    for (int c = 0; c < 3; ++c) {
+      for (int d = 0; d < 2; ++d) {
+        GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithBounds:(GQTBounds){-1, -1, 1, 1}
+                                                             leafCapacity:capacities[c]
+                                                                 maxDepth:depths[d]
+                                                                 adaptive:adaptive
+                                                          keepsAggregates:NO];
+        [tree addItems:items];
+        [tree addItems:coincidentItems];
+        XCTAssertEqual(tree.count, 800);
+        XCTAssertEqual([tree searchWithBounds:(GQTBounds){-1, -1, 1, 1}].count, 800);
+        XCTAssertEqual([tree searchWithBounds:(GQTBounds){0.25, 0.25, 0.25, 0.25}].count, 300);
+
+        for (int i = 0; i < 300; i += 2) {
+          XCTAssertTrue([tree remove:coincidentItems[i]]);
+        }
+        for (id item in items) {
+          XCTAssertTrue([tree remove:item]);
+        }
+        XCTAssertEqual(tree.count, 150);
+        XCTAssertEqual([tree searchWithBounds:(GQTBounds){0, 0, 0.5, 0.5}].count, 150);
+      }
+    }
+  }
+}
+
+- (void)testInitWithBoundsItems {
+  NSMutableArray *items = [NSMutableArray array];
+  [items addObjectsFromArray:[self itemsFullyInside:(GQTBounds){-1, -1, 0, 0} count:100]];
+  [items addObjectsFromArray:[self itemsFullyInside:(GQTBounds){0, 0, 1, 1} count:300]];
+  [items addObject:[self itemAtPoint:(GQTPoint){1.5, 1.5}]];
+
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithBounds:(GQTBounds){-1, -1, 1, 1}
+                                                               items:items];
+
+  XCTAssertEqual(tree.count, 400);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){-1, -1, 0, 0}].count, 100);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){0, 0, 1, 1}].count, 300);
+  XCTAssertTrue([tree remove:items[0]]);
+  XCTAssertEqual(tree.count, 399);
+}
+
+- (void)testAddItems {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 0, 0} count:200];
+  XCTAssertEqual([tree addItems:items], 200);
+
+  // Smaller than the tree, inserted one by one.
+  XCTAssertEqual([tree addItems:[self itemsFullyInside:(GQTBounds){0, 0, 1, 1} count:50]], 50);
+  // Larger than the tree, rebuilds it.
+  XCTAssertEqual([tree addItems:[self itemsFullyInside:(GQTBounds){0, -1, 1, 0} count:300]], 300);
+
+  XCTAssertEqual(tree.count, 550);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){-1, -1, 0, 0}].count, 200);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){0, 0, 1, 1}].count, 50);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){0, -1, 1, 0}].count, 300);
+  for (id item in items) {
+    XCTAssertTrue([tree remove:item]);
+  }
+  XCTAssertEqual(tree.count, 350);
+}
+
+- (void)testRemoveItemWithHandle {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  GQTPointQuadTreeHandle *handles = malloc(items.count * sizeof(GQTPointQuadTreeHandle));
+  XCTAssertEqual([tree addItems:items handles:handles], 500);
+  GQTPointQuadTreeHandle extraHandle =
+      [tree addReturningHandle:[self itemAtPoint:(GQTPoint){0.5, 0.5}]];
+  XCTAssertEqual([tree addReturningHandle:[self itemAtPoint:(GQTPoint){2, 2}]],
+                 kGQTPointQuadTreeInvalidHandle);
+
+  GQTPointQuadTree *snapshot = [tree copy];
+  for (NSUInteger i = 0; i < 490; ++i) {
+    XCTAssertTrue([tree removeItemWithHandle:handles[i]]);
+  }
+  XCTAssertFalse([tree removeItemWithHandle:handles[0]]);
+  XCTAssertFalse([tree removeItemWithHandle:kGQTPointQuadTreeInvalidHandle]);
+  XCTAssertEqual(tree.count, 11);
+  XCTAssertEqual([tree searchWithBounds:(GQTBounds){-1, -1, 1, 1}].count, 11);
+  XCTAssertEqual(snapshot.count, 501);
+
+  // Handles remain valid in copies made after the items were added.
+  XCTAssertTrue([snapshot removeItemWithHandle:handles[0]]);
+  XCTAssertTrue([snapshot removeItemWithHandle:extraHandle]);
+  XCTAssertEqual(snapshot.count, 499);
+
+  [tree clear];
+  [tree add:[self itemAtPoint:(GQTPoint){0, 0}]];
+  XCTAssertFalse([tree removeItemWithHandle:extraHandle]);
+  XCTAssertEqual(tree.count, 1);
+  free(handles);
+}
+
+- (void)testEnumerateItemsInBounds {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  for (id item in [self itemsFullyInside:(GQTBounds){-1, -1, 0, 0} count:100]) {
+    [tree add:item];
+  }
+  for (id item in [self itemsFullyInside:(GQTBounds){0, 0, 1, 1} count:50]) {
+    [tree add:item];
+  }
+
+  __block NSUInteger count = 0;
+  [tree enumerateItemsInBounds:(GQTBounds){0, 0, 1, 1}
+                    usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint point, BOOL *stop) {
+                      XCTAssertEqual(point.x, item.point.x);
+                      XCTAssertEqual(point.y, item.point.y);
+                      ++count;
+                    }];
+  XCTAssertEqual(count, 50);
+
+  count = 0;
+  [tree enumerateItemsInBounds:(GQTBounds){-1, -1, 1, 1}
+                    usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint point, BOOL *stop) {
+                      *stop = ++count == 10;
+                    }];
+  XCTAssertEqual(count, 10);
+}
+
+- (void)testCountInBounds {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  for (id item in [self itemsFullyInside:(GQTBounds){-1, -1, 0, 0} count:100]) {
+    [tree add:item];
+  }
+  for (id item in [self itemsFullyInside:(GQTBounds){0, 0, 1, 1} count:50]) {
+    [tree add:item];
+  }
+
+  XCTAssertEqual([tree countInBounds:(GQTBounds){-1, -1, 1, 1}], 150);
+  XCTAssertEqual([tree countInBounds:(GQTBounds){-1, -1, 0, 0}], 100);
+  XCTAssertEqual([tree countInBounds:(GQTBounds){0, 0, 1, 1}], 50);
+  XCTAssertEqual([tree countInBounds:(GQTBounds){0, -1, 1, 0}], 0);
+  XCTAssertEqual([tree countInBounds:(GQTBounds){-0.5, -0.5, 0.5, 0.5}],
+                 [tree searchWithBounds:(GQTBounds){-0.5, -0.5, 0.5, 0.5}].count);
+}
+
+- (void)testWriteToURLAndLoad {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  GQTPointQuadTreeHandle *handles = malloc(items.count * sizeof(GQTPointQuadTreeHandle));
+  [tree addItems:items handles:handles];
+  XCTAssertTrue([tree removeItemWithHandle:handles[0]]);
+  NSURL *url = [NSURL fileURLWithPath:[NSTemporaryDirectory()
+                                          stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+
+  NSError *error = nil;
+  XCTAssertTrue([tree writeToURL:url
+               identifierForItem:^uint64_t(id<GQTPointQuadTreeItem> item) {
+                 return [items indexOfObjectIdenticalTo:item];
+               }
+                           error:&error]);
+  XCTAssertNil(error);
+  id<GQTPointQuadTreeItem> (^itemForIdentifier)(uint64_t) = ^(uint64_t identifier) {
+    return (id<GQTPointQuadTreeItem>)items[identifier];
+  };
+  GQTPointQuadTree *loadedTree = [[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                                               itemForIdentifier:itemForIdentifier
+                                                                           error:&error];
+  XCTAssertNotNil(loadedTree);
+  XCTAssertNil(error);
+
+  XCTAssertEqual(loadedTree.count, 499);
+  GQTBounds bounds = {-0.5, -0.5, 0.5, 0.5};
+  XCTAssertEqualObjects([loadedTree searchWithBounds:bounds], [tree searchWithBounds:bounds]);
+  XCTAssertEqual([loadedTree nearestItemToPoint:(GQTPoint){0, 0}],
+                 [tree nearestItemToPoint:(GQTPoint){0, 0}]);
+
+  // The loaded tree is mutated through a copy of the mapped file, in which handles remain valid.
+  GQTPointQuadTree *snapshot = [loadedTree copy];
+  XCTAssertTrue([loadedTree removeItemWithHandle:handles[1]]);
+  XCTAssertFalse([loadedTree removeItemWithHandle:handles[0]]);
+  XCTAssertTrue([loadedTree add:[self itemAtPoint:(GQTPoint){0, 0}]]);
+  XCTAssertEqual(loadedTree.count, 499);
+  XCTAssertEqual([loadedTree searchWithBounds:(GQTBounds){-1, -1, 1, 1}].count, 499);
+  XCTAssertEqual(snapshot.count, 499);
+  XCTAssertTrue([[snapshot searchWithBounds:(GQTBounds){-1, -1, 1, 1}] containsObject:items[1]]);
+
+  [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+  free(handles);
+}
+
+- (void)testLoadInvalidFile {
+  NSURL *url = [NSURL fileURLWithPath:[NSTemporaryDirectory()
+                                          stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+  id<GQTPointQuadTreeItem> (^itemForIdentifier)(uint64_t) = ^id<GQTPointQuadTreeItem>(
+      uint64_t identifier) {
+    return nil;
+  };
+  NSError *error = nil;
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                                         itemForIdentifier:itemForIdentifier
+                                                                     error:&error];
+  XCTAssertNil(tree);
+  XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+  XCTAssertEqual(error.code, ENOENT);
+
+  [[NSMutableData dataWithLength:1024] writeToURL:url atomically:YES];
+  error = nil;
+  tree = [[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                       itemForIdentifier:itemForIdentifier
+                                                   error:&error];
+  XCTAssertNil(tree);
+  XCTAssertEqual(error.code, EINVAL);
+  [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+}
+
+- (void)testLoadTruncatedAndCorruptedFiles {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  for (id<GQTPointQuadTreeItem> item in items) {
+    XCTAssertTrue([tree add:item]);
+  }
+  NSURL *url = [NSURL fileURLWithPath:[NSTemporaryDirectory()
+                                          stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+  XCTAssertTrue([tree writeToURL:url
+               identifierForItem:^uint64_t(id<GQTPointQuadTreeItem> item) {
+                 return [items indexOfObjectIdenticalTo:item];
+               }
+                           error:nil]);
+  NSData *data = [NSData dataWithContentsOfURL:url];
+  id<GQTPointQuadTreeItem> (^itemForIdentifier)(uint64_t) = ^(uint64_t identifier) {
+    return (id<GQTPointQuadTreeItem>)items[identifier];
+  };
+  NSError * (^errorLoadingData)(NSData *) = ^(NSData *fileData) {
+    [fileData writeToURL:url atomically:YES];
+    NSError *error = nil;
+    GQTPointQuadTree *loadedTree = [[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                                                 itemForIdentifier:itemForIdentifier
+                                                                             error:&error];
+    XCTAssertNil(loadedTree);
+    return error;
+  };
+
+  // A truncated file.
+  NSError *error = errorLoadingData([data subdataWithRange:NSMakeRange(0, data.length - 8)]);
+  XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+  XCTAssertEqual(error.code, EINVAL);
+
+  // The root node follows the 88 byte header, starting with the index of its first child and
+  // ending with its count of items.
+  NSMutableData *corruptedData = [data mutableCopy];
+  uint32_t children = 0x7fffffff;
+  [corruptedData replaceBytesInRange:NSMakeRange(88, sizeof(children)) withBytes:&children];
+  error = errorLoadingData(corruptedData);
+  XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+  XCTAssertEqual(error.code, EINVAL);
+
+  corruptedData = [data mutableCopy];
+  uint32_t count = 499;
+  [corruptedData replaceBytesInRange:NSMakeRange(88 + 12, sizeof(count)) withBytes:&count];
+  error = errorLoadingData(corruptedData);
+  XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+  XCTAssertEqual(error.code, EINVAL);
+
+  // The intact file still loads.
+  [data writeToURL:url atomically:YES];
+  XCTAssertEqual([[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                              itemForIdentifier:itemForIdentifier
+                                                          error:nil]
+                     .count,
+                 500);
+  [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+}
+
+- (void)testLoadFileWithOrphanedBlock {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  for (id<GQTPointQuadTreeItem> item in items) {
+    XCTAssertTrue([tree add:item]);
+  }
+  // Merging leaves puts their point blocks on the free list.
+  for (NSUInteger i = 0; i < items.count; i += 2) {
+    XCTAssertTrue([tree remove:items[i]]);
+  }
+  NSURL *url = [NSURL fileURLWithPath:[NSTemporaryDirectory()
+                                          stringByAppendingPathComponent:[NSUUID UUID].UUIDString]];
+  XCTAssertTrue([tree writeToURL:url
+               identifierForItem:^uint64_t(id<GQTPointQuadTreeItem> item) {
+                 return [items indexOfObjectIdenticalTo:item];
+               }
+                           error:nil]);
+
+  // The head of the free block list is at offset 36 of the header. Emptying the list leaves its
+  // blocks in neither the tree nor the list.
+  NSMutableData *data = [NSMutableData dataWithContentsOfURL:url];
+  uint32_t freeBlock;
+  [data getBytes:&freeBlock range:NSMakeRange(36, sizeof(freeBlock))];
+  XCTAssertNotEqual(freeBlock, UINT32_MAX);
+  freeBlock = UINT32_MAX;
+  [data replaceBytesInRange:NSMakeRange(36, sizeof(freeBlock)) withBytes:&freeBlock];
+  [data writeToURL:url atomically:YES];
+  NSError *error = nil;
+  GQTPointQuadTree *loadedTree =
+      [[GQTPointQuadTree alloc] initWithContentsOfURL:url
+                                    itemForIdentifier:^(uint64_t identifier) {
+                                      return (id<GQTPointQuadTreeItem>)items[identifier];
+                                    }
+                                                error:&error];
+
+  XCTAssertNil(loadedTree);
+  XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+  XCTAssertEqual(error.code, EINVAL);
+  [[NSFileManager defaultManager] removeItemAtURL:url error:nil];
+}
+
+- (void)testSearchWithBoundsArray {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  [tree addItems:[self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500]];
+  // Enough boxes for the batch to be searched concurrently.
+  NSUInteger count = 200;
+  GQTBounds *boundsArray = malloc(count * sizeof(GQTBounds));
+  for (NSUInteger i = 0; i < count; ++i) {
+    double x = randd(-1, 0.8);
+    double y = randd(-1, 0.8);
+    boundsArray[i] = (GQTBounds){x, y, x + 0.2, y + 0.2};
+  }
+  boundsArray[0] = (GQTBounds){2, 2, 3, 3};
+
+  NSArray<NSArray *> *results = [tree searchWithBoundsArray:boundsArray count:count];
+  NSUInteger *counts = malloc(count * sizeof(NSUInteger));
+  [tree countInBoundsArray:boundsArray count:count counts:counts];
+
+  XCTAssertEqual(results.count, count);
+  XCTAssertEqual(results[0].count, 0);
+  for (NSUInteger i = 0; i < count; ++i) {
+    XCTAssertEqualObjects(results[i], [tree searchWithBounds:boundsArray[i]]);
+    XCTAssertEqual(counts[i], results[i].count);
+  }
+  XCTAssertEqual([tree searchWithBoundsArray:boundsArray count:0].count, 0);
+  free(counts);
+  free(boundsArray);
+}
+
+- (void)testEnumerateItemsInWrappedBounds {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  id<GQTPointQuadTreeItem> westItem = [self itemAtPoint:(GQTPoint){-0.95, 0}];
+  id<GQTPointQuadTreeItem> eastItem = [self itemAtPoint:(GQTPoint){0.95, 0}];
+  [tree add:westItem];
+  [tree add:eastItem];
+  [tree add:[self itemAtPoint:(GQTPoint){0, 0}]];
+
+  // Bounds past the east edge find the west item shifted by a whole tree width.
+  NSMutableArray *items = [NSMutableArray array];
+  [tree enumerateItemsInWrappedBounds:(GQTBounds){0.9, -0.1, 1.1, 0.1}
+                           usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                        double offsetX, BOOL *stop) {
+                             XCTAssertEqualWithAccuracy(point.x, [item point].x + offsetX, 1e-12);
+                             XCTAssertEqualWithAccuracy(offsetX, item == westItem ? 2 : 0, 1e-12);
+                             [items addObject:item];
+                           }];
+  XCTAssertEqual(items.count, 2);
+  XCTAssertTrue([items containsObject:westItem]);
+  XCTAssertTrue([items containsObject:eastItem]);
+  XCTAssertEqual([tree countInWrappedBounds:(GQTBounds){0.9, -0.1, 1.1, 0.1}], 2);
+
+  // Bounds past both edges search both neighbouring copies of the tree.
+  XCTAssertEqual([tree countInWrappedBounds:(GQTBounds){-1.1, -0.1, 1.1, 0.1}], 5);
+  XCTAssertEqual([tree countInWrappedBounds:(GQTBounds){-0.5, -0.1, 0.5, 0.1}],
+                 [tree countInBounds:(GQTBounds){-0.5, -0.1, 0.5, 0.1}]);
+  XCTAssertEqual([tree countInWrappedBounds:(GQTBounds){0.9, 0.5, 1.1, 0.6}], 0);
+}
+
+- (void)testEnumerateItemsInWrappedBoundsUsingFunction {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  [tree addItems:[self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500]];
+  GQTBounds bounds = {0.5, -0.5, 1.5, 0.5};
+
+  NSMutableArray *expected = [NSMutableArray array];
+  [tree enumerateItemsInWrappedBounds:bounds
+                           usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint point,
+                                        double offsetX, BOOL *stop) {
+                             [expected addObject:@[ item, @(offsetX) ]];
+                           }];
+  NSMutableArray *results = [NSMutableArray array];
+  [tree enumerateItemsInWrappedBounds:bounds
+                        usingFunction:GQTAddItemAndOffset
+                              context:(__bridge void *)results];
+
+  XCTAssertGreaterThan(results.count, 0);
+  XCTAssertEqualObjects(results, expected);
+}
+
+- (void)testSearchWithCenterRadius {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:500];
+  [tree addItems:items];
+  GQTPoint center = {0.2, -0.1};
+  double radius = 0.6;
+
+  NSMutableSet *expected = [NSMutableSet set];
+  for (id<GQTPointQuadTreeItem> item in items) {
+    GQTPoint point = [item point];
+    double dx = point.x - center.x;
+    double dy = point.y - center.y;
+    if (dx * dx + dy * dy <= radius * radius) {
+      [expected addObject:item];
+    }
+  }
+  XCTAssertGreaterThan(expected.count, 0);
+  XCTAssertEqualObjects([NSSet setWithArray:[tree searchWithCenter:center radius:radius]],
+                        expected);
+  XCTAssertEqual([tree searchWithCenter:center radius:3].count, 500);
+  XCTAssertEqual([tree searchWithCenter:(GQTPoint){5, 5} radius:1].count, 0);
+
+  // Items exactly on the circle are included.
+  GQTPointQuadTree *edgeTree = [[GQTPointQuadTree alloc] init];
+  [edgeTree add:[self itemAtPoint:(GQTPoint){0.5, 0}]];
+  XCTAssertEqual([edgeTree searchWithCenter:(GQTPoint){0, 0} radius:0.5].count, 1);
+}
+
+- (void)testSearchWithPolygon {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  for (id item in [self itemsFullyInside:(GQTBounds){-1, -1, 0, 0} count:100]) {
+    [tree add:item];
+  }
+  for (id item in [self itemsFullyInside:(GQTBounds){0, 0, 1, 1} count:50]) {
+    [tree add:item];
+  }
+
+  // An L shaped polygon covering every quadrant but the top right one.
+  GQTPoint lShape[] = {{-1, -1}, {1, -1}, {1, 0}, {0, 0}, {0, 1}, {-1, 1}};
+  XCTAssertEqual([tree searchWithPolygon:lShape count:6].count, 100);
+
+  // A triangle below the diagonal of the top right quadrant.
+  GQTPoint triangle[] = {{0, 0}, {1, 0}, {1, 1}};
+  NSUInteger expected = 0;
+  for (id<GQTPointQuadTreeItem> item in [tree searchWithBounds:(GQTBounds){0, 0, 1, 1}]) {
+    if ([item point].y < [item point].x) ++expected;
+  }
+  XCTAssertEqual([tree searchWithPolygon:triangle count:3].count, expected);
+
+  // Polygons need at least 3 vertices.
+  XCTAssertEqual([tree searchWithPolygon:lShape count:2].count, 0);
+
+  __block NSUInteger count = 0;
+  [tree enumerateItemsInPolygon:lShape
+                          count:6
+                     usingBlock:^(id<GQTPointQuadTreeItem> item, GQTPoint point, BOOL *stop) {
+                       *stop = ++count == 10;
+                     }];
+  XCTAssertEqual(count, 10);
+}
+
+- (void)testEnumerateAggregatesInBounds {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] initWithBounds:(GQTBounds){-1, -1, 1, 1}
+                                                    keepsAggregates:YES];
+  XCTAssertTrue(tree.keepsAggregates);
+  id<GQTPointQuadTreeItem> removedItem = [self itemAtPoint:(GQTPoint){0.5, 0.5} weight:3];
+  [tree add:removedItem];
+  for (NSUInteger i = 0; i < 100; ++i) {
+    // 100 items of weight 1 in the bottom left quad and 100 of weight 2 in the top right quad.
+    [tree add:[self itemAtPoint:(GQTPoint){-0.25 - i * 0.005, -0.5} weight:1]];
+    [tree add:[self itemAtPoint:(GQTPoint){0.25 + i * 0.005, 0.25} weight:2]];
+  }
+
+  __block NSUInteger aggregateCount = 0;
+  [tree enumerateAggregatesInBounds:(GQTBounds){-1, -1, 1, 1}
+                              depth:0
+                         usingBlock:^(GQTAggregate aggregate, BOOL *stop) {
+                           ++aggregateCount;
+                           XCTAssertEqual(aggregate.count, 201);
+                           XCTAssertEqualWithAccuracy(aggregate.weight, 303, 1e-9);
+                         }];
+  XCTAssertEqual(aggregateCount, 1);
+
+  [tree remove:removedItem];
+  NSMutableArray<NSValue *> *aggregates = [NSMutableArray array];
+  [tree enumerateAggregatesInBounds:(GQTBounds){-1, -1, 1, 1}
+                              depth:1
+                         usingBlock:^(GQTAggregate aggregate, BOOL *stop) {
+                           [aggregates addObject:[NSValue valueWithBytes:&aggregate
+                                                               objCType:@encode(GQTAggregate)]];
+                         }];
+  XCTAssertEqual(aggregates.count, 2);
+  GQTAggregate bottomLeft, topRight;
+  [aggregates[0] getValue:&bottomLeft];
+  [aggregates[1] getValue:&topRight];
+  XCTAssertEqual(bottomLeft.count, 100);
+  XCTAssertEqualWithAccuracy(bottomLeft.weight, 100, 1e-9);
+  XCTAssertEqualWithAccuracy(bottomLeft.centroid.x, -0.4975, 1e-9);
+  XCTAssertEqualWithAccuracy(bottomLeft.centroid.y, -0.5, 1e-9);
+  XCTAssertEqualWithAccuracy(bottomLeft.bounds.minX, -0.745, 1e-9);
+  XCTAssertEqualWithAccuracy(bottomLeft.bounds.maxX, -0.25, 1e-9);
+  XCTAssertEqual(topRight.count, 100);
+  XCTAssertEqualWithAccuracy(topRight.weight, 200, 1e-9);
+  XCTAssertEqualWithAccuracy(topRight.centroid.x, 0.4975, 1e-9);
+
+  // Only the quads intersecting the search bounds are reported.
+  aggregateCount = 0;
+  [tree enumerateAggregatesInBounds:(GQTBounds){0.1, 0.1, 0.2, 0.2}
+                              depth:1
+                         usingBlock:^(GQTAggregate aggregate, BOOL *stop) {
+                           ++aggregateCount;
+                           XCTAssertEqual(aggregate.count, 100);
+                         }];
+  XCTAssertEqual(aggregateCount, 1);
+
+  // Deeper quads split the items further without losing any.
+  __block NSUInteger itemCount = 0;
+  aggregateCount = 0;
+  [tree enumerateAggregatesInBounds:(GQTBounds){-1, -1, 1, 1}
+                              depth:6
+                         usingBlock:^(GQTAggregate aggregate, BOOL *stop) {
+                           ++aggregateCount;
+                           itemCount += aggregate.count;
+                         }];
+  XCTAssertEqual(itemCount, 200);
+  XCTAssertGreaterThan(aggregateCount, 2);
+}
+
+- (void)testEnumerateAggregatesWithoutAggregates {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  XCTAssertFalse(tree.keepsAggregates);
+  [tree add:[self itemAtPoint:(GQTPoint){0.5, 0.5}]];
+  [tree enumerateAggregatesInBounds:(GQTBounds){-1, -1, 1, 1}
+                              depth:0
+                         usingBlock:^(GQTAggregate aggregate, BOOL *stop) {
+                           XCTFail(@"Trees without aggregates report none");
+                         }];
+}
+
+- (void)testNearestItemToPoint {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  XCTAssertNil([tree nearestItemToPoint:(GQTPoint){0, 0}]);
+
+  id<GQTPointQuadTreeItem> item1 = [self itemAtPoint:(GQTPoint){0.5, 0.5}];
+  id<GQTPointQuadTreeItem> item2 = [self itemAtPoint:(GQTPoint){-0.5, 0.5}];
+  [tree add:item1];
+  [tree add:item2];
+  for (id item in [self itemsFullyInside:(GQTBounds){-1, -1, 1, -0.5} count:200]) {
+    [tree add:item];
+  }
+
+  XCTAssertEqual([tree nearestItemToPoint:(GQTPoint){0.4, 0.6}], item1);
+  XCTAssertEqual([tree nearestItemToPoint:(GQTPoint){-0.9, 0.9}], item2);
+  XCTAssertNil([tree nearestItemToPoint:(GQTPoint){0, 0.5} maximumDistance:0.4]);
+  XCTAssertNotNil([tree nearestItemToPoint:(GQTPoint){0, 0.5} maximumDistance:0.6]);
+}
+
+- (void)testNearestItemsToPoint {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSMutableArray *expected = [NSMutableArray array];
+  for (int i = 1; i <= 100; ++i) {
+    id<GQTPointQuadTreeItem> item = [self itemAtPoint:(GQTPoint){i / 100.0, 0}];
+    [expected addObject:item];
+    [tree add:item];
+  }
+
+  NSArray *items = [tree nearestItems:5 toPoint:(GQTPoint){0, 0}];
+  XCTAssertEqualObjects(items, [expected subarrayWithRange:NSMakeRange(0, 5)]);
+
+  items = [tree nearestItems:50 toPoint:(GQTPoint){0, 0} maximumDistance:0.1];
+  XCTAssertEqualObjects(items, [expected subarrayWithRange:NSMakeRange(0, 10)]);
+
+  items = [tree nearestItems:1000 toPoint:(GQTPoint){2, 0}];
+  XCTAssertEqual(items.count, 100);
+  XCTAssertEqual(items.firstObject, expected.lastObject);
+}
+
+- (void)testCopyIsSnapshot {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSArray *items = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:200];
+  for (id item in items) {
+    [tree add:item];
+  }
+
+  GQTPointQuadTree *snapshot = [tree copy];
+  XCTAssertEqual(snapshot.count, 200);
+
+  for (NSUInteger i = 0; i < 100; ++i) {
+    [tree remove:items[i]];
+  }
+  [tree add:[self itemAtPoint:(GQTPoint){0.5, 0.5}]];
+  XCTAssertEqual(tree.count, 101);
+  XCTAssertEqual(snapshot.count, 200);
+  XCTAssertEqual([snapshot searchWithBounds:(GQTBounds){-1, -1, 1, 1}].count, 200);
+
+  [tree clear];
+  XCTAssertEqual(tree.count, 0);
+  XCTAssertEqual([snapshot countInBounds:(GQTBounds){-1, -1, 1, 1}], 200);
+
+  // Mutating the snapshot leaves the original alone as well.
+  GQTPointQuadTree *copy = [snapshot copy];
+  [copy remove:items[0]];
+  XCTAssertEqual(copy.count, 199);
+  XCTAssertEqual(snapshot.count, 200);
+}
+
+- (void)testCopyKeepsItemsAliveAfterTheOriginalReleasesThem {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  NSPointerArray *weakItems = [NSPointerArray weakObjectsPointerArray];
+  GQTPointQuadTree *snapshot;
+  @autoreleasepool {
+    for (NSUInteger i = 0; i < 1000; ++i) {
+      GQTPointQuadTreeTestItem *item = [[GQTPointQuadTreeTestItem alloc] init];
+      item.point = (GQTPoint){randd(-0.9, 0.9), randd(-0.9, 0.9)};
+      [tree add:item];
+      [weakItems addPointer:(__bridge void *)item];
+    }
+    snapshot = [tree copy];
+
+    // Removing an item only duplicates the page of its slot, and clearing drops all pages.
+    [tree remove:(__bridge id)[weakItems pointerAtIndex:0]];
+    XCTAssertEqual(snapshot.count, 1000);
+    [tree clear];
+  }
+
+  @autoreleasepool {
+    XCTAssertEqual([snapshot searchWithBounds:(GQTBounds){-1, -1, 1, 1}].count, 1000);
+    for (NSUInteger i = 0; i < weakItems.count; ++i) {
+      XCTAssertNotNil((__bridge id)[weakItems pointerAtIndex:i]);
+    }
+  }
+
+  snapshot = nil;
+  for (NSUInteger i = 0; i < weakItems.count; ++i) {
+    XCTAssertNil((__bridge id)[weakItems pointerAtIndex:i]);
+  }
+}
+
+- (void)testCopyConcurrentSearches {
+  GQTPointQuadTree *tree = [[GQTPointQuadTree alloc] init];
+  for (id item in [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:1000]) {
+    [tree add:item];
+  }
+  GQTPointQuadTree *snapshot = [tree copy];
+  NSArray *newItems = [self itemsFullyInside:(GQTBounds){-1, -1, 1, 1} count:1000];
+
+  dispatch_group_t group = dispatch_group_create();
+  dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+      for (NSUInteger j = 0; j < 100; ++j) {
+        XCTAssertEqual([snapshot countInBounds:(GQTBounds){-1, -1, 1, 1}], 1000);
+      }
+    });
+  });
+  for (id item in newItems) {
+    [tree add:item];
+  }
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+  XCTAssertEqual(tree.count, 2000);
+  XCTAssertEqual(snapshot.count, 1000);
+}
+
 #pragma mark Utilities
 
 - (NSArray *)itemsFullyInside:(GQTBounds)bounds count:(NSUInteger)count {
@@ -80,6 +80,45 @@ class GMUHeatmapTileLayerTest: XCTestCase {
     XCTAssertEqual(maximumZoomIntensity, heatmapTileLayer.maximumZoomIntensity)
   }
   
+  func testMaxValueForZoomMatchesExactBuckets() {
+    // Points are clustered around a few centers, so that buckets hold several of them.
+    var state: UInt64 = 42
+    func random() -> Double {
+      state = state &* 6364136223846793005 &+ 1442695040888963407
+      return Double(state >> 11) / Double(1 << 53)
+    }
+    var weightedData: [GMUWeightedLatLng] = []
+    for _ in 0..<5000 {
+      let center = Double(Int(random() * 4))
+      let coordinate = CLLocationCoordinate2D(latitude: -33.8 + center + random() * 0.05,
+                                              longitude: 151.2 + center + random() * 0.05)
+      weightedData.append(GMUWeightedLatLng(coordinate: coordinate, intensity: Float(1 + random() * 9)))
+    }
+    let heatmapTileLayer = GMUHeatmapTileLayer()
+    heatmapTileLayer.weightedData = weightedData
+    // A radius of 20 points makes bucket sizes which are not powers of two.
+    heatmapTileLayer.radius = 20
+    heatmapTileLayer.map = nil
+
+    for zoom: UInt in [3, 5, 7, 10] {
+      // Buckets of the exact size, as the layer computed them point by point before.
+      let bucketSize = 20.0 / 128.0 / pow(2, Double(zoom)) * 0.5
+      var buckets: [Int: [Int: Float]] = [:]
+      var expectedMax: Float = 0
+      for dataPoint in weightedData {
+        let point = dataPoint.point()
+        let xBucket = Int((point.x + 1) / bucketSize)
+        let yBucket = Int((point.y + 1) / bucketSize)
+        let value = (buckets[xBucket]?[yBucket] ?? 0) + dataPoint.intensity
+        buckets[xBucket, default: [:]][yBucket] = value
+        expectedMax = max(expectedMax, value)
+      }
+
+      let maxValue = heatmapTileLayer.maxValue(forZoom: zoom).floatValue
+      XCTAssertEqual(maxValue, expectedMax, accuracy: expectedMax * 1e-4)
+    }
+  }
+
   func testTileLayerForMinXLessThanMinusOneWithNotNilUIImage() {
     let heatmapTileLayer = GMUHeatmapTileLayer()
     XCTAssertNotNil(heatmapTileLayer.tileFor(x: UInt(0.1), y: UInt(0.1), zoom: 0))
@@ -22,6 +22,8 @@
 @property(nonatomic, readonly) CLLocationCoordinate2D position;
 @property(nonatomic, copy, nullable) NSString *title;
 @property(nonatomic, copy, nullable) NSString *snippet;
+@property(nonatomic, copy, nullable) NSString *clusterCategory;
+@property(nonatomic, copy, nullable) NSNumber *weight;
 
 - (instancetype _Nonnull)initWithPosition:(CLLocationCoordinate2D)position;
 - (instancetype _Nonnull)initWithPosition:(CLLocationCoordinate2D)position title:(nullable NSString *)title snippet:(nullable NSString *)snippet;